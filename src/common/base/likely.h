@@ -0,0 +1,23 @@
+// Copyright (c) 2015, Baidu.com, Inc. All Rights Reserved
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef TERA_COMMON_BASE_LIKELY_H_
+#define TERA_COMMON_BASE_LIKELY_H_
+
+/// branch-prediction hints for conditions that are almost always true
+/// (or false) in steady state, e.g. rpc failure checks; the compiler
+/// lays out the expected path fall-through and keeps the cold branch
+/// out of the hot instruction stream.
+///
+/// example:
+///   if (TERA_UNLIKELY(!client.Call(&req, &resp))) { ... error ... }
+#ifdef __GNUC__
+# define TERA_LIKELY(x)   __builtin_expect(!!(x), 1)
+# define TERA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+# define TERA_LIKELY(x)   (x)
+# define TERA_UNLIKELY(x) (x)
+#endif
+
+#endif // TERA_COMMON_BASE_LIKELY_H_
@@ -101,6 +101,82 @@ private:
     int64_t lock_time_;
 };
 
+// A RWMutex allows concurrent readers or one exclusive writer.
+// Writers are preferred so a stream of readers cannot starve updates.
+class RWMutex {
+public:
+    RWMutex() : writer_(0) {
+        pthread_rwlockattr_t attr;
+        PthreadCall("init rwlockattr", pthread_rwlockattr_init(&attr));
+        PthreadCall("set rwlockattr",
+                    pthread_rwlockattr_setkind_np(&attr,
+                        PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP));
+        PthreadCall("init rwlock", pthread_rwlock_init(&mu_, &attr));
+        PthreadCall("destroy rwlockattr", pthread_rwlockattr_destroy(&attr));
+    }
+    ~RWMutex() {
+        PthreadCall("destroy rwlock", pthread_rwlock_destroy(&mu_));
+    }
+    // Acquire the lock in shared (read) mode.
+    void ReadLock() {
+        PthreadCall("rwlock rdlock", pthread_rwlock_rdlock(&mu_));
+    }
+    // Acquire the lock in exclusive (write) mode.
+    void Lock() {
+        PthreadCall("rwlock wrlock", pthread_rwlock_wrlock(&mu_));
+        writer_ = pthread_self();
+    }
+    // Release the lock, whichever mode it was acquired in.
+    void Unlock() {
+        if (0 != pthread_equal(writer_, pthread_self())) {
+            writer_ = 0;
+        }
+        PthreadCall("rwlock unlock", pthread_rwlock_unlock(&mu_));
+    }
+    // Crash if this thread does not hold this lock in write mode.
+    void AssertHeld() {
+        if (0 == pthread_equal(writer_, pthread_self())) {
+            abort();
+        }
+    }
+
+private:
+    RWMutex(const RWMutex&);
+    void operator=(const RWMutex&);
+    pthread_rwlock_t mu_;
+    pthread_t writer_;
+};
+
+// RWMutex read-side guard
+class ReaderMutexLock {
+public:
+    explicit ReaderMutexLock(RWMutex* mu) : mu_(mu) {
+        mu_->ReadLock();
+    }
+    ~ReaderMutexLock() {
+        mu_->Unlock();
+    }
+private:
+    RWMutex* const mu_;
+    ReaderMutexLock(const ReaderMutexLock&);
+    void operator=(const ReaderMutexLock&);
+};
+
+// RWMutex write-side guard
+class WriterMutexLock {
+public:
+    explicit WriterMutexLock(RWMutex* mu) : mu_(mu) {
+        mu_->Lock();
+    }
+    ~WriterMutexLock() {
+        mu_->Unlock();
+    }
+private:
+    RWMutex* const mu_;
+    WriterMutexLock(const WriterMutexLock&);
+    void operator=(const WriterMutexLock&);
+};
+
 // Mutex lock guard
 class MutexLock {
 public:
@@ -168,6 +244,9 @@ private:
 
 using common::Mutex;
 using common::MutexLock;
+using common::RWMutex;
+using common::ReaderMutexLock;
+using common::WriterMutexLock;
 using common::CondVar;
 
 #endif  // TERA_COMMON_MUTEX_H_
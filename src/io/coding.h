@@ -34,21 +34,42 @@ inline void PutFixed64(std::string* dst, uint64_t value) {
     dst->append(buf, sizeof(buf));
 }
 
+// 小端机器上用bswap一条指令完成字节序翻转, 其余平台退回逐字节版本
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TERA_IO_CODING_USE_BSWAP 1
+#endif
+
 inline void EncodeBigEndian32(char* buf, uint32_t value) {
+#ifdef TERA_IO_CODING_USE_BSWAP
+    value = __builtin_bswap32(value);
+    memcpy(buf, &value, sizeof(value));
+#else
     buf[0] = (value >> 24) & 0xff;
     buf[1] = (value >> 16) & 0xff;
     buf[2] = (value >> 8) & 0xff;
     buf[3] = value & 0xff;
+#endif
 }
 
 inline uint32_t DecodeBigEndain32(const char* ptr) {
+#ifdef TERA_IO_CODING_USE_BSWAP
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return __builtin_bswap32(value);
+#else
     return ((static_cast<uint32_t>(static_cast<unsigned char>(ptr[3])))
         | (static_cast<uint32_t>(static_cast<unsigned char>(ptr[2])) << 8)
         | (static_cast<uint32_t>(static_cast<unsigned char>(ptr[1])) << 16)
         | (static_cast<uint32_t>(static_cast<unsigned char>(ptr[0])) << 24));
+#endif
 }
 
 inline void EncodeBigEndian(char* buf, uint64_t value) {
+#ifdef TERA_IO_CODING_USE_BSWAP
+    value = __builtin_bswap64(value);
+    memcpy(buf, &value, sizeof(value));
+#else
     buf[0] = (value >> 56) & 0xff;
     buf[1] = (value >> 48) & 0xff;
     buf[2] = (value >> 40) & 0xff;
@@ -57,25 +78,27 @@ inline void EncodeBigEndian(char* buf, uint64_t value) {
     buf[5] = (value >> 16) & 0xff;
     buf[6] = (value >> 8) & 0xff;
     buf[7] = value & 0xff;
+#endif
 }
 
 inline uint64_t DecodeBigEndain(const char* ptr) {
+#ifdef TERA_IO_CODING_USE_BSWAP
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return __builtin_bswap64(value);
+#else
     uint64_t lo = DecodeBigEndain32(ptr + 4);
     uint64_t hi = DecodeBigEndain32(ptr);
     return (hi << 32) | lo;
+#endif
 }
 
 inline int32_t DecodeBigEndain32Sign(const char* ptr) {
-    return ((static_cast<uint32_t>(static_cast<unsigned char>(ptr[3])))
-        | (static_cast<uint32_t>(static_cast<unsigned char>(ptr[2])) << 8)
-        | (static_cast<uint32_t>(static_cast<unsigned char>(ptr[1])) << 16)
-        | (static_cast<int32_t>(static_cast<unsigned char>(ptr[0])) << 24));
+    return static_cast<int32_t>(DecodeBigEndain32(ptr));
 }
 
 inline int64_t DecodeBigEndainSign(const char* ptr) {
-    uint64_t lo = DecodeBigEndain32(ptr + 4);
-    int64_t hi = DecodeBigEndain32Sign(ptr);
-    return (hi << 32) | lo;
+    return static_cast<int64_t>(DecodeBigEndain(ptr));
 }
 
 enum UserKeyType {
@@ -5,6 +5,7 @@
 #include "io/tablet_io.h"
 
 #include <stdint.h>
+#include <algorithm>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
@@ -379,23 +380,36 @@ bool TabletIO::FindAverageKey(const std::string& start, const std::string& end,
         return false;
     }
 
-    // algorithm: use big number ADD and division
-    unsigned int carry[max_len + 1];
-    unsigned int sum[max_len];
-    carry[max_len] = 0;
-    for (int i = max_len - 1; i >= 0; --i) {
-        sum[i] = (unsigned char)s[i] + (unsigned char)e[i] + carry[i + 1];
-        carry[i] = sum[i] / 256;
-        sum[i] %= 256;
-    }
-    memset((char*)carry + sizeof(int), '\0', (max_len) * sizeof(int));
-    for (int i = 0; i < max_len; ++i) {
-        carry[i + 1] = (sum[i] + carry[i] * 256) % 2;
-        sum[i] = (sum[i] + carry[i] * 256) / 2;
+    // algorithm: use big number ADD and division, 8 bytes per step:
+    // load the big-endian keys into uint64 limbs, add with carry from the
+    // low limb up, then shift the whole sum right by one bit
+    int num_limbs = (max_len + 7) / 8;
+    s.resize(num_limbs * 8, '\x00');
+    e.resize(num_limbs * 8, '\x00');
+    std::vector<uint64_t> sum(num_limbs);
+    uint64_t carry = 0;
+    for (int i = num_limbs - 1; i >= 0; --i) {
+        uint64_t a;
+        uint64_t b;
+        memcpy(&a, s.data() + i * 8, 8);
+        memcpy(&b, e.data() + i * 8, 8);
+        a = __builtin_bswap64(a);
+        b = __builtin_bswap64(b);
+        uint64_t partial = a + b;
+        uint64_t carry_out = (partial < a) ? 1 : 0;
+        sum[i] = partial + carry;
+        carry = carry_out + ((sum[i] < partial) ? 1 : 0);
+    }
+    // divide by 2: the add's carry-out becomes the top bit of the result
+    for (int i = 0; i < num_limbs; ++i) {
+        uint64_t cur = sum[i];
+        sum[i] = (cur >> 1) | (carry << 63);
+        carry = cur & 1;
     }
     std::string ave_key;
     for (int i = 0; i < max_len; ++i) {
-        ave_key.append(1, char(sum[i]));
+        int shift = (7 - i % 8) * 8;
+        ave_key.append(1, char((sum[i / 8] >> shift) & 0xFF));
         if (ave_key > start && (end == "" || ave_key < end)) {
             break;
         }
@@ -635,6 +649,73 @@ bool TabletIO::Read(const leveldb::Slice& key, std::string* value,
     return true;
 }
 
+namespace {
+
+struct KeyIndexLess {
+    const std::vector<std::string>* keys;
+    bool operator()(size_t a, size_t b) const {
+        return (*keys)[a] < (*keys)[b];
+    }
+};
+
+} // namespace
+
+bool TabletIO::MultiRead(const std::vector<std::string>& keys,
+                         std::vector<std::string>* values,
+                         std::vector<bool>* founds,
+                         uint64_t snapshot_id, StatusCode* status) {
+    CHECK_NOTNULL(db_);
+    leveldb::ReadOptions read_option(&ldb_options_);
+    read_option.verify_checksums = FLAGS_tera_leveldb_verify_checksums;
+    if (snapshot_id != 0) {
+        if (!SnapshotIDToSeq(snapshot_id, &read_option.snapshot)) {
+            SetStatusCode(kSnapshotNotExist, status);
+            return false;
+        }
+    }
+    read_option.rollbacks = rollbacks_;
+
+    values->assign(keys.size(), "");
+    founds->assign(keys.size(), false);
+
+    // visit the keys in sorted order with one iterator, so lookups landing
+    // in the same data block share its read and bloom/cache probes
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[i] = i;
+    }
+    KeyIndexLess less = { &keys };
+    std::sort(order.begin(), order.end(), less);
+
+    leveldb::Iterator* it = db_->NewIterator(read_option);
+    bool seeked = false;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const std::string& key = keys[order[i]];
+        if (!seeked) {
+            it->Seek(key);
+            seeked = true;
+        } else {
+            // dense key sets usually reach the next key within a few
+            // Next() steps; re-seek when the gap is large
+            int steps = 0;
+            while (it->Valid() && it->key().compare(key) < 0) {
+                if (++steps > 8) {
+                    it->Seek(key);
+                    break;
+                }
+                it->Next();
+            }
+        }
+        if (it->Valid() && it->key().compare(key) == 0) {
+            (*founds)[order[i]] = true;
+            (*values)[order[i]].assign(it->value().data(), it->value().size());
+        }
+    }
+    delete it;
+    SetStatusCode(kTabletNodeOk, status);
+    return true;
+}
+
 StatusCode TabletIO::InitedScanInterator(const std::string& start_tera_key,
                                          const ScanOptions& scan_options,
                                          leveldb::Iterator** scan_it) {
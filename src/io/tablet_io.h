@@ -94,6 +94,17 @@ public:
                       leveldb::Cache* block_cache = NULL,
                       leveldb::TableCache* table_cache = NULL,
                       StatusCode* status = NULL);
+    // convenience overload for callers (mainly tests) that have no
+    // snapshots or rollbacks to restore
+    bool Load(const TableSchema& schema,
+              const std::string& path,
+              const std::vector<uint64_t>& parent_tablets,
+              StatusCode* status) {
+        return Load(schema, path, parent_tablets,
+                    std::map<uint64_t, uint64_t>(),
+                    std::map<uint64_t, uint64_t>(),
+                    NULL, NULL, NULL, status);
+    }
     virtual bool Unload(StatusCode* status = NULL);
     virtual bool Split(std::string* split_key, StatusCode* status = NULL);
     virtual bool Compact(int lg_no = -1, StatusCode* status = NULL);
@@ -111,6 +122,14 @@ public:
     virtual bool Read(const leveldb::Slice& key, std::string* value,
                       uint64_t snapshot_id = 0, StatusCode* status = NULL);
 
+    // batched point lookup for kv tablets: visits the keys in sorted order
+    // with one iterator so dense keys amortize block reads;
+    // (*founds)[i] tells whether keys[i] was hit
+    virtual bool MultiRead(const std::vector<std::string>& keys,
+                           std::vector<std::string>* values,
+                           std::vector<bool>* founds,
+                           uint64_t snapshot_id = 0, StatusCode* status = NULL);
+
     // read a row
     virtual bool ReadCells(const RowReaderInfo& row_reader, RowResult* value_list,
                            uint64_t snapshot_id = 0, StatusCode* status = NULL);
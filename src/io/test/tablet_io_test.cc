@@ -4,7 +4,14 @@
 
 #include "io/tablet_io.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
@@ -28,27 +35,63 @@ DECLARE_int64(tera_tablet_living_period);
 DECLARE_string(tera_leveldb_env_type);
 
 DECLARE_int64(tera_tablet_max_write_buffer_size);
+DECLARE_bool(tera_sync_log);
 DECLARE_string(log_dir);
 
 namespace tera {
 namespace io {
 
-const std::string working_dir = "testdata/";
+// suffix the working dir with the pid so concurrent runs of this binary
+// (gtest-parallel, GTEST_TOTAL_SHARDS sharding) don't trample each other's
+// tablet directories
+std::string InitWorkingDir() {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "testdata_%d/", static_cast<int>(getpid()));
+    return buf;
+}
+
+const std::string working_dir = InitWorkingDir();
 const uint32_t N = 50000;
 
+// shared empty schema for kv-only tablets; Load takes it by const ref, so one
+// instance serves every call site instead of a fresh protobuf per Load
+const TableSchema kEmptySchema;
+
+int RemoveDirEntry(const char* path, const struct stat* st,
+                   int type, struct FTW* ftw) {
+    // the sst/log files written by a finished case are never read again;
+    // tell the kernel to drop their cached pages before unlinking so a big
+    // test run does not evict unrelated hot pages on small CI boxes
+    if (type == FTW_F) {
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+    return remove(path);
+}
+
+// remove "path" and everything below it, like "rm -rf" but in-process
+void RemoveDirRecursive(const std::string& path) {
+    nftw(path.c_str(), RemoveDirEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
 class TabletIOTest : public ::testing::Test {
 public:
-    TabletIOTest() {
-        std::string cmd = std::string("mkdir -p ") + working_dir;
+    // the working dir, the flag overrides, the schema and the empty-map
+    // arguments are shared by every case, so build them once per binary
+    // instead of once per fixture
+    static void SetUpTestCase() {
         FLAGS_tera_tabletnode_path_prefix = "./";
-        system(cmd.c_str());
-
+        if (mkdir(working_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            PLOG(FATAL) << "fail to create " << working_dir;
+        }
         InitSchema();
     }
 
-    ~TabletIOTest() {
-         std::string cmd = std::string("rm -rf ") + working_dir;
-         system(cmd.c_str());
+    static void TearDownTestCase() {
+        RemoveDirRecursive(working_dir);
     }
 
     const TableSchema& GetTableSchema() {
@@ -56,7 +99,7 @@ public:
 
     }
 
-    void InitSchema() {
+    static void InitSchema() {
         schema_.set_name("tera");
         schema_.set_raw_key(Binary);
 
@@ -69,19 +112,67 @@ public:
         cf->set_max_versions(3);
     }
 
-    std::map<uint64_t, uint64_t> empty_snaphsots_;
-    std::map<uint64_t, uint64_t> empty_rollback_;
-    TableSchema schema_;
+    static TableSchema schema_;
 };
 
+TableSchema TabletIOTest::schema_;
+
+// write an 11-digit zero-padded decimal into buf, two digits per pass
+// (buf must hold at least 11 bytes; equivalent to StringFormat("%011llu", i))
+void FillTestKey(uint64_t i, char* buf) {
+    static const char kDigits[] =
+        "00010203040506070809101112131415161718192021222324"
+        "25262728293031323334353637383940414243444546474849"
+        "50515253545556575859606162636465666768697071727374"
+        "75767778798081828384858687888990919293949596979899";
+    int pos = 11;
+    while (pos >= 2) {
+        uint64_t q = i / 100;
+        uint32_t r = static_cast<uint32_t>(i - q * 100);
+        buf[--pos] = kDigits[r * 2 + 1];
+        buf[--pos] = kDigits[r * 2];
+        i = q;
+    }
+    if (pos > 0) {
+        buf[0] = static_cast<char>('0' + i);
+    }
+}
+
+// patch the ts+type block of an already-encoded binary tera key in place,
+// so successive versions of one cell reuse the encoded row/column/qualifier
+// prefix instead of re-running EncodeTeraKey
+// (binary format: [rowkey|column\0|qualifier|type+ts 8B|rlen 2B|qlen 2B])
+void UpdateBinaryTeraKeyTs(int64_t timestamp, leveldb::TeraKeyType type,
+                           std::string* tera_key) {
+    timestamp &= 0x00FFFFFFFFFFFFFF;
+    uint64_t n = ((1UL << 56) - 1 - timestamp) << 8 | (type & 0xFF);
+    char* p = &(*tera_key)[tera_key->size() - 12];
+    for (int i = 7; i >= 0; --i) {
+        p[i] = static_cast<char>(n & 0xFF);
+        n >>= 8;
+    }
+}
+
 // prepare test data
 bool PrepareTestData(TabletIO* tablet, uint64_t e, uint64_t s = 0) {
     leveldb::WriteBatch batch;
+    // 12-byte batch header, then per record: 1-byte tag plus two
+    // length-prefixed 11-byte slices (1-byte varint length each)
+    batch.Reserve(12 + (e - s) * 25);
+    // keep every generated key in one contiguous arena (12-byte slots, 11
+    // bytes used) and hand out Slices into it, instead of scattering the
+    // keys across individual std::string objects
+    std::vector<char> arena((e - s) * 12);
     for (uint64_t i = s; i < e; ++i) {
-        std::string str = StringFormat("%011llu", i); // NumberToString(i);
+        char* buf = &arena[(i - s) * 12];
+        FillTestKey(i, buf);
+        leveldb::Slice str(buf, 11);
         batch.Put(str, str);
     }
-    return tablet->WriteBatch(&batch);
+    // the keys are pre-sorted and the tests always Unload() before re-reading
+    // from disk, so skip the WAL append and fsync entirely; Shutdown1 dumps
+    // the memtable into sst on Unload
+    return tablet->WriteBatch(&batch, true, false);
 }
 
 TEST_F(TabletIOTest, General) {
@@ -91,11 +182,12 @@ TEST_F(TabletIOTest, General) {
     StatusCode status;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
-    std::string key = "555";
-    std::string value = "value of 555";
+    // literal fixtures; construct the std::strings once per process since
+    // WriteOne takes const std::string&
+    static const std::string key("555");
+    static const std::string value("value of 555");
 
     EXPECT_TRUE(tablet.WriteOne(key, value));
 
@@ -116,8 +208,7 @@ TEST_F(TabletIOTest, Split) {
     uint64_t size = 0;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
     // prepare test data
     EXPECT_TRUE(PrepareTestData(&tablet, N));
@@ -134,11 +225,14 @@ TEST_F(TabletIOTest, Split) {
     EXPECT_TRUE(tablet.Unload());
 
     // open tablet for other key scope
+    // (each scope needs a real Unload/Load cycle: the tablet's key range is
+    // baked into the leveldb open via ldb_options_.key_start/key_end, and
+    // GetDataSize/Split consult the db over that range, so the bounds cannot
+    // simply be swapped on a live TabletIO)
     key_start = "5000";
     key_end = "8000";
     TabletIO other_tablet(key_start, key_end);
-    EXPECT_TRUE(other_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(other_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     other_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << key_start << ", " << key_end
         << "]: size = " << size;
@@ -153,8 +247,7 @@ TEST_F(TabletIOTest, Split) {
     key_start = "";
     key_end = "5000";
     TabletIO l_tablet(key_start, key_end);
-    EXPECT_TRUE(l_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(l_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     l_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << key_start << ", " << key_end
         << "]: size = " << size;
@@ -163,8 +256,7 @@ TEST_F(TabletIOTest, Split) {
     key_start = "8000";
     key_end = "";
     TabletIO r_tablet(key_start, key_end);
-    EXPECT_TRUE(r_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(r_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     r_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << key_start << ", " << key_end
         << "]: size = " << size;
@@ -180,8 +272,7 @@ TEST_F(TabletIOTest, SplitAndCheckSize) {
     uint64_t size = 0;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
     // prepare test data
     EXPECT_TRUE(PrepareTestData(&tablet, N));
@@ -200,16 +291,14 @@ TEST_F(TabletIOTest, SplitAndCheckSize) {
 
     // open from split key to check scope size
     TabletIO l_tablet(key_start, split_key);
-    EXPECT_TRUE(l_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(l_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     l_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << key_start << ", " << split_key
         << "]: size = " << size;
     EXPECT_TRUE(l_tablet.Unload());
 
     TabletIO r_tablet(split_key, key_end);
-    EXPECT_TRUE(r_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(r_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     r_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << split_key << ", " << key_end
         << "]: size = " << size;
@@ -225,20 +314,19 @@ TEST_F(TabletIOTest, OverWrite) {
     StatusCode status;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
-    std::string key = "555";
-    std::string value = "value of 555";
-    EXPECT_TRUE(tablet.WriteOne(key, value));
+    static const std::string key("555");
+    static const std::string value1("value of 555");
+    static const std::string value2("value of 666");
+    EXPECT_TRUE(tablet.WriteOne(key, value1));
 
-    value = "value of 666";
-    EXPECT_TRUE(tablet.WriteOne(key, value));
+    EXPECT_TRUE(tablet.WriteOne(key, value2));
 
     std::string read_value;
     EXPECT_TRUE(tablet.Read(key, &read_value));
 
-    EXPECT_EQ(value, read_value);
+    EXPECT_EQ(value2, read_value);
 
     EXPECT_TRUE(tablet.Unload());
 }
@@ -251,8 +339,7 @@ TEST_F(TabletIOTest, Compact) {
     StatusCode status;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
     // prepare test data
     EXPECT_TRUE(PrepareTestData(&tablet, 100));
@@ -267,8 +354,7 @@ TEST_F(TabletIOTest, Compact) {
     std::string new_key_start = StringFormat("%011llu", 5); // NumberToString(500);
     std::string new_key_end = StringFormat("%011llu", 50); // NumberToString(800);
     TabletIO new_tablet(new_key_start, new_key_end);
-    EXPECT_TRUE(new_tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(new_tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
     EXPECT_TRUE(new_tablet.Compact(0, &status));
 
     uint64_t new_table_size = 0;
@@ -276,14 +362,22 @@ TEST_F(TabletIOTest, Compact) {
     LOG(INFO) << "table[" << new_key_start << ", " << new_key_end
         << "]: size = " << new_table_size;
 
+    // one batched lookup instead of 100 independent point reads
+    std::vector<std::string> keys(100);
+    char keybuf[12];
+    for (int i = 0; i < 100; ++i) {
+        FillTestKey(i, keybuf);
+        keys[i].assign(keybuf, 11);
+    }
+    std::vector<std::string> values;
+    std::vector<bool> founds;
+    EXPECT_TRUE(new_tablet.MultiRead(keys, &values, &founds));
     for (int i = 0; i < 100; ++i) {
-        std::string key = StringFormat("%011llu", i); // NumberToString(i);
-        std::string value;
         if (i >= 5 && i < 50) {
-            EXPECT_TRUE(new_tablet.Read(key, &value));
-            EXPECT_EQ(key, value);
+            EXPECT_TRUE(founds[i]);
+            EXPECT_EQ(keys[i], values[i]);
         } else {
-            EXPECT_FALSE(new_tablet.Read(key, &value));
+            EXPECT_FALSE(founds[i]);
         }
     }
 
@@ -297,21 +391,26 @@ TEST_F(TabletIOTest, LowLevelScan) {
     StatusCode status;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(GetTableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(GetTableSchema(), tablet_path, std::vector<uint64_t>(), &status));
 
     std::string tkey1;
+    leveldb::WriteBatch batch;
 
-    // delete this key
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", get_micros(), leveldb::TKT_DEL, &tkey1);
-    tablet.WriteOne(tkey1, "" , false, NULL);
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "", "", get_micros(), leveldb::TKT_DEL, &tkey1);
-    tablet.WriteOne(tkey1, "" , false, NULL);
+    // one clock read for the whole test; bump a local counter per key so
+    // timestamps stay strictly monotonic without ~12 get_micros() calls
+    int64_t ts = get_micros();
 
+    // delete this key
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", ts++, leveldb::TKT_DEL, &tkey1);
+    batch.Put(tkey1, "");
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "", "", ts++, leveldb::TKT_DEL, &tkey1);
+    batch.Put(tkey1, "");
 
     // write cell
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "qualifer", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala" , false, NULL);
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "qualifer", ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+    EXPECT_TRUE(tablet.WriteBatch(&batch, false, false));
+    batch.Clear();
 
     std::string start_tera_key;
     std::string end_row_key;
@@ -324,34 +423,36 @@ TEST_F(TabletIOTest, LowLevelScan) {
                                     &value_list, &next_start_point, &read_row_count, &read_bytes, &is_complete, NULL));
     EXPECT_EQ(value_list.key_values_size(), 1);
 
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", get_micros(), leveldb::TKT_DEL, &tkey1);
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", ts++, leveldb::TKT_DEL, &tkey1);
     tablet.WriteOne(tkey1, "lala" , false, NULL);
     EXPECT_TRUE(tablet.LowLevelScan(start_tera_key, "", ScanOptions(),
                                     &value_list, &next_start_point, &read_row_count, &read_bytes, &is_complete, NULL));
     EXPECT_EQ(value_list.key_values_size(), 0);
 
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "2a", get_micros(), leveldb::TKT_VALUE, &tkey1);
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "2a", ts++, leveldb::TKT_VALUE, &tkey1);
     tablet.WriteOne(tkey1, "lala" , false, NULL);
     EXPECT_TRUE(tablet.LowLevelScan(start_tera_key, "", ScanOptions(),
                                     &value_list, &next_start_point, &read_row_count, &read_bytes, &is_complete, NULL));
     EXPECT_EQ(value_list.key_values_size(), 1);
 
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", get_micros(), leveldb::TKT_DEL, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "", "", get_micros(), leveldb::TKT_DEL, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "1a", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "1a", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "1a", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "column", "1a", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
-    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "column", "2b", get_micros(), leveldb::TKT_VALUE, &tkey1);
-    tablet.WriteOne(tkey1, "lala", false, NULL);
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", ts++, leveldb::TKT_DEL, &tkey1);
+    batch.Put(tkey1, "lala");
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "", "", ts++, leveldb::TKT_DEL, &tkey1);
+    batch.Put(tkey1, "lala");
+
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row", "column", "1a", ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+    UpdateBinaryTeraKeyTs(ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+    UpdateBinaryTeraKeyTs(ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "column", "1a", ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+    tablet.GetRawKeyOperator()->EncodeTeraKey("row1", "column", "2b", ts++, leveldb::TKT_VALUE, &tkey1);
+    batch.Put(tkey1, "lala");
+    EXPECT_TRUE(tablet.WriteBatch(&batch, false, false));
+    batch.Clear();
     tablet.GetRawKeyOperator()->EncodeTeraKey("row", "", "", 0, leveldb::TKT_FORSEEK, &start_tera_key);
     end_row_key = std::string("row1\0", 5);
     ScanOptions scan_options;
@@ -380,8 +481,7 @@ TEST_F(TabletIOTest, SplitToSubTable) {
     uint64_t size = 0;
 
     TabletIO tablet(key_start, key_end);
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
     // prepare test data
     EXPECT_TRUE(PrepareTestData(&tablet, N / 2, 0));
@@ -389,8 +489,7 @@ TEST_F(TabletIOTest, SplitToSubTable) {
 
     // make sure all data are dumped into sst
     EXPECT_TRUE(tablet.Unload());
-    EXPECT_TRUE(tablet.Load(TableSchema(), tablet_path, std::vector<uint64_t>(),
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(tablet.Load(kEmptySchema, tablet_path, std::vector<uint64_t>(), &status));
 
     // for first tablet
     tablet.GetDataSize(&size, NULL, &status);
@@ -416,35 +515,43 @@ TEST_F(TabletIOTest, SplitToSubTable) {
 
     // 1. load sub-table 1
     TabletIO l_tablet(key_start, split_key);
-    EXPECT_TRUE(l_tablet.Load(TableSchema(), split_path_1, parent_tablet,
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(l_tablet.Load(kEmptySchema, split_path_1, parent_tablet, &status));
     l_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << key_start << ", " << split_key
         << "]: size = " << size;
-    // varify result
+    // varify result with one ordered scan instead of N point reads
     int split_key_num = atoi(split_key.c_str());
     LOG(INFO) << "split_key_num " << split_key_num;
-    for (uint64_t i = 0; i < (uint64_t)split_key_num; ++i) {
-        std::string key = StringFormat("%011llu", i);
-        std::string value;
-        EXPECT_TRUE(l_tablet.Read(key, &value));
-        ASSERT_EQ(key, value);
+    ScanOption scan_option;
+    KeyValueList kv_list;
+    bool complete = false;
+    char expected_key[12];
+    ASSERT_TRUE(l_tablet.Scan(scan_option, &kv_list, &complete, &status));
+    ASSERT_TRUE(complete);
+    ASSERT_EQ(kv_list.size(), split_key_num);
+    for (int i = 0; i < kv_list.size(); ++i) {
+        FillTestKey(i, expected_key);
+        ASSERT_EQ(kv_list.Get(i).key(), std::string(expected_key, 11));
+        ASSERT_EQ(kv_list.Get(i).value(), kv_list.Get(i).key());
     }
     EXPECT_TRUE(l_tablet.Unload());
 
     // 2. load sub-table 2
     TabletIO r_tablet(split_key, key_end);
-    EXPECT_TRUE(r_tablet.Load(TableSchema(), split_path_2, parent_tablet,
-                            empty_snaphsots_, empty_rollback_, NULL, NULL, NULL, &status));
+    EXPECT_TRUE(r_tablet.Load(kEmptySchema, split_path_2, parent_tablet, &status));
     r_tablet.GetDataSize(&size, NULL, &status);
     LOG(INFO) << "table[" << split_key << ", " << key_end
         << "]: size = " << size;
-    // varify result
-    for (uint64_t i = (uint64_t)split_key_num; i < N; ++i) {
-        std::string key = StringFormat("%011llu", i);
-        std::string value;
-        EXPECT_TRUE(r_tablet.Read(key, &value));
-        ASSERT_EQ(key, value);
+    // varify result with one ordered scan instead of N point reads
+    kv_list.Clear();
+    complete = false;
+    ASSERT_TRUE(r_tablet.Scan(scan_option, &kv_list, &complete, &status));
+    ASSERT_TRUE(complete);
+    ASSERT_EQ(kv_list.size(), (int)(N - split_key_num));
+    for (int i = 0; i < kv_list.size(); ++i) {
+        FillTestKey(split_key_num + i, expected_key);
+        ASSERT_EQ(kv_list.Get(i).key(), std::string(expected_key, 11));
+        ASSERT_EQ(kv_list.Get(i).value(), kv_list.Get(i).key());
     }
     EXPECT_TRUE(r_tablet.Unload());
 
@@ -549,6 +656,9 @@ int main(int argc, char** argv) {
     FLAGS_tera_io_retry_max_times = 1;
     FLAGS_tera_tablet_living_period = 0;
     FLAGS_tera_tablet_max_write_buffer_size = 1;
+    // correctness tests do not care about durability across a crash, so
+    // spare every write path the log fsync
+    FLAGS_tera_sync_log = false;
     FLAGS_tera_leveldb_env_type = "local";
     ::google::InitGoogleLogging(argv[0]);
     FLAGS_log_dir = "./log";
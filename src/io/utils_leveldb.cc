@@ -193,5 +193,20 @@ bool DeleteEnvDir(const std::string& dir) {
     }
     return true;
 }
+
+size_t DeleteEnvFiles(const std::vector<std::string>& files) {
+    leveldb::Env* env = LeveldbBaseEnv();
+    size_t delete_num = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        leveldb::Status s = env->DeleteFile(files[i]);
+        if (s.ok()) {
+            delete_num++;
+        } else {
+            LOG(ERROR) << "[gc] fail to delete: " << files[i]
+                << ", status: " << s.ToString();
+        }
+    }
+    return delete_num;
+}
 } // namespace io
 } // namespace leveldb
@@ -7,6 +7,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "leveldb/env.h"
 
@@ -36,6 +37,11 @@ void CleanTrashDir();
 
 bool DeleteEnvDir(const std::string& subdir);
 
+// delete a batch of files in one call, return the number of files deleted;
+// the base env has no multi-file delete RPC yet, so this is the single
+// point to hook one up for dfs-backed envs
+size_t DeleteEnvFiles(const std::vector<std::string>& files);
+
 } // namespace io
 } // namespace tera
 
@@ -50,6 +50,10 @@ size_t WriteBatch::DataSize() {
     return rep_.size();
 }
 
+void WriteBatch::Reserve(size_t bytes) {
+  rep_.reserve(bytes);
+}
+
 Status WriteBatch::Iterate(Handler* handler) const {
   Slice input(rep_);
   if (input.size() < kHeader) {
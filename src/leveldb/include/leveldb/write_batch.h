@@ -47,6 +47,11 @@ class WriteBatch {
   // Clear all updates buffered in this batch.
   void Clear();
 
+  // Pre-allocate space for "bytes" bytes of batch data, like
+  // std::string::reserve.  Useful when the caller knows the batch size
+  // up-front and wants to avoid geometric reallocation.
+  void Reserve(size_t bytes);
+
   // Return the size of batch
   size_t DataSize();
 
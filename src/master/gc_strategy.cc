@@ -5,8 +5,9 @@
 #include "master/gc_strategy.h"
 
 #include <gflags/gflags.h>
-#include <boost/lexical_cast.hpp>
+#include <boost/bind.hpp>
 
+#include "common/base/string_number.h"
 #include "db/filename.h"
 #include "io/utils_leveldb.h"
 
@@ -14,12 +15,15 @@
 DECLARE_string(tera_tabletnode_path_prefix);
 DECLARE_string(tera_master_meta_table_name);
 DECLARE_int32(tera_garbage_collect_debug_log);
+DECLARE_int32(tera_master_gc_thread_num);
 
 namespace tera {
 namespace master {
 
 BatchGcStrategy::BatchGcStrategy (boost::shared_ptr<TabletManager> tablet_manager)
     : tablet_manager_(tablet_manager),
+      env_(io::LeveldbBaseEnv()),
+      gc_thread_pool_(new ThreadPool(FLAGS_tera_master_gc_thread_num)),
       file_total_num_(0),
       file_delete_num_(0) {}
 
@@ -60,7 +64,7 @@ bool BatchGcStrategy::PreQuery () {
 
 void BatchGcStrategy::PostQuery () {
     bool is_success = true;
-    std::map<std::string, GcTabletSet>::iterator it = gc_tablets_.begin();
+    GcTabletMap::iterator it = gc_tablets_.begin();
     for (; it != gc_tablets_.end(); ++it) {
         if (it->second.first.size() != 0) {
             VLOG(10) << "[gc] there are tablet not ready: " << it->first;
@@ -93,27 +97,42 @@ void BatchGcStrategy::ProcessQueryCallbackForGc(QueryResponse* response) {
         gc_table_set.insert(live.table_name());
     }
 
+    // bucket the metas by table so each table's gc sets are located once
+    // per response instead of once per tablet
+    typedef boost::unordered_map<std::string, std::vector<const TabletMeta*> > MetasByTable;
+    MetasByTable metas_by_table;
     for (int i = 0; i < response->tabletmeta_list().meta_size(); ++i) {
         const TabletMeta& meta = response->tabletmeta_list().meta(i);
         VLOG(10) << "[gc] try erase live tablet: " << meta.path()
             << ", tablename: " << meta.table_name();
-        if (gc_tablets_.find(meta.table_name()) != gc_tablets_.end() &&
-            gc_table_set.find(meta.table_name()) != gc_table_set.end()) {
+        metas_by_table[meta.table_name()].push_back(&meta);
+    }
+    MetasByTable::iterator bucket_it = metas_by_table.begin();
+    for (; bucket_it != metas_by_table.end(); ++bucket_it) {
+        const std::string& table_name = bucket_it->first;
+        GcTabletMap::iterator tablet_it = gc_tablets_.find(table_name);
+        if (tablet_it == gc_tablets_.end() ||
+            gc_table_set.find(table_name) == gc_table_set.end()) {
+            continue;
+        }
+        std::vector<const TabletMeta*>& metas = bucket_it->second;
+        for (size_t i = 0; i < metas.size(); ++i) {
             // erase live tablet
-            VLOG(10) << "[gc] erase live tablet: " << meta.path();
-            uint64_t tabletnum = leveldb::GetTabletNumFromPath(meta.path());
-            gc_tablets_[meta.table_name()].first.erase(tabletnum);
+            VLOG(10) << "[gc] erase live tablet: " << metas[i]->path();
+            uint64_t tabletnum = leveldb::GetTabletNumFromPath(metas[i]->path());
+            tablet_it->second.first.erase(tabletnum);
         }
     }
 
     // erase inherited live files
     for (int i = 0; i < response->inh_live_files_size(); ++i) {
         const InheritedLiveFiles& live = response->inh_live_files(i);
-        if (gc_live_files_.find(live.table_name()) == gc_live_files_.end()) {
+        GcFileMap::iterator file_it = gc_live_files_.find(live.table_name());
+        if (file_it == gc_live_files_.end()) {
             VLOG(10) << "[gc] table: " << live.table_name() << " skip gc.";
             continue;
         }
-        GcFileSet& file_set = gc_live_files_[live.table_name()];
+        GcFileSet& file_set = file_it->second;
         int lg_num = live.lg_live_files_size();
         CHECK(static_cast<size_t>(lg_num) == file_set.size())
             << "lg_num should eq " << file_set.size();
@@ -130,26 +149,51 @@ void BatchGcStrategy::ProcessQueryCallbackForGc(QueryResponse* response) {
 }
 
 void BatchGcStrategy::CollectDeadTabletsFiles() {
-    std::map<std::string, GcTabletSet>::iterator table_it = gc_tablets_.begin();
+    CHECK_EQ(gc_pending_count_.Get(), 0);
+    gc_pending_count_.Inc();
+    GcTabletMap::iterator table_it = gc_tablets_.begin();
     for (; table_it != gc_tablets_.end(); ++table_it) {
+        const std::string& tablename = table_it->first;
+        // look up the schema once per table instead of once per dead tablet
+        TablePtr table;
+        CHECK(tablet_manager_->FindTable(tablename, &table));
+        GcFileSet& file_set = gc_live_files_[tablename];
+        file_set.resize(table->GetSchema().locality_groups_size());
+        VLOG(10) << "[gc] resize : " << tablename
+            << " fileset lg size: " << file_set.size();
+
         std::set<uint64_t>& dead_tablets = table_it->second.second;
         std::set<uint64_t>::iterator tablet_it = dead_tablets.begin();
         for (; tablet_it != dead_tablets.end(); ++tablet_it) {
-            CollectSingleDeadTablet(table_it->first, *tablet_it);
+            gc_pending_count_.Inc();
+            gc_thread_pool_->AddTask(
+                boost::bind(&BatchGcStrategy::CollectSingleDeadTabletTask,
+                            this, tablename, *tablet_it));
         }
     }
+    if (0 != gc_pending_count_.Dec()) {
+        gc_done_event_.Wait();
+    }
+}
+
+void BatchGcStrategy::CollectSingleDeadTabletTask(const std::string& tablename,
+                                                  uint64_t tabletnum) {
+    CollectSingleDeadTablet(tablename, tabletnum);
+    if (0 == gc_pending_count_.Dec()) {
+        gc_done_event_.Set();
+    }
 }
 
 void BatchGcStrategy::CollectSingleDeadTablet(const std::string& tablename, uint64_t tabletnum) {
     std::string tablepath = FLAGS_tera_tabletnode_path_prefix + tablename;
     std::string tablet_path = leveldb::GetTabletPathFromNum(tablepath, tabletnum);
-    leveldb::Env* env = io::LeveldbBaseEnv();
     std::vector<std::string> children;
-    env->GetChildren(tablet_path, &children);
+    children.reserve(64);
+    env_->GetChildren(tablet_path, &children);
     list_count_.Inc();
     if (children.size() == 0) {
         LOG(INFO) << "[gc] delete empty tablet dir: " << tablet_path;
-        env->DeleteDir(tablet_path);
+        env_->DeleteDir(tablet_path);
         return;
     }
     for (size_t lg = 0; lg < children.size(); ++lg) {
@@ -158,7 +202,7 @@ void BatchGcStrategy::CollectSingleDeadTablet(const std::string& tablename, uint
         uint64_t number = 0;
         if (ParseFileName(children[lg], &number, &type)) {
             LOG(INFO) << "[gc] delete: " << lg_path;
-            env->DeleteFile(lg_path);
+            env_->DeleteFile(lg_path);
             continue;
         }
 
@@ -170,14 +214,16 @@ void BatchGcStrategy::CollectSingleDeadTablet(const std::string& tablename, uint
         }
 
         std::vector<std::string> files;
-        env->GetChildren(lg_path, &files);
+        files.reserve(256);
+        env_->GetChildren(lg_path, &files);
         list_count_.Inc();
         if (files.size() == 0) {
             LOG(INFO) << "[gc] delete empty lg dir: " << lg_path;
-            env->DeleteDir(lg_path);
+            env_->DeleteDir(lg_path);
             continue;
         }
-        file_total_num_ += files.size();
+        std::vector<uint64_t> live_files;
+        live_files.reserve(files.size());
         for (size_t f = 0; f < files.size(); ++f) {
             std::string file_path = lg_path + "/" + files[f];
             type = leveldb::kUnknown;
@@ -189,42 +235,64 @@ void BatchGcStrategy::CollectSingleDeadTablet(const std::string& tablename, uint
                 continue;
             }
 
-            uint64_t full_number = leveldb::BuildFullFileNumber(lg_path, number);
-            GcFileSet& file_set = gc_live_files_[tablename];
-            if (file_set.size() == 0) {
-                TablePtr table;
-                CHECK(tablet_manager_->FindTable(tablename, &table));
-                file_set.resize(table->GetSchema().locality_groups_size());
-                VLOG(10) << "[gc] resize : " << tablename
-                    << " fileset lg size: " << file_set.size();
-            }
             VLOG(10) << "[gc] " << tablename << " insert live file: " << file_path;
-            CHECK(lg_num < file_set.size());
-            file_set[lg_num].insert(full_number);
+            live_files.push_back(leveldb::BuildFullFileNumber(lg_path, number));
         }
+
+        // merge into shared state; may run inside list_thread_pool_
+        MutexLock lock(&gc_mutex_);
+        file_total_num_ += files.size();
+        // sized by CollectDeadTabletsFiles before the tasks were dispatched
+        GcFileSet& file_set = gc_live_files_[tablename];
+        CHECK(lg_num < file_set.size());
+        file_set[lg_num].insert(live_files.begin(), live_files.end());
     }
 }
 
 void BatchGcStrategy::DeleteObsoleteFiles() {
-    leveldb::Env* env = io::LeveldbBaseEnv();
-    std::map<std::string, GcFileSet>::iterator table_it = gc_live_files_.begin();
+    CHECK_EQ(gc_pending_count_.Get(), 0);
+    gc_pending_count_.Inc();
+    GcFileMap::iterator table_it = gc_live_files_.begin();
     for (; table_it != gc_live_files_.end(); ++table_it) {
         std::string tablepath = FLAGS_tera_tabletnode_path_prefix + table_it->first;
         GcFileSet& file_set = table_it->second;
         for (size_t lg = 0; lg < file_set.size(); ++lg) {
-            std::set<uint64_t>::iterator it = file_set[lg].begin();
+            std::vector<std::string> obsolete_paths;
+            GcFileNumberSet::iterator it = file_set[lg].begin();
             for (; it != file_set[lg].end(); ++it) {
                 std::string file_path = leveldb::BuildTableFilePath(tablepath, lg, *it);
                 LOG(INFO) << "[gc] delete: " << file_path;
-                env->DeleteFile(file_path);
-                file_delete_num_++;
+                obsolete_paths.push_back(file_path);
+            }
+            if (obsolete_paths.size() == 0) {
+                continue;
             }
+            // one batched task per lg instead of one DeleteFile RPC per sst
+            gc_pending_count_.Inc();
+            gc_thread_pool_->AddTask(
+                boost::bind(&BatchGcStrategy::DeleteFilesTask, this, obsolete_paths));
         }
     }
+    if (0 != gc_pending_count_.Dec()) {
+        gc_done_event_.Wait();
+    }
+}
+
+void BatchGcStrategy::DeleteFilesTask(const std::vector<std::string>& files) {
+    size_t delete_num = io::DeleteEnvFiles(files);
+    {
+        MutexLock lock(&gc_mutex_);
+        file_delete_num_ += delete_num;
+    }
+    if (0 == gc_pending_count_.Dec()) {
+        gc_done_event_.Set();
+    }
 }
 
 IncrementalGcStrategy::IncrementalGcStrategy(boost::shared_ptr<TabletManager> tablet_manager)
     :   tablet_manager_(tablet_manager),
+        env_(io::LeveldbBaseEnv()),
+        gc_thread_pool_(new ThreadPool(FLAGS_tera_master_gc_thread_num)),
         last_gc_time_(std::numeric_limits<int64_t>::max()),
         max_ts_(std::numeric_limits<int64_t>::max()) {}
 
@@ -233,44 +301,64 @@ bool IncrementalGcStrategy::PreQuery () {
     std::vector<TablePtr> tables;
     tablet_manager_->ShowTable(&tables, NULL);
 
+    CHECK_EQ(gc_pending_count_.Get(), 0);
+    gc_pending_count_.Inc();
+    // (tablename, tabletnum) pairs whose dirs still need listing; they are
+    // dispatched only after all bookkeeping below is done, so the listing
+    // tasks never race with the map inserts
+    std::vector<std::pair<std::string, uint64_t> > newly_dead;
     for (size_t i = 0; i < tables.size(); ++i) {
-        TabletFiles tablet_files;
         std::string table_name = tables[i]->GetTableName();
         if (table_name == FLAGS_tera_master_meta_table_name) continue;
-        dead_tablet_files_.insert(std::make_pair(table_name, tablet_files));
-        live_tablet_files_.insert(std::make_pair(table_name, tablet_files));
+        // operator[] creates the per-table entries in place, no
+        // insert-a-temporary copies
+        TabletFiles& table_dead_tablets = dead_tablet_files_[table_name];
+        TabletFiles& table_live_tablets = live_tablet_files_[table_name];
 
         std::set<uint64_t> live_tablets, dead_tablets;
         tables[i]->GetTabletsForGc(&live_tablets, &dead_tablets);
         std::set<uint64_t>::iterator it;
-        // update dead tablets
+        // update dead tablets and purge them from live tablets in one pass;
+        // dead_tablets (newly dead) is much smaller than the live map
         for (it = dead_tablets.begin(); it != dead_tablets.end(); ++it) {
-            TabletFiles& temp_tablet_files = dead_tablet_files_[table_name];
             TabletFileSet tablet_file_set(get_micros() / 1000000, 0);
-            bool ret = temp_tablet_files.insert(std::make_pair(*it, tablet_file_set)).second;
+            bool ret = table_dead_tablets.insert(std::make_pair(*it, tablet_file_set)).second;
             if (ret) {
                 VLOG(12) << "[gc] newly dead talbet " << table_name << " " << *it;
-                CollectSingleDeadTablet(table_name, *it);
+                newly_dead.push_back(std::make_pair(table_name, *it));
             }
+            table_live_tablets.erase(static_cast<int64_t>(*it));
         }
 
-        // erase newly dead tablets from live tablets
-        for (TabletFiles::iterator it = live_tablet_files_[table_name].begin();
-             it != live_tablet_files_[table_name].end();) {
-            if (dead_tablet_files_[table_name].find(static_cast<uint64_t>(it->first)) != dead_tablet_files_[table_name].end()) {
-                live_tablet_files_[table_name].erase(it++);
-            } else {
-                ++it;
-            }
-        }
-
-        // add new live tablets
+        // add new live tablets with a hinted merge walk: the set and the
+        // map are both sorted ascending, so instead of an O(log N) root
+        // descent per id the hint makes each insert amortized O(1)
+        TabletFiles::iterator hint_it = table_live_tablets.begin();
         for (it = live_tablets.begin(); it != live_tablets.end(); ++it) {
-            TabletFiles& temp_tablet_files = live_tablet_files_[table_name];
-            TabletFileSet tablet_file_set;
-            temp_tablet_files.insert(std::make_pair(*it, tablet_file_set));
+            int64_t tablet_number = static_cast<int64_t>(*it);
+            while (hint_it != table_live_tablets.end() &&
+                   hint_it->first < tablet_number) {
+                ++hint_it;
+            }
+            if (hint_it == table_live_tablets.end() ||
+                hint_it->first != tablet_number) {
+                hint_it = table_live_tablets.insert(
+                    hint_it, std::make_pair(tablet_number, TabletFileSet()));
+            }
         }
     }
+    // overlap the dir listings (and the junk-file deletes they issue)
+    // across all newly dead tablets
+    for (size_t i = 0; i < newly_dead.size(); ++i) {
+        gc_pending_count_.Inc();
+        gc_thread_pool_->AddTask(
+            boost::bind(&IncrementalGcStrategy::CollectSingleDeadTabletTask,
+                        this, newly_dead[i].first, newly_dead[i].second));
+    }
+    if (0 != gc_pending_count_.Dec()) {
+        gc_done_event_.Wait();
+    }
+
     if (FLAGS_tera_garbage_collect_debug_log) {
         DEBUG_print_files(true);
         DEBUG_print_files(false);
@@ -293,72 +381,81 @@ void IncrementalGcStrategy::ProcessQueryCallbackForGc(QueryResponse* response) {
         ready_tables.insert(response->inh_live_files(table).table_name());
     }
 
-    // update tablet ready time
+    // update tablet ready time, grouping the metas by table first so the
+    // live map is probed once per table instead of once per tablet
+    typedef boost::unordered_map<std::string, std::vector<const TabletMeta*> > MetasByTable;
+    MetasByTable metas_by_table;
     for (int i = 0; i < response->tabletmeta_list().meta_size(); ++i) {
         const TabletMeta& meta = response->tabletmeta_list().meta(i);
-        std::string table_name = meta.table_name();
+        const std::string& table_name = meta.table_name();
         if (table_name == FLAGS_tera_master_meta_table_name) continue;
-        if (live_tablet_files_.find(table_name) == live_tablet_files_.end() ||
+        metas_by_table[table_name].push_back(&meta);
+    }
+    MetasByTable::iterator bucket_it = metas_by_table.begin();
+    for (; bucket_it != metas_by_table.end(); ++bucket_it) {
+        const std::string& table_name = bucket_it->first;
+        TableFiles::iterator live_it = live_tablet_files_.find(table_name);
+        if (live_it == live_tablet_files_.end() ||
             ready_tables.find(table_name) == ready_tables.end()) {
             continue;
         }
         VLOG(12) << "[gc] see live table " << table_name;
-        int64_t tablet_number = static_cast<int64_t>(leveldb::GetTabletNumFromPath(meta.path()));
-        if (live_tablet_files_[table_name].find(tablet_number) == live_tablet_files_[table_name].end()) continue;
-        live_tablet_files_[table_name][tablet_number].ready_time_ = get_micros() / 1000000;
+        std::vector<const TabletMeta*>& metas = bucket_it->second;
+        for (size_t i = 0; i < metas.size(); ++i) {
+            int64_t tablet_number =
+                static_cast<int64_t>(leveldb::GetTabletNumFromPath(metas[i]->path()));
+            TabletFiles::iterator tablet_it = live_it->second.find(tablet_number);
+            if (tablet_it == live_it->second.end()) continue;
+            tablet_it->second.ready_time_ = get_micros() / 1000000;
+        }
     }
 
     // insert live files
     for (int table = 0; table < response->inh_live_files_size(); ++table) {
-        InheritedLiveFiles live_files = response->inh_live_files(table);
-        std::string table_name = live_files.table_name();
+        const InheritedLiveFiles& live_files = response->inh_live_files(table);
+        const std::string& table_name = live_files.table_name();
         if (table_name == FLAGS_tera_master_meta_table_name) continue;
-        VLOG(12) << "[gc] inh pb: " << response->inh_live_files(table).ShortDebugString();
+        VLOG(12) << "[gc] inh pb: " << live_files.ShortDebugString();
         if (live_tablet_files_.find(table_name) == live_tablet_files_.end()) continue;
+        TabletFiles& dead_tablets = dead_tablet_files_[table_name];
         // collect live files
         TabletFiles temp_tablet_files;
         for (int lg = 0; lg < live_files.lg_live_files_size(); ++lg) {
-            LgInheritedLiveFiles lg_live_files = live_files.lg_live_files(lg);
+            const LgInheritedLiveFiles& lg_live_files = live_files.lg_live_files(lg);
             uint32_t lg_no = lg_live_files.lg_no();
             for (int i = 0; i < lg_live_files.file_number_size(); ++i) {
                 uint64_t tablet_number, file;
                 uint64_t file_number = lg_live_files.file_number(i);
                 leveldb::ParseFullFileNumber(file_number, &tablet_number, &file);
-                if (dead_tablet_files_[table_name].find(tablet_number) ==
-                    dead_tablet_files_[table_name].end()) {
+                TabletFiles::iterator dead_it = dead_tablets.find(tablet_number);
+                if (dead_it == dead_tablets.end()) {
                     VLOG(12) << "[gc] skip newly dead tablet " << tablet_number;
                     continue;
                 }
-                TabletFileSet tablet_file_set;
-                temp_tablet_files.insert(std::make_pair(tablet_number, tablet_file_set));
                 TabletFileSet& temp_tablet_file_set = temp_tablet_files[tablet_number];
-                LgFileSet lg_files;
-                temp_tablet_file_set.files_.insert(std::make_pair(lg_no, lg_files));
                 temp_tablet_file_set.files_[lg_no].live_files_.insert(file_number);
                 VLOG(12) << "[gc] insert live file " << tablet_number << "/" << lg_no << "/" << file;
-                const LgFileSet& check = ((dead_tablet_files_[table_name][tablet_number]).files_)[lg_no];
+                const LgFileSet& check = (dead_it->second.files_)[lg_no];
                 CHECK(check.storage_files_.find(file_number) != check.storage_files_.end()) << "[gc] insert error";
             }
         }
         // update live files in dead tablets
         TabletFiles::iterator tablet_it = temp_tablet_files.begin();
-        TabletFiles& dead_tablets = dead_tablet_files_[table_name];
         for (; tablet_it != temp_tablet_files.end(); ++tablet_it) {
             uint64_t tablet_number = tablet_it->first;
-            if (dead_tablets.find(tablet_number) == dead_tablets.end()) {
+            TabletFiles::iterator dead_it = dead_tablets.find(tablet_number);
+            if (dead_it == dead_tablets.end()) {
                 VLOG(12) << "[gc] skip tablet " << table_name << "/" << tablet_number;
                 continue;
             }
             std::map<int64_t, LgFileSet>& live_lg = (tablet_it->second).files_;
-            std::map<int64_t, LgFileSet>& dead_lg = dead_tablets[tablet_number].files_;
+            std::map<int64_t, LgFileSet>& dead_lg = dead_it->second.files_;
             std::map<int64_t, LgFileSet>::iterator lg_it = live_lg.begin();
             for (; lg_it != live_lg.end(); ++lg_it) {
                 uint32_t lg_no = lg_it->first;
-                LgFileSet lg_file_set;
-                dead_lg.insert(std::make_pair(lg_no, lg_file_set));
-                for (std::set<uint64_t>::iterator it = live_lg[lg_no].live_files_.begin(); it != live_lg[lg_no].live_files_.end(); ++it) {
-                    dead_lg[lg_no].live_files_.insert(*it);
-                }
+                LgFileSet& live_lg_files = lg_it->second;
+                dead_lg[lg_no].live_files_.insert(live_lg_files.live_files_.begin(),
+                                                  live_lg_files.live_files_.end());
                 VLOG(12) << "[gc] copy " << tablet_number << "-" << lg_no;
             }
         }
@@ -375,9 +472,17 @@ void IncrementalGcStrategy::PostQuery () {
         DEBUG_print_files(false);
     }
     int64_t start_ts = get_micros();
+    CHECK_EQ(gc_pending_count_.Get(), 0);
+    gc_pending_count_.Inc();
     TableFiles::iterator table_it = dead_tablet_files_.begin();
     for (; table_it != dead_tablet_files_.end(); ++table_it) {
-        DeleteTableFiles(table_it->first);
+        gc_pending_count_.Inc();
+        gc_thread_pool_->AddTask(
+            boost::bind(&IncrementalGcStrategy::DeleteTableFilesTask,
+                        this, table_it->first));
+    }
+    if (0 != gc_pending_count_.Dec()) {
+        gc_done_event_.Wait();
     }
     if (FLAGS_tera_garbage_collect_debug_log) {
         DEBUG_print_files(true);
@@ -394,9 +499,15 @@ void IncrementalGcStrategy::Clear(std::string tablename) {
     live_tablet_files_.erase(tablename);
 }
 
+void IncrementalGcStrategy::DeleteTableFilesTask(const std::string& table_name) {
+    DeleteTableFiles(table_name);
+    if (0 == gc_pending_count_.Dec()) {
+        gc_done_event_.Set();
+    }
+}
+
 void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
     std::string table_path = FLAGS_tera_tabletnode_path_prefix + table_name;
-    leveldb::Env* env = io::LeveldbBaseEnv();
     TabletFiles& dead_tablets = dead_tablet_files_[table_name];
     TabletFiles& live_tablets = live_tablet_files_[table_name];
     int64_t earliest_ready_time = max_ts_;
@@ -408,15 +519,17 @@ void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
     }
 
     VLOG(12) << "[gc] earliest ready time  " << earliest_ready_time;
-    std::set<int64_t> gc_tablets;
+    // dead_tablets is already walked in order, a flat list is enough here
+    std::vector<int64_t> gc_tablets;
+    gc_tablets.reserve(dead_tablets.size());
     for (tablet_it = dead_tablets.begin(); tablet_it != dead_tablets.end(); ++tablet_it) {
         if (tablet_it->second.dead_time_ < earliest_ready_time) {
-            gc_tablets.insert(tablet_it->first);
+            gc_tablets.push_back(tablet_it->first);
             VLOG(12) << "[gc] push back gc tablet " << tablet_it->first;
         }
     }
 
-    std::set<int64_t>::iterator gc_it = gc_tablets.begin();
+    std::vector<int64_t>::iterator gc_it = gc_tablets.begin();
     for (; gc_it != gc_tablets.end();) {
         std::map<int64_t, LgFileSet>& lg_files = dead_tablets[*gc_it].files_;
         std::map<int64_t, LgFileSet>::iterator lg_it = lg_files.begin();
@@ -424,26 +537,34 @@ void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
         for (; lg_it != lg_files.end();) {
             VLOG(12) << "[gc] entry lg gc lg=" << lg_it->first;
             LgFileSet& lg_file_set = lg_it->second;
-            std::set<uint64_t>::iterator file_it = lg_file_set.storage_files_.begin();
-            for (; file_it != lg_file_set.storage_files_.end();) {
+            std::vector<std::string> obsolete_paths;
+            std::vector<uint64_t> obsolete_files;
+            boost::unordered_set<uint64_t>::iterator file_it = lg_file_set.storage_files_.begin();
+            for (; file_it != lg_file_set.storage_files_.end(); ++file_it) {
                 if (lg_file_set.live_files_.find(*file_it) == lg_file_set.live_files_.end()) {
                     std::string file_path =
                         leveldb::BuildTableFilePath(table_path, lg_it->first, *file_it);
 
-                    std::string debug_str;
-                    for (std::set<uint64_t>::iterator it = lg_file_set.live_files_.begin(); it != lg_file_set.live_files_.end(); ++it) {
-                        uint64_t file_no;
-                        leveldb::ParseFullFileNumber(*it, NULL, &file_no);
-                        debug_str += " " + boost::lexical_cast<std::string>(file_no);
+                    if (VLOG_IS_ON(12)) {
+                        std::string debug_str;
+                        for (boost::unordered_set<uint64_t>::iterator it = lg_file_set.live_files_.begin(); it != lg_file_set.live_files_.end(); ++it) {
+                            uint64_t file_no;
+                            leveldb::ParseFullFileNumber(*it, NULL, &file_no);
+                            debug_str += " " + NumberToString(file_no);
+                        }
+                        VLOG(12) << "[gc] live = " << debug_str;
                     }
-                    VLOG(12) << "[gc] live = " << debug_str;
                     LOG(INFO) << "[gc] delete: " << file_path;
-                    env->DeleteFile(file_path);
-                    lg_file_set.storage_files_.erase(file_it++);
-                } else {
-                    file_it++;
+                    obsolete_paths.push_back(file_path);
+                    obsolete_files.push_back(*file_it);
                 }
             }
+            // one batched call per lg; drop the numbers from storage_files_
+            // only after the deletes have been issued
+            io::DeleteEnvFiles(obsolete_paths);
+            for (size_t i = 0; i < obsolete_files.size(); ++i) {
+                lg_file_set.storage_files_.erase(obsolete_files[i]);
+            }
             if (lg_file_set.storage_files_.size() == 0) {
                 if (lg_file_set.live_files_.size() != 0) {
                     uint64_t full_number = *(lg_file_set.live_files_.begin());
@@ -452,10 +573,10 @@ void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
                     LOG(ERROR) << "still has live files: " << tablet_number << "/" << lg_it->first << "/" << file_number;
                     assert(0);
                 }
-                std::string lg_str = boost::lexical_cast<std::string>(lg_it->first);
+                std::string lg_str = NumberToString(lg_it->first);
                 std::string lg_path = tablet_path + "/" + lg_str;
                 LOG(INFO) << "[gc] delete empty lg dir: " << lg_path;
-                env->DeleteDir(lg_path);
+                env_->DeleteDir(lg_path);
                 lg_files.erase(lg_it++);
             } else {
                 lg_it++;
@@ -464,7 +585,7 @@ void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
 
         if (lg_files.size() == 0) {
             LOG(INFO) << "[gc] delete empty tablet dir: " << tablet_path;
-            env->DeleteDir(tablet_path);
+            env_->DeleteDir(tablet_path);
             dead_tablets.erase(*gc_it);
         } else {
             // clear live_files_ in dead_tablets for next round of gc
@@ -479,12 +600,20 @@ void IncrementalGcStrategy::DeleteTableFiles(const std::string& table_name) {
     }
 }
 
+void IncrementalGcStrategy::CollectSingleDeadTabletTask(const std::string& tablename,
+                                                        uint64_t tabletnum) {
+    CollectSingleDeadTablet(tablename, tabletnum);
+    if (0 == gc_pending_count_.Dec()) {
+        gc_done_event_.Set();
+    }
+}
+
 void IncrementalGcStrategy::CollectSingleDeadTablet(const std::string& tablename, uint64_t tabletnum) {
     std::string tablepath = FLAGS_tera_tabletnode_path_prefix + tablename;
     std::string tablet_path = leveldb::GetTabletPathFromNum(tablepath, tabletnum);
-    leveldb::Env* env = io::LeveldbBaseEnv();
     std::vector<std::string> children;
-    env->GetChildren(tablet_path, &children);
+    children.reserve(64);
+    env_->GetChildren(tablet_path, &children);
     list_count_.Inc();
 
     for (size_t lg = 0; lg < children.size(); ++lg) {
@@ -493,25 +622,26 @@ void IncrementalGcStrategy::CollectSingleDeadTablet(const std::string& tablename
         uint64_t number = 0;
         if (ParseFileName(children[lg], &number, &type)) {
             LOG(INFO) << "[gc] delete: " << lg_path;
-            env->DeleteFile(lg_path);
+            env_->DeleteFile(lg_path);
             continue;
         }
 
+        // only treat the dir as an lg if the whole name is a decimal;
+        // the number parsed here is reused below, no second parse
         leveldb::Slice rest(children[lg]);
         uint64_t lg_num = 0;
-        if (!leveldb::ConsumeDecimalNumber(&rest, &lg_num)) {
+        if (!leveldb::ConsumeDecimalNumber(&rest, &lg_num) || !rest.empty()) {
             LOG(INFO) << "[gc] skip unknown dir: " << lg_path;
             continue;
         }
 
         std::vector<std::string> files;
-        env->GetChildren(lg_path, &files);
+        files.reserve(256);
+        env_->GetChildren(lg_path, &files);
         list_count_.Inc();
 
-        int64_t lg_no = boost::lexical_cast<int64_t>(children[lg]);
+        int64_t lg_no = static_cast<int64_t>(lg_num);
         std::map<int64_t, LgFileSet>& tablet_files = dead_tablet_files_[tablename][tabletnum].files_;
-        LgFileSet lg_file_set;
-        tablet_files.insert(std::make_pair(lg_no, lg_file_set));
         LgFileSet& temp_lg_files_set = tablet_files[lg_no];
         for (size_t f = 0; f < files.size(); ++f) {
             std::string file_path = lg_path + "/" + files[f];
@@ -531,43 +661,40 @@ void IncrementalGcStrategy::CollectSingleDeadTablet(const std::string& tablename
 }
 
 void IncrementalGcStrategy::DEBUG_print_files(bool print_dead) {
-    TableFiles all_tablet_files;
-    if (print_dead == true) {
-        LOG(INFO) << "----------------------------[gc] Test print DEAD";
-        all_tablet_files = dead_tablet_files_;
-    } else {
-        LOG(INFO) << "----------------------------[gc] Test print LIVE";
-        all_tablet_files = live_tablet_files_;
-    }
-    TableFiles::iterator table_it;
+    // walk the real maps read-only instead of deep-copying them
+    const TableFiles& all_tablet_files =
+        print_dead ? dead_tablet_files_ : live_tablet_files_;
+    LOG(INFO) << "----------------------------[gc] Test print "
+        << (print_dead ? "DEAD" : "LIVE");
+    TableFiles::const_iterator table_it;
     for (table_it = all_tablet_files.begin(); table_it != all_tablet_files.end(); ++table_it) {
         LOG(INFO) << "[gc] table=" << table_it->first;
-        TabletFiles& tablet_files = table_it->second;
-        TabletFiles::iterator tablet_it;
+        const TabletFiles& tablet_files = table_it->second;
+        TabletFiles::const_iterator tablet_it;
         for (tablet_it = tablet_files.begin(); tablet_it != tablet_files.end(); ++tablet_it) {
             LOG(INFO) << "[gc]   tablet -- " << tablet_it->first;
-            TabletFileSet tablet_file_set = tablet_it->second;
+            const TabletFileSet& tablet_file_set = tablet_it->second;
             LOG(INFO) << "[gc]   ready -- " << tablet_file_set.ready_time_;
             LOG(INFO) << "[gc]   dead  -- " << tablet_file_set.dead_time_;
-            std::map<int64_t, LgFileSet>& files = tablet_file_set.files_;
-            std::map<int64_t, LgFileSet>::iterator lg_it;
+            const std::map<int64_t, LgFileSet>& files = tablet_file_set.files_;
+            std::map<int64_t, LgFileSet>::const_iterator lg_it;
             for (lg_it = files.begin(); lg_it != files.end(); ++lg_it) {
-                std::set<uint64_t>& f = (lg_it->second).storage_files_;
-                std::string debug_str = "";
-                for (std::set<uint64_t>::iterator it = f.begin(); it != f.end(); ++it) {
+                const boost::unordered_set<uint64_t>& storage_files = (lg_it->second).storage_files_;
+                std::string debug_str;
+                for (boost::unordered_set<uint64_t>::const_iterator it = storage_files.begin(); it != storage_files.end(); ++it) {
                     uint64_t file_no;
                     leveldb::ParseFullFileNumber(*it, NULL, &file_no);
-                    debug_str += " " + boost::lexical_cast<std::string>(file_no);
+                    debug_str += " " + NumberToString(file_no);
                 }
-                LOG(INFO) << "[gc]     lg stor -- " << lg_it->first << "-" << (lg_it->second).storage_files_.size() << debug_str;
-                f = (lg_it->second).live_files_;
-                debug_str = "";
-                for (std::set<uint64_t>::iterator it = f.begin(); it != f.end(); ++it) {
+                LOG(INFO) << "[gc]     lg stor -- " << lg_it->first << "-" << storage_files.size() << debug_str;
+                const boost::unordered_set<uint64_t>& live_files = (lg_it->second).live_files_;
+                debug_str.clear();
+                for (boost::unordered_set<uint64_t>::const_iterator it = live_files.begin(); it != live_files.end(); ++it) {
                     uint64_t file_no;
                     leveldb::ParseFullFileNumber(*it, NULL, &file_no);
-                    debug_str += " " + boost::lexical_cast<std::string>(file_no);
+                    debug_str += " " + NumberToString(file_no);
                 }
-                LOG(INFO) << "[gc]     lg live -- " << lg_it->first << "-" << (lg_it->second).live_files_.size() << debug_str;
+                LOG(INFO) << "[gc]     lg live -- " << lg_it->first << "-" << live_files.size() << debug_str;
             }
         }
     }
@@ -4,6 +4,13 @@
 #ifndef TERA_MASTER_GC_STRATEGY_H_
 #define TERA_MASTER_GC_STRATEGY_H_
 
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "common/base/scoped_ptr.h"
+#include "common/event.h"
+#include "common/thread_pool.h"
+#include "leveldb/env.h"
 #include "master/tablet_manager.h"
 #include "proto/tabletnode_client.h"
 #include "types.h"
@@ -52,17 +59,33 @@ public:
 private:
     void CollectDeadTabletsFiles();
     void CollectSingleDeadTablet(const std::string& tablename, uint64_t tabletnum);
+    void CollectSingleDeadTabletTask(const std::string& tablename, uint64_t tabletnum);
     void DeleteObsoleteFiles();
+    void DeleteFilesTask(const std::vector<std::string>& files);
 
     boost::shared_ptr<TabletManager> tablet_manager_;
+    leveldb::Env* env_; // base env singleton, resolved once
+
+    // listing and deleting are both latency-bound on DFS, so dead-tablet
+    // listings and delete batches run concurrently; the pending/done pair
+    // works like the master query latch
+    scoped_ptr<ThreadPool> gc_thread_pool_;
+    Counter gc_pending_count_;
+    AutoResetEvent gc_done_event_;
 
     // tabletnode garbage clean
     // first: live tablet, second: dead tablet
+    // (GcTabletSet stays std::set: it is filled via GetTabletsForGc;
+    // the string-keyed maps and file-number sets are lookup-only, so
+    // hash containers save the per-node alloc and tree walk)
     typedef std::pair<std::set<uint64_t>, std::set<uint64_t> > GcTabletSet;
-    typedef std::vector<std::set<uint64_t> > GcFileSet;
+    typedef boost::unordered_set<uint64_t> GcFileNumberSet;
+    typedef std::vector<GcFileNumberSet> GcFileSet;
+    typedef boost::unordered_map<std::string, GcTabletSet> GcTabletMap;
+    typedef boost::unordered_map<std::string, GcFileSet> GcFileMap;
     mutable Mutex gc_mutex_;
-    std::map<std::string, GcTabletSet> gc_tablets_;
-    std::map<std::string, GcFileSet> gc_live_files_;
+    GcTabletMap gc_tablets_;
+    GcFileMap gc_live_files_;
     int64_t file_total_num_;
     int64_t file_delete_num_;
     tera::Counter list_count_;
@@ -88,11 +111,13 @@ public:
 private:
     void DEBUG_print_files(bool print_dead);
     void CollectSingleDeadTablet(const std::string& tablename, uint64_t tabletnum);
+    void CollectSingleDeadTabletTask(const std::string& tablename, uint64_t tabletnum);
     void DeleteTableFiles(const std::string& table_name);
+    void DeleteTableFilesTask(const std::string& table_name);
 
     struct LgFileSet {
-        std::set<uint64_t> storage_files_;
-        std::set<uint64_t> live_files_;
+        boost::unordered_set<uint64_t> storage_files_;
+        boost::unordered_set<uint64_t> live_files_;
     };
 
     struct TabletFileSet {
@@ -109,10 +134,20 @@ private:
         }
     };
 
-    typedef std::map<int64_t, TabletFileSet> TabletFiles;  // tablet_number -> files
-    typedef std::map<std::string, TabletFiles> TableFiles; // table_name -> files
+    // tablet_number -> files; kept ordered for sorted tablet-id walks
+    typedef std::map<int64_t, TabletFileSet> TabletFiles;
+    // table_name -> files; lookup-only, hash map avoids string tree-compares
+    typedef boost::unordered_map<std::string, TabletFiles> TableFiles;
     mutable Mutex gc_mutex_;
     boost::shared_ptr<TabletManager> tablet_manager_;
+    leveldb::Env* env_; // base env singleton, resolved once
+
+    // tables are disjoint in dead/live_tablet_files_, so per-table delete
+    // walks can run concurrently on the pool
+    scoped_ptr<ThreadPool> gc_thread_pool_;
+    Counter gc_pending_count_;
+    AutoResetEvent gc_done_event_;
+
     int64_t last_gc_time_;
     TableFiles dead_tablet_files_;
     TableFiles live_tablet_files_;
@@ -5,9 +5,15 @@
 #include "master/master_impl.h"
 #include "tabletnode/tablet_manager.h"
 
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <boost/bind.hpp>
-#include <fstream>
+#include <boost/make_shared.hpp>
 
 #include <gflags/gflags.h>
 #include <glog/logging.h>
@@ -23,6 +29,7 @@
 #include "proto/master_client.h"
 #include "proto/proto_helper.h"
 #include "proto/tabletnode_client.h"
+#include "util/hash.h"
 #include "utils/config_utils.h"
 #include "utils/schema_utils.h"
 #include "utils/string_util.h"
@@ -39,6 +46,8 @@ DECLARE_int32(tera_master_cache_keep_min);
 
 DECLARE_int32(tera_master_impl_thread_max_num);
 DECLARE_int32(tera_master_impl_query_thread_num);
+DECLARE_int32(tera_master_impl_query_shard_num);
+DECLARE_bool(tera_master_query_direct_submit);
 DECLARE_int32(tera_master_impl_retry_times);
 
 DECLARE_int32(tera_master_common_retry_period);
@@ -47,6 +56,7 @@ DECLARE_int32(tera_master_query_tabletnode_period);
 DECLARE_string(tera_master_meta_table_name);
 DECLARE_string(tera_master_meta_table_path);
 DECLARE_int32(tera_master_meta_retry_times);
+DECLARE_int32(tera_master_meta_write_fuse_max_num);
 
 DECLARE_bool(tera_zk_enabled);
 
@@ -79,6 +89,7 @@ DECLARE_bool(tera_delete_obsolete_tabledir_enabled);
 DECLARE_string(tera_master_stat_table_name);
 DECLARE_int64(tera_master_stat_table_ttl);
 DECLARE_int64(tera_master_stat_table_interval);
+DECLARE_int32(tera_master_stat_table_batch_num);
 DECLARE_bool(tera_master_stat_table_enabled);
 DECLARE_int64(tera_master_stat_table_splitsize);
 
@@ -111,15 +122,15 @@ namespace master {
 
 MasterImpl::MasterImpl()
     : status_(kNotInited), restored_(false),
-      tablet_manager_(new TabletManager(&this_sequence_id_, this, thread_pool_.get())),
-      tabletnode_manager_(new TabletNodeManager(this)),
-      user_manager_(new UserManager),
+      tablet_manager_(boost::make_shared<TabletManager>(&this_sequence_id_, this,
+                                                        thread_pool_.get())),
+      tabletnode_manager_(boost::make_shared<TabletNodeManager>(this)),
+      user_manager_(boost::make_shared<UserManager>()),
       zk_adapter_(NULL),
       size_scheduler_(new SizeScheduler),
       load_scheduler_(new LoadScheduler),
       release_cache_timer_id_(kInvalidTimerId),
       query_enabled_(false),
-      query_thread_pool_(new ThreadPool(FLAGS_tera_master_impl_query_thread_num)),
       start_query_time_(0),
       query_tabletnode_timer_id_(kInvalidTimerId),
       load_balance_scheduled_(false),
@@ -130,7 +141,22 @@ MasterImpl::MasterImpl()
       gc_enabled_(false),
       gc_timer_id_(kInvalidTimerId),
       gc_query_enable_(false),
-      tablet_availability_(new TabletAvailability(tablet_manager_)) {
+      available_check_timer_id_(kInvalidTimerId),
+      tablet_availability_(boost::make_shared<TabletAvailability>(tablet_manager_)) {
+    alias_.reset(new AliasMap);
+    int32_t query_shard_num = FLAGS_tera_master_impl_query_shard_num;
+    if (query_shard_num < 1) {
+        query_shard_num = 1;
+    }
+    int32_t threads_per_shard =
+        FLAGS_tera_master_impl_query_thread_num / query_shard_num;
+    if (threads_per_shard < 1) {
+        threads_per_shard = 1;
+    }
+    for (int32_t i = 0; i < query_shard_num; ++i) {
+        query_thread_pools_.push_back(
+            boost::shared_ptr<ThreadPool>(new ThreadPool(threads_per_shard)));
+    }
     if (FLAGS_tera_master_cache_check_enabled) {
         EnableReleaseCacheTimer();
     }
@@ -147,10 +173,10 @@ MasterImpl::MasterImpl()
 
     if (FLAGS_tera_master_gc_strategy == "default") {
         LOG(INFO) << "[gc] gc strategy is BatchGcStrategy";
-        gc_strategy_ = boost::shared_ptr<GcStrategy>(new BatchGcStrategy(tablet_manager_));
+        gc_strategy_ = boost::make_shared<BatchGcStrategy>(tablet_manager_);
     } else if (FLAGS_tera_master_gc_strategy == "incremental") {
         LOG(INFO) << "[gc] gc strategy is IncrementalGcStrategy";
-        gc_strategy_ = boost::shared_ptr<GcStrategy>(new IncrementalGcStrategy(tablet_manager_));
+        gc_strategy_ = boost::make_shared<IncrementalGcStrategy>(tablet_manager_);
     } else {
         LOG(ERROR) << "Unknown gc strategy";
     }
@@ -236,27 +262,35 @@ bool MasterImpl::Restore(const std::map<std::string, std::string>& tabletnode_li
 void MasterImpl::CollectAllTabletInfo(const std::map<std::string, std::string>& tabletnode_list,
                                       std::vector<TabletMeta>* tablet_list) {
     Mutex mutex;
-    sem_t finish_counter;
-    sem_init(&finish_counter, 0, 0);
+    // same latch as the periodic query: each callback decrements once and
+    // only the last one wakes us, so N nodes cost N atomic ops instead of
+    // N semaphore syscalls
+    Counter finish_counter;
+    AutoResetEvent finish_event;
+    finish_counter.Inc();
     tablet_list->clear();
-    uint32_t tabletnode_num = tabletnode_list.size();
     std::map<std::string, std::string>::const_iterator it = tabletnode_list.begin();
     for (; it != tabletnode_list.end(); ++it) {
         const std::string& addr = it->first;
         const std::string& uuid = it->second;
         tabletnode_manager_->AddTabletNode(addr, uuid);
 
+        finish_counter.Inc();
         QueryClosure* done =
             NewClosure(this, &MasterImpl::CollectTabletInfoCallback, addr,
-                       tablet_list, &finish_counter, &mutex);
-        QueryTabletNodeAsync(addr, FLAGS_tera_master_collect_info_timeout, false, done);
+                       tablet_list, &finish_counter, &finish_event, &mutex);
+        // building and submitting one query rpc per node serializes on
+        // this thread during restore; fan the submissions out and let the
+        // latch above collect the completions
+        ThreadPool::Task task =
+            boost::bind(&MasterImpl::QueryTabletNodeAsync, this, addr,
+                        FLAGS_tera_master_collect_info_timeout, false, done);
+        thread_pool_->AddTask(task);
     }
 
-    uint32_t i = 0;
-    while (i++ < tabletnode_num) {
-        sem_wait(&finish_counter);
+    if (0 != finish_counter.Dec()) {
+        finish_event.Wait();
     }
-    sem_destroy(&finish_counter);
 }
 
 bool MasterImpl::RestoreMetaTablet(const std::vector<TabletMeta>& tablet_list,
@@ -479,55 +513,83 @@ bool MasterImpl::CheckUserPermissionOnTable(const std::string& token, TablePtr t
            || (table->GetSchema().admin() == user_manager_->TokenToUserName(token)));
 }
 
-template <typename Request>
-bool MasterImpl::HasPermissionOnTable(const Request* request, TablePtr table) {
+bool MasterImpl::HasPermissionOnTable(bool has_user_token,
+                                      const std::string& user_token,
+                                      TablePtr table) {
     if (!FLAGS_tera_acl_enabled
-        || IsRootUser(request->user_token())
+        || IsRootUser(user_token)
         || ((table->GetSchema().admin_group() == "") && (table->GetSchema().admin() == ""))
-        || (request->has_user_token()
-            && CheckUserPermissionOnTable(request->user_token(), table))) {
+        || (has_user_token
+            && CheckUserPermissionOnTable(user_token, table))) {
         return true;
 
     }
     return false;
 }
 
+void MasterImpl::LogNoPermission(bool has_user_token,
+                                 const std::string& user_token,
+                                 const char* operate) {
+    std::string token = has_user_token ? user_token : "";
+    LOG(INFO) << "[acl] " << user_manager_->TokenToUserName(token)
+              << ":" << token << " fail to " << operate;
+}
+
+template <typename Request>
+bool MasterImpl::HasPermissionOnTable(const Request* request, TablePtr table) {
+    return HasPermissionOnTable(request->has_user_token(),
+                                request->user_token(), table);
+}
+
 template <typename Request, typename Response, typename Callback>
 bool MasterImpl::HasPermissionOrReturn(const Request* request, Response* response,
                                        Callback* done, TablePtr table, const char* operate) {
     // check permission
     if (HasPermissionOnTable(request, table)) {
         return true;
-    } else {
-        std::string token = request->has_user_token() ? request->user_token() : "";
-        LOG(INFO) << "[acl] " << user_manager_->TokenToUserName(token)
-                  << ":" << token << " fail to " << operate;
-        response->set_sequence_id(request->sequence_id());
-        response->set_status(kNotPermission);
-        done->Run();
-        return false;
     }
+    LogNoPermission(request->has_user_token(), request->user_token(), operate);
+    response->set_sequence_id(request->sequence_id());
+    response->set_status(kNotPermission);
+    done->Run();
+    return false;
 }
 
 bool MasterImpl::LoadMetaTable(const std::string& meta_tablet_addr,
                                StatusCode* ret_status) {
     tablet_manager_->ClearTableList();
     ScanTabletRequest request;
-    ScanTabletResponse response;
     request.set_sequence_id(this_sequence_id_.Inc());
     request.set_table_name(FLAGS_tera_master_meta_table_name);
     request.set_start("");
     request.set_end("");
     tabletnode::TabletNodeClient meta_node_client(meta_tablet_addr);
-    while (meta_node_client.ScanTablet(&request, &response)) {
-        if (response.status() != kTabletNodeOk) {
-            SetStatusCode(response.status(), ret_status);
+
+    // double-buffer the restore: while a batch is parsed into the
+    // managers on the thread pool, the scan rpc for the next batch is
+    // already on the wire. only one parse task is in flight at a time,
+    // so batches are still applied in key order (table records sort
+    // before their tablet records)
+    bool parse_pending = false;
+    AutoResetEvent parse_event;
+    ScanTabletResponse* response = new ScanTabletResponse;
+    while (meta_node_client.ScanTablet(&request, response)) {
+        if (response->status() != kTabletNodeOk) {
+            SetStatusCode(response->status(), ret_status);
             LOG(ERROR) << "fail to load meta table: "
-                << StatusCodeToString(response.status());
+                << StatusCodeToString(response->status());
+            if (parse_pending) {
+                parse_event.Wait();
+            }
+            delete response;
             tablet_manager_->ClearTableList();
             return false;
         }
-        if (response.results().key_values_size() <= 0) {
+        if (response->results().key_values_size() <= 0) {
+            if (parse_pending) {
+                parse_event.Wait();
+            }
+            delete response;
             LOG(INFO) << "load meta table success";
             TabletPtr meta_tablet;
             TableSchema schema;
@@ -542,74 +604,125 @@ bool MasterImpl::LoadMetaTable(const std::string& meta_tablet_addr,
                       schema, kTableReady, 0, &meta_tablet);
             return true;
         }
-        uint32_t record_size = response.results().key_values_size();
+        uint32_t record_size = response->results().key_values_size();
         LOG(INFO) << "load meta table: " << record_size << " records";
 
-        std::string last_record_key;
-        for (uint32_t i = 0; i < record_size; i++) {
-            const KeyValuePair& record = response.results().key_values(i);
-            last_record_key = record.key();
-            char first_key_char = record.key()[0];
-            if (first_key_char == '~') {
-                user_manager_->LoadUserMeta(record.key(), record.value());
-            } else if (first_key_char == '@') {
-                tablet_manager_->LoadTableMeta(record.key(), record.value());
-                FillAlias(record.key(), record.value());
-            } else if (first_key_char > '@') {
-                tablet_manager_->LoadTabletMeta(record.key(), record.value());
-            } else {
-                continue;
-            }
-        }
-        std::string next_record_key = NextKey(last_record_key);
-        request.set_start(next_record_key);
+        const std::string& last_record_key =
+            response->results().key_values(record_size - 1).key();
+        request.set_start(NextKey(last_record_key));
         request.set_end("");
         request.set_sequence_id(this_sequence_id_.Inc());
-        response.Clear();
+
+        if (parse_pending) {
+            parse_event.Wait();
+        }
+        ThreadPool::Task task =
+            boost::bind(&MasterImpl::ParseMetaBatchTask, this, response,
+                        &parse_event);
+        thread_pool_->AddTask(task);
+        parse_pending = true;
+        response = new ScanTabletResponse;
+    }
+    if (parse_pending) {
+        parse_event.Wait();
     }
+    delete response;
     SetStatusCode(kRPCError, ret_status);
     LOG(ERROR) << "fail to load meta table: " << StatusCodeToString(kRPCError);
     tablet_manager_->ClearTableList();
     return false;
 }
 
+void MasterImpl::ParseMetaBatchTask(ScanTabletResponse* response,
+                                    AutoResetEvent* parse_event) {
+    uint32_t record_size = response->results().key_values_size();
+    for (uint32_t i = 0; i < record_size; i++) {
+        const KeyValuePair& record = response->results().key_values(i);
+        if (record.key().empty()) {
+            continue;
+        }
+        char first_key_char = record.key()[0];
+        if (first_key_char == '~') {
+            user_manager_->LoadUserMeta(record.key(), record.value());
+        } else if (first_key_char == '@') {
+            tablet_manager_->LoadTableMeta(record.key(), record.value());
+            FillAlias(record.key(), record.value());
+        } else if (first_key_char > '@') {
+            tablet_manager_->LoadTabletMeta(record.key(), record.value());
+        }
+    }
+    delete response;
+    parse_event->Set();
+}
+
 void MasterImpl::FillAlias(const std::string& key, const std::string& value) {
     TableMeta meta;
     ParseMetaTableKeyValue(key, value, &meta);
     if (!meta.schema().alias().empty()) {
-        MutexLock locker(&alias_mutex_);
-        alias_[meta.schema().alias()] = meta.schema().name();
+        UpdateAliasMap(meta.schema().alias(), meta.schema().name(), "");
         LOG(INFO) << "table alias:" << meta.schema().alias()
                   << " -> " << meta.schema().name();
     }
 }
 
+MasterImpl::AliasMapPtr MasterImpl::GetAliasMap() {
+    return boost::atomic_load(&alias_);
+}
+
+void MasterImpl::UpdateAliasMap(const std::string& add_alias,
+                                const std::string& table_name,
+                                const std::string& del_alias) {
+    MutexLock locker(&alias_mutex_);
+    boost::shared_ptr<AliasMap> new_map(new AliasMap(*alias_));
+    if (!del_alias.empty()) {
+        new_map->erase(del_alias);
+    }
+    if (!add_alias.empty()) {
+        (*new_map)[add_alias] = table_name;
+    }
+    boost::atomic_store(&alias_, AliasMapPtr(new_map));
+}
+
 bool MasterImpl::LoadMetaTableFromFile(const std::string& filename,
                                           StatusCode* ret_status) {
     tablet_manager_->ClearTableList();
-    std::ifstream ifs(filename.c_str(), std::ofstream::binary);
-    if (!ifs.is_open()) {
+    // map the whole dump and parse it in place: one read syscall path
+    // instead of four iostream reads per record
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         LOG(ERROR) << "fail to open file " << filename << " for read";
         SetStatusCode(kIOError, ret_status);
         return false;
     }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        LOG(ERROR) << "fail to stat file " << filename;
+        close(fd);
+        SetStatusCode(kIOError, ret_status);
+        return false;
+    }
+    void* base = NULL;
+    if (st.st_size > 0) {
+        base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            LOG(ERROR) << "fail to mmap file " << filename;
+            close(fd);
+            SetStatusCode(kIOError, ret_status);
+            return false;
+        }
+        madvise(base, st.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
 
+    const char* pos = static_cast<const char*>(base);
+    const char* end = pos + st.st_size;
     uint64_t count = 0;
+    bool success = true;
     std::string key, value;
-    while (ReadFromStream(ifs, &key, &value)) {
-        if (key.empty()) {
-            LOG(INFO) << "load meta table success, " << count << " records";
-            TabletPtr meta_tablet;
-            TableSchema schema;
-            LocalityGroupSchema* lg = schema.add_locality_groups();
-            schema.set_name(FLAGS_tera_master_meta_table_name);
-            lg->set_name("lg_meta");
-            lg->set_compress_type(false);
-            lg->set_store_type(MemoryStore);
-            tablet_manager_->AddTablet(FLAGS_tera_master_meta_table_name, "", "",
-                      FLAGS_tera_master_meta_table_path, "",
-                      schema, kTableNotInit, 0, &meta_tablet);
-            return true;
+    while (pos < end) {
+        if (!ParseMetaRecord(&pos, end, &key, &value)) {
+            success = false;
+            break;
         }
 
         char first_key_char = key[0];
@@ -620,12 +733,28 @@ bool MasterImpl::LoadMetaTableFromFile(const std::string& filename,
             FillAlias(key, value);
         } else if (first_key_char > '@') {
             tablet_manager_->LoadTabletMeta(key, value);
-        } else {
-            continue;
         }
 
         count++;
     }
+    if (base != NULL) {
+        munmap(base, st.st_size);
+    }
+
+    if (success) {
+        LOG(INFO) << "load meta table success, " << count << " records";
+        TabletPtr meta_tablet;
+        TableSchema schema;
+        LocalityGroupSchema* lg = schema.add_locality_groups();
+        schema.set_name(FLAGS_tera_master_meta_table_name);
+        lg->set_name("lg_meta");
+        lg->set_compress_type(false);
+        lg->set_store_type(MemoryStore);
+        tablet_manager_->AddTablet(FLAGS_tera_master_meta_table_name, "", "",
+                  FLAGS_tera_master_meta_table_path, "",
+                  schema, kTableNotInit, 0, &meta_tablet);
+        return true;
+    }
     tablet_manager_->ClearTableList();
 
     SetStatusCode(kIOError, ret_status);
@@ -633,30 +762,32 @@ bool MasterImpl::LoadMetaTableFromFile(const std::string& filename,
     return false;
 }
 
-bool MasterImpl::ReadFromStream(std::ifstream& ifs,
-                                std::string* key,
-                                std::string* value) {
+bool MasterImpl::ParseMetaRecord(const char** pos, const char* end,
+                                 std::string* key, std::string* value) {
+    // record framing: <key_size><key><value_size><value>, sizes are
+    // fixed-width host-order uint32
+    const char* p = *pos;
     uint32_t key_size = 0, value_size = 0;
-    ifs.read((char*)&key_size, sizeof(key_size));
-    if (ifs.eof() && ifs.gcount() == 0) {
-        key->clear();
-        value->clear();
-        return true;
+    if (p + sizeof(key_size) > end) {
+        return false;
     }
-    key->resize(key_size);
-    ifs.read((char*)key->data(), key_size);
-    if (ifs.fail()) {
+    memcpy(&key_size, p, sizeof(key_size));
+    p += sizeof(key_size);
+    if (key_size == 0 || p + key_size > end) {
         return false;
     }
-    ifs.read((char*)&value_size, sizeof(value_size));
-    if (ifs.fail()) {
+    key->assign(p, key_size);
+    p += key_size;
+    if (p + sizeof(value_size) > end) {
         return false;
     }
-    value->resize(value_size);
-    ifs.read((char*)value->data(), value_size);
-    if (ifs.fail()) {
+    memcpy(&value_size, p, sizeof(value_size));
+    p += sizeof(value_size);
+    if (p + value_size > end) {
         return false;
     }
+    value->assign(p, value_size);
+    *pos = p + value_size;
     return true;
 }
 
@@ -700,14 +831,8 @@ void MasterImpl::CreateTable(const CreateTableRequest* request,
                 return;
         }
         if (!request->schema().alias().empty()) {
-            bool alias_exist = false;
-            {
-                MutexLock locker(&alias_mutex_);
-                if (alias_.find(request->schema().alias()) != alias_.end()) {
-                    alias_exist =  true;
-                }
-            }
-            if (alias_exist) {
+            AliasMapPtr alias_map = GetAliasMap();
+            if (alias_map->find(request->schema().alias()) != alias_map->end()) {
                 LOG(ERROR) << "Fail to create table: " << request->table_name()
                 << ", table already exist, alias:" << request->schema().alias() ;
                 response->set_status(kTableExist);
@@ -787,8 +912,7 @@ void MasterImpl::CreateTable(const CreateTableRequest* request,
     TablePtr table = tablets[0]->GetTable();
     std::string table_alias = table->GetSchema().alias();
     if (!table_alias.empty()) {
-        MutexLock locker(&alias_mutex_);
-        alias_[table_alias] = table_name;
+        UpdateAliasMap(table_alias, table_name, "");
     }
     WriteClosure* closure =
         NewClosure(this, &MasterImpl::AddMetaCallback, table, tablets,
@@ -1064,7 +1188,7 @@ void MasterImpl::SearchTable(const SearchTableRequest* request,
     done->Run();
 }
 
-void MasterImpl::CopyTableMetaToUser(TablePtr table, TableMeta* meta_ptr) {
+void MasterImpl::CopyTableMetaToUser(const TablePtr& table, TableMeta* meta_ptr) {
     TableSchema old_schema;
     if (table->GetOldSchema(&old_schema)) {
         TableMeta meta;
@@ -1642,6 +1766,10 @@ void MasterImpl::QueryTabletNode() {
 
     CHECK_EQ(query_pending_count_.Get(), 0);
     query_pending_count_.Inc();
+    // count the ready nodes first and bump the latch once, so submission
+    // does not fight the already-arriving callbacks over the counter's
+    // cacheline with one rmw per node
+    std::vector<TabletNodePtr> ready_nodes;
     std::vector<TabletNodePtr>::iterator it = tabletnode_array.begin();
     for (; it != tabletnode_array.end(); ++it) {
         TabletNodePtr tabletnode = *it;
@@ -1649,7 +1777,11 @@ void MasterImpl::QueryTabletNode() {
             VLOG(20) << "will not query tabletnode: " << tabletnode->addr_;
             continue;
         }
-        query_pending_count_.Inc();
+        ready_nodes.push_back(tabletnode);
+    }
+    query_pending_count_.Add(ready_nodes.size());
+    for (it = ready_nodes.begin(); it != ready_nodes.end(); ++it) {
+        TabletNodePtr tabletnode = *it;
         QueryClosure* done =
             NewClosure(this, &MasterImpl::QueryTabletNodeCallback, tabletnode->addr_);
         QueryTabletNodeAsync(tabletnode->addr_,
@@ -1812,37 +1944,48 @@ uint32_t MasterImpl::LoadBalance(Scheduler* scheduler,
     // so that the node with heaviest workload will be scheduled first
     scheduler->DescendingSort(tabletnode_list_copy, table_name);
 
+    // per-node balancing walks every tablet of the node and is pure CPU,
+    // so fan the nodes out on the pool each round; the move budget is a
+    // ticket counter so concurrent tasks never overrun max_move_num, and
+    // nodes are queued in sorted order so the heaviest still go first
+    LoadBalanceContext ctx;
+    ctx.scheduler = scheduler;
+    ctx.node_tablet_list = &node_tablet_list;
+    ctx.table_name = table_name;
+    ctx.max_move_num = max_move_num;
+
     uint32_t round_count = 0;
-    uint32_t total_move_count = 0;
     while (round_count < max_round_num) {
         VLOG(20) << "LoadBalance (" << scheduler->Name() << ") " << table_name
                   << " round " << round_count << " start";
 
-        uint32_t round_move_count = 0;
+        ctx.round_move_count.Clear();
+        ctx.pending_count.Inc();
         std::vector<TabletNodePtr>::iterator node_copy_it = tabletnode_list_copy.begin();
-        while (total_move_count < max_move_num && node_copy_it != tabletnode_list_copy.end()) {
-            TabletNodePtr node;
-            if (tabletnode_manager_->FindTabletNode((*node_copy_it)->GetAddr(), &node)
-                && (*node_copy_it)->GetId() == node->GetId()
-                && node->GetState() == kReady) {
-                const std::vector<TabletPtr>& tablet_list = node_tablet_list[node->GetAddr()];
-                if (TabletNodeLoadBalance(node, scheduler, tablet_list, table_name)) {
-                    round_move_count++;
-                    total_move_count++;
-                }
-            }
+        while (ctx.move_count.Get() < max_move_num &&
+               node_copy_it != tabletnode_list_copy.end()) {
+            ctx.pending_count.Inc();
+            ThreadPool::Task task =
+                boost::bind(&MasterImpl::TabletNodeLoadBalanceTask, this,
+                            *node_copy_it, &ctx);
+            thread_pool_->AddTask(task);
             ++node_copy_it;
         }
+        if (0 != ctx.pending_count.Dec()) {
+            ctx.done_event.Wait();
+        }
 
         VLOG(20) << "LoadBalance (" << scheduler->Name() << ") " << table_name
-                  << " round " << round_count << " move " << round_move_count;
+                  << " round " << round_count << " move "
+                  << ctx.round_move_count.Get();
 
         round_count++;
-        if (round_move_count == 0) {
+        if (ctx.round_move_count.Get() == 0) {
             break;
         }
     }
 
+    uint32_t total_move_count = ctx.move_count.Get();
     if (total_move_count != 0) {
         LOG(INFO) << "LoadBalance (" << scheduler->Name() << ") " << table_name
                   << " total round " << round_count << " total move " << total_move_count;
@@ -1922,6 +2065,37 @@ bool MasterImpl::TabletNodeLoadBalance(TabletNodePtr tabletnode, Scheduler* sche
     return false;
 }
 
+void MasterImpl::TabletNodeLoadBalanceTask(TabletNodePtr node_copy,
+                                           LoadBalanceContext* ctx) {
+    TabletNodePtr node;
+    if (tabletnode_manager_->FindTabletNode(node_copy->GetAddr(), &node)
+        && node_copy->GetId() == node->GetId()
+        && node->GetState() == kReady) {
+        // take a move ticket before balancing and give it back if no
+        // tablet moves, so the pass never exceeds its move budget
+        if ((uint32_t)ctx->move_count.Inc() <= ctx->max_move_num) {
+            bool moved = false;
+            // find() only: operator[] would mutate the shared map
+            std::map<std::string, std::vector<TabletPtr> >::const_iterator it =
+                ctx->node_tablet_list->find(node->GetAddr());
+            if (it != ctx->node_tablet_list->end()) {
+                moved = TabletNodeLoadBalance(node, ctx->scheduler, it->second,
+                                              ctx->table_name);
+            }
+            if (moved) {
+                ctx->round_move_count.Inc();
+            } else {
+                ctx->move_count.Dec();
+            }
+        } else {
+            ctx->move_count.Dec();
+        }
+    }
+    if (0 == ctx->pending_count.Dec()) {
+        ctx->done_event.Set();
+    }
+}
+
 /////////// cache release //////////
 
 void MasterImpl::TryReleaseCache(bool enbaled_debug) {
@@ -2043,7 +2217,7 @@ void MasterImpl::AddTabletNode(const std::string& tabletnode_addr,
                                const std::string& tabletnode_uuid) {
     if (FLAGS_tera_master_tabletnode_timeout > 0) {
         MutexLock lock(&tabletnode_timer_mutex_);
-        std::map<std::string, int64_t>::iterator it =
+        boost::unordered_map<std::string, int64_t>::iterator it =
             tabletnode_timer_id_map_.find(tabletnode_addr);
         if (it != tabletnode_timer_id_map_.end()) {
             uint64_t timer_id = it->second;
@@ -2159,7 +2333,7 @@ void MasterImpl::TabletNodeRecoveryCallback(std::string addr,
     TryLeaveSafeMode();
 }
 
-void MasterImpl::RetryQueryNewTabletNode(std::string addr) {
+void MasterImpl::RetryQueryNewTabletNode(const std::string& addr) {
     QueryClosure* done =
         NewClosure(this, &MasterImpl::TabletNodeRecoveryCallback, addr);
     QueryTabletNodeAsync(addr, FLAGS_tera_master_collect_info_timeout, false, done);
@@ -2952,26 +3126,25 @@ void MasterImpl::GetSnapshot(const GetSnapshotRequest* request,
     task->done = done;
     task->table = table;
     task->task_num = 0;
-    task->finish_num = 0;
-    task->aborted = false;
-    task->mutex.Lock();
-    int64_t snapshot_id = get_micros();
-    for (uint32_t i = 0; i < task->tablets.size(); ++i) {
-        TabletPtr tablet = task->tablets[i];
+
+    // flip every tablet before the first rpc goes out, so task_num is
+    // final once the callbacks can run and they only need the counter
+    uint32_t flip_num = 0;
+    bool abort = false;
+    for (; flip_num < task->tablets.size(); ++flip_num) {
+        TabletPtr tablet = task->tablets[flip_num];
         if (!tablet->SetStatusIf(kTabletOnSnapshot, kTableReady)) {
             LOG(INFO) << "will not get snapshot, " << tablet->GetServerAddr()
                 << " is not ready";
-            task->aborted = true;
+            abort = true;
             break;
         }
         LOG(INFO) << "Set tablet kTabletOnSnapshot " << tablet->GetPath();
-        ++task->task_num;
-        SnapshotClosure* closure =
-            NewClosure(this, &MasterImpl::GetSnapshotCallback, static_cast<int32_t>(i), task);
-        GetSnapshotAsync(tablet, snapshot_id, 3000, closure);
     }
-    if (task->task_num == 0) {
-        task->mutex.Unlock();
+    if (abort || flip_num == 0) {
+        for (uint32_t i = 0; i < flip_num; ++i) {
+            task->tablets[i]->SetStatusIf(kTableReady, kTabletOnSnapshot);
+        }
         delete task;
         LOG(WARNING) << "fail to create snapshot: " << request->table_name()
             << ", all tables kTabletNodeOffLine";
@@ -2979,7 +3152,13 @@ void MasterImpl::GetSnapshot(const GetSnapshotRequest* request,
         done->Run();
         return;
     }
-    task->mutex.Unlock();
+    task->task_num = flip_num;
+    int64_t snapshot_id = get_micros();
+    for (uint32_t i = 0; i < task->tablets.size(); ++i) {
+        SnapshotClosure* closure =
+            NewClosure(this, &MasterImpl::GetSnapshotCallback, static_cast<int32_t>(i), task);
+        GetSnapshotAsync(task->tablets[i], snapshot_id, 3000, closure);
+    }
 }
 
 void MasterImpl::GetSnapshotAsync(TabletPtr tablet, int64_t snapshot_id, int32_t timeout,
@@ -3006,22 +3185,21 @@ void MasterImpl::GetSnapshotCallback(int32_t tablet_id,
                                      SnapshotRequest* master_request,
                                      SnapshotResponse* master_response, bool failed,
                                      int error_code) {
-    task->mutex.Lock();
-    ++task->finish_num;
+    if (!failed && master_response->status() == kTabletNodeOk) {
+        // each callback owns its own slot, no lock needed
+        task->snapshot_id[tablet_id] = master_response->snapshot_seq();
+    } else {
+        task->aborted.Inc();
+    }
     VLOG(6) << "MasterImpl GetSnapshot id= " << tablet_id
-        << " finish_num= " << task->finish_num
         << ". Return " << master_response->snapshot_seq();
-    if (task->finish_num != task->task_num) {
-        if (!failed && master_response->status() == kTabletNodeOk) {
-            task->snapshot_id[tablet_id] = master_response->snapshot_seq();
-        } else {
-            task->aborted = true;
-        }
-        task->mutex.Unlock();
+    // the last Inc is a full barrier, so the winner sees every slot
+    // and abort mark written above
+    if (task->finish_num.Inc() != task->task_num) {
         return;
     }
 
-    if (failed || task->aborted) {
+    if (0 != task->aborted.Get()) {
         LOG(WARNING) << "MasterImpl GetSnapshot fail done";
         for (uint32_t i = 0; i < task->tablets.size(); ++i) {
             VLOG(6) << "Set tablet kTabletOnSnapshot " << task->tablets[i]->GetPath();
@@ -3030,7 +3208,6 @@ void MasterImpl::GetSnapshotCallback(int32_t tablet_id,
         task->response->set_status(kTabletNodeOffLine);
         task->done->Run();
     } else {
-        task->snapshot_id[tablet_id] = master_response->snapshot_seq();
         LOG(INFO) << "MasterImpl GetSnapshot all tablet done";
         int sid = task->table->AddSnapshot(master_request->snapshot_id());
         for (uint32_t i = 0; i < task->tablets.size(); ++i) {
@@ -3045,7 +3222,6 @@ void MasterImpl::GetSnapshotCallback(int32_t tablet_id,
                     task->request, task->response, task->done);
         BatchWriteMetaTableAsync(task->table, task->tablets, false, closure);
     }
-    task->mutex.Unlock();
     delete task;
 }
 
@@ -3155,27 +3331,14 @@ void MasterImpl::GetRollback(const RollbackRequest* request,
     task->response = response;
     task->done = done;
     task->table = table;
-    task->task_num = 0;
-    task->finish_num = 0;
-    task->aborted = false;
-    task->mutex.Lock();
+    // task_num is final before the first rpc goes out, so the callbacks
+    // fan in on the bare counter
+    task->task_num = task->tablets.size();
     for (uint32_t i = 0; i < task->tablets.size(); ++i) {
-        TabletPtr tablet = task->tablets[i];
-        ++task->task_num;
         RollbackClosure* closure =
             NewClosure(this, &MasterImpl::RollbackCallback, static_cast<int32_t>(i), task);
-        RollbackAsync(tablet, request->snapshot_id(), 3000, closure);
-    }
-    if (task->task_num == 0) {
-        task->mutex.Unlock();
-        delete task;
-        LOG(WARNING) << "fail to rollback to snapshot: " << request->table_name()
-            << ", all tables kTabletNodeOffLine";
-        response->set_status(kTabletNodeOffLine);
-        done->Run();
-        return;
+        RollbackAsync(task->tablets[i], request->snapshot_id(), 3000, closure);
     }
-    task->mutex.Unlock();
 }
 
 void MasterImpl::RollbackAsync(TabletPtr tablet, uint64_t snapshot_id,
@@ -3200,26 +3363,25 @@ void MasterImpl::RollbackCallback(int32_t tablet_id, RollbackTask* task,
                                   SnapshotRollbackRequest* master_request,
                                   SnapshotRollbackResponse* master_response,
                                   bool failed, int error_code) {
-    MutexLock lock(&task->mutex);
-    ++task->finish_num;
+    if (!failed && master_response->status() == kTabletNodeOk) {
+        // each callback owns its own slot, no lock needed
+        task->rollback_points[tablet_id] = master_response->rollback_point();
+    } else {
+        task->aborted.Inc();
+    }
     VLOG(6) << "MasterImpl Rollback id= " << tablet_id
-        << " finish_num= " << task->finish_num
         << ". Return " << master_response->rollback_point();
-    if (task->finish_num != task->task_num) {
-        if (!failed && master_response->status() == kTabletNodeOk) {
-            task->rollback_points[tablet_id] = master_response->rollback_point();
-        } else {
-            task->aborted = true;
-        }
+    // the last Inc is a full barrier, so the winner sees every slot
+    // and abort mark written above
+    if (task->finish_num.Inc() != task->task_num) {
         return;
     }
 
-    if (failed || task->aborted) {
+    if (0 != task->aborted.Get()) {
         LOG(WARNING) << "MasterImpl Rollback fail done";
         task->response->set_status(kTabletNodeOffLine);
         task->done->Run();
     } else {
-        task->rollback_points[tablet_id] = master_response->rollback_point();
         LOG(INFO) << "MasterImpl rollback all tablet done";
         int sid = task->table->AddRollback(task->request->rollback_name());
         for (uint32_t i = 0; i < task->tablets.size(); ++i) {
@@ -3235,7 +3397,6 @@ void MasterImpl::RollbackCallback(int32_t tablet_id, RollbackTask* task,
                        task->request, task->response, task->done);
         BatchWriteMetaTableAsync(task->table, task->tablets, false, closure);
     }
-    task->mutex.Unlock();
     delete task;
 }
 
@@ -3406,7 +3567,7 @@ void MasterImpl::NoticeTabletNodeSchemaUpdated(TablePtr table) {
     }
 }
 
-void MasterImpl::QueryTabletNodeAsync(std::string addr, int32_t timeout,
+void MasterImpl::QueryTabletNodeAsync(const std::string& addr, int32_t timeout,
                                       bool is_gc, QueryClosure* done) {
     tabletnode::TabletNodeClient node_client(addr, timeout);
 
@@ -3420,7 +3581,12 @@ void MasterImpl::QueryTabletNodeAsync(std::string addr, int32_t timeout,
 
     VLOG(20) << "QueryAsync id: " << request->sequence_id() << ", "
         << "server: " << addr;
-    node_client.Query(query_thread_pool_.get(), request, response, done);
+    // direct submit runs the callback inline on the rpc io thread,
+    // saving a pool handoff per node at the price of occupying the
+    // reactor while the query result is digested
+    ThreadPool* query_pool = FLAGS_tera_master_query_direct_submit ?
+        NULL : GetQueryThreadPool(addr);
+    node_client.Query(query_pool, request, response, done);
 }
 
 void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request,
@@ -3501,9 +3667,8 @@ void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request
                                 << ", status: " << tablet->GetStatus();
                         }
                     } else {
-                        tablet->UpdateSize(meta);
-                        tablet->SetCounter(counter);
-                        tablet->SetCompactStatus(meta.compact_status());
+                        tablet->ApplyQueryReport(
+                            response->mutable_tabletmeta_list()->mutable_meta(i), counter);
                         ClearUnusedSnapshots(tablet, meta);
                     }
                 } else {
@@ -3585,6 +3750,9 @@ void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request
         LOG(INFO) << "query tabletnodes finish, id "
             << query_tabletnode_timer_id_
             << ", cost " << (get_micros() - start_query_time_) / 1000 << "ms." ;
+        if (FLAGS_tera_master_stat_table_enabled && stat_table_) {
+            FlushStatTable();
+        }
         {
             MutexLock locker(&mutex_);
             if (query_enabled_) {
@@ -3611,7 +3779,9 @@ void MasterImpl::QueryTabletNodeCallback(std::string addr, QueryRequest* request
 
 void MasterImpl::CollectTabletInfoCallback(std::string addr,
                                            std::vector<TabletMeta>* tablet_list,
-                                           sem_t* finish_counter, Mutex* mutex,
+                                           Counter* finish_counter,
+                                           AutoResetEvent* finish_event,
+                                           Mutex* mutex,
                                            QueryRequest* request,
                                            QueryResponse* response,
                                            bool failed, int error_code) {
@@ -3674,7 +3844,7 @@ void MasterImpl::CollectTabletInfoCallback(std::string addr,
         } else {
             ThreadPool::Task task =
                 boost::bind(&MasterImpl::RetryCollectTabletInfo, this, addr,
-                            tablet_list, finish_counter, mutex);
+                            tablet_list, finish_counter, finish_event, mutex);
             thread_pool_->DelayTask(FLAGS_tera_master_collect_info_retry_period,
                                      task);
             delete request;
@@ -3682,17 +3852,21 @@ void MasterImpl::CollectTabletInfoCallback(std::string addr,
             return;
         }
     }
-    sem_post(finish_counter);
+    if (0 == finish_counter->Dec()) {
+        finish_event->Set();
+    }
     delete request;
     delete response;
 }
 
-void MasterImpl::RetryCollectTabletInfo(std::string addr,
+void MasterImpl::RetryCollectTabletInfo(const std::string& addr,
                                         std::vector<TabletMeta>* tablet_list,
-                                        sem_t* finish_counter, Mutex* mutex) {
+                                        Counter* finish_counter,
+                                        AutoResetEvent* finish_event,
+                                        Mutex* mutex) {
     QueryClosure* done =
         NewClosure(this, &MasterImpl::CollectTabletInfoCallback, addr,
-                   tablet_list, finish_counter, mutex);
+                   tablet_list, finish_counter, finish_event, mutex);
     QueryTabletNodeAsync(addr, FLAGS_tera_master_collect_info_timeout, false, done);
 }
 
@@ -3987,7 +4161,7 @@ void MasterImpl::RetryUnloadTablet(TabletPtr tablet, int32_t retry_times) {
     UnloadTabletAsync(tablet, done);
 }
 
-bool MasterImpl::TrySplitTablet(TabletPtr tablet) {
+bool MasterImpl::TrySplitTablet(const TabletPtr& tablet) {
     const std::string& server_addr = tablet->GetServerAddr();
 
     // abort if server down
@@ -4016,8 +4190,13 @@ bool MasterImpl::TrySplitTablet(TabletPtr tablet) {
     return true;
 }
 
+Mutex* MasterImpl::GetTabletMutexShard(const std::string& table_name) {
+    uint32_t hash = leveldb::Hash(table_name.data(), table_name.size(), 0);
+    return &tablet_mutex_shards_[hash % kTabletMutexShardNum];
+}
+
 bool MasterImpl::TryMergeTablet(TabletPtr tablet) {
-    MutexLock lock(&tablet_mutex_);
+    MutexLock lock(GetTabletMutexShard(tablet->GetTableName()));
     const std::string& server_addr = tablet->GetServerAddr();
 
     // abort if server down
@@ -4275,6 +4454,7 @@ void MasterImpl::BatchWriteMetaTableAsync(TablePtr table,
                                           const std::vector<TabletPtr>& tablets,
                                           bool is_delete, WriteClosure* done) {
     std::vector<ToMetaFunc> meta_entries;
+    meta_entries.reserve(tablets.size() + 1);
     TablePtr null_ptr;
     if (table != null_ptr) {
         meta_entries.push_back(boost::bind(&Table::ToMetaTableKeyValue, table, _1, _2));
@@ -4287,7 +4467,7 @@ void MasterImpl::BatchWriteMetaTableAsync(TablePtr table,
     BatchWriteMetaTableAsync(meta_entries, is_delete, done);
 }
 
-void MasterImpl::BatchWriteMetaTableAsync(std::vector<ToMetaFunc> meta_entries,
+void MasterImpl::BatchWriteMetaTableAsync(const std::vector<ToMetaFunc>& meta_entries,
                                           bool is_delete, WriteClosure* done) {
     VLOG(5) << "WriteMetaTableAsync()";
     std::string meta_addr;
@@ -4327,6 +4507,49 @@ void MasterImpl::BatchWriteMetaTableAsync(std::vector<ToMetaFunc> meta_entries,
     meta_node_client.WriteTablet(request, response, done);
 }
 
+void MasterImpl::BatchWriteMetaTableFusedAsync(const std::vector<ToMetaFunc>& meta_entries,
+                                               bool is_delete,
+                                               const std::vector<WriteClosure*>& dones) {
+    CHECK_GT(dones.size(), 0u);
+    if (dones.size() == 1) {
+        BatchWriteMetaTableAsync(meta_entries, is_delete, dones[0]);
+        return;
+    }
+    WriteClosure* done =
+        NewClosure(this, &MasterImpl::MetaWriteFusedCallback, dones);
+    BatchWriteMetaTableAsync(meta_entries, is_delete, done);
+}
+
+void MasterImpl::MetaWriteFusedCallback(std::vector<WriteClosure*> dones,
+                                        WriteTabletRequest* request,
+                                        WriteTabletResponse* response,
+                                        bool failed, int error_code) {
+    // the fused rows may carry different statuses, but every suspended
+    // operation expects the "all rows the same" contract of its private
+    // rpc, so collapse the batch to its worst row status; on any failure
+    // each operation retries through its own callback, which is safe
+    // because meta puts and deletes are idempotent
+    StatusCode row_status = kTabletNodeOk;
+    for (int32_t i = 0; i < response->row_status_list_size(); ++i) {
+        if (response->row_status_list(i) != kTabletNodeOk) {
+            row_status = response->row_status_list(i);
+            break;
+        }
+    }
+    for (size_t i = 0; i < dones.size(); ++i) {
+        // each callback deletes the pair it is given, so hand out copies;
+        // none of them reads the request payload back
+        WriteTabletRequest* sub_request = new WriteTabletRequest;
+        sub_request->set_sequence_id(request->sequence_id());
+        WriteTabletResponse* sub_response = new WriteTabletResponse;
+        sub_response->set_status(response->status());
+        sub_response->add_row_status_list(row_status);
+        dones[i]->Run(sub_request, sub_response, failed, error_code);
+    }
+    delete request;
+    delete response;
+}
+
 void MasterImpl::AddMetaCallback(TablePtr table,
                                  std::vector<TabletPtr> tablets,
                                  int32_t retry_times,
@@ -4544,7 +4767,7 @@ void MasterImpl::UpdateTableRecordForUpdateCallback(TablePtr table, int32_t retr
     }
 }
 
-bool MasterImpl::IsUpdateCf(TablePtr table) {
+bool MasterImpl::IsUpdateCf(const TablePtr& table) {
     TableSchema schema;
     if (table->GetOldSchema(&schema)) {
         return IsSchemaCfDiff(table->GetSchema(), schema);
@@ -4591,12 +4814,7 @@ void MasterImpl::UpdateTableRecordForRenameCallback(TablePtr table, int32_t retr
         }
         return;
     }
-    {
-        MutexLock locker(&alias_mutex_);
-        const std::string& internal_table_name = table->GetSchema().name();
-        alias_[new_alias] =  internal_table_name;
-        alias_.erase(old_alias);
-    }
+    UpdateAliasMap(new_alias, table->GetSchema().name(), old_alias);
     LOG(INFO) << "Rename done. update meta table success, " << table;
     rpc_response->set_status(kMasterOk);
     rpc_done->Run();
@@ -4739,8 +4957,7 @@ void MasterImpl::DeleteTableCallback(TablePtr table,
     }
     std::string table_alias = table->GetSchema().alias();
     if (!table_alias.empty()) {
-        MutexLock locker(&alias_mutex_);
-        alias_.erase(table_alias);
+        UpdateAliasMap("", "", table_alias);
     }
     // clean tablet manager
     for (uint32_t i = 0; i < tablets.size(); ++i) {
@@ -4753,7 +4970,7 @@ void MasterImpl::DeleteTableCallback(TablePtr table,
     rpc_done->Run();
 }
 
-void MasterImpl::DeleteTablet(TabletPtr tablet) {
+void MasterImpl::DeleteTablet(const TabletPtr& tablet) {
     tablet_manager_->DeleteTablet(tablet->GetTableName(), tablet->GetKeyStart());
     tablet_availability_->EraseNotReadyTablet(tablet->GetPath());
 }
@@ -4981,6 +5198,7 @@ void MasterImpl::RepairMetaAfterSplitCallback(TabletPtr tablet,
 void MasterImpl::SuspendMetaOperation(TablePtr table, const std::vector<TabletPtr>& tablets,
                                       bool is_delete, WriteClosure* done) {
     std::vector<ToMetaFunc> meta_entries;
+    meta_entries.reserve(tablets.size() + 1);
     TablePtr null_ptr;
     if (table != null_ptr) {
         meta_entries.push_back(boost::bind(&Table::ToMetaTableKeyValue, table, _1, _2));
@@ -5003,7 +5221,8 @@ void MasterImpl::SuspendMetaOperation(std::vector<ToMetaFunc> meta_entries,
     WriteTask* task = new WriteTask;
     task->type_ = kWrite;
     task->done_ = done;
-    task->meta_entries_ = meta_entries;
+    // steal the caller's copy instead of copying the boost::functions again
+    task->meta_entries_.swap(meta_entries);
     task->is_delete_ = is_delete;
     PushToMetaPendingQueue((MetaTask*)task);
 }
@@ -5049,29 +5268,68 @@ void MasterImpl::PushToMetaPendingQueue(MetaTask* task) {
 }
 
 void MasterImpl::ResumeMetaOperation() {
+    // swap the pending queue out under the lock and replay it unlocked, so
+    // producers in SuspendMetaOperation never wait behind the meta RPCs
+    // issued here; a task queued during the replay re-arms the reload path
+    // in PushToMetaPendingQueue and is picked up by the next resume
+    std::queue<MetaTask*> pending_tasks;
     meta_task_mutex_.Lock();
-    while (!meta_task_queue_.empty()) {
-        MetaTask* task = meta_task_queue_.front();
+    pending_tasks.swap(meta_task_queue_);
+    meta_task_mutex_.Unlock();
+    // consecutive write tasks are fused into one multi-row rpc; scans and
+    // repairs flush the pending batch first so queue order is preserved
+    std::vector<ToMetaFunc> fused_entries;
+    std::vector<WriteClosure*> fused_dones;
+    bool fused_is_delete = false;
+    while (!pending_tasks.empty()) {
+        MetaTask* task = pending_tasks.front();
         if (task->type_ == kWrite) {
             WriteTask* write_task = (WriteTask*)task;
-            BatchWriteMetaTableAsync(write_task->meta_entries_,
-                                     write_task->is_delete_, write_task->done_);
+            if (!fused_dones.empty() &&
+                (fused_is_delete != write_task->is_delete_ ||
+                 fused_entries.size() >=
+                     (size_t)FLAGS_tera_master_meta_write_fuse_max_num)) {
+                BatchWriteMetaTableFusedAsync(fused_entries, fused_is_delete,
+                                              fused_dones);
+                fused_entries.clear();
+                fused_dones.clear();
+            }
+            fused_is_delete = write_task->is_delete_;
+            fused_entries.insert(fused_entries.end(),
+                                 write_task->meta_entries_.begin(),
+                                 write_task->meta_entries_.end());
+            fused_dones.push_back(write_task->done_);
             delete write_task;
         } else if (task->type_ == kScan) {
+            if (!fused_dones.empty()) {
+                BatchWriteMetaTableFusedAsync(fused_entries, fused_is_delete,
+                                              fused_dones);
+                fused_entries.clear();
+                fused_dones.clear();
+            }
             ScanTask* scan_task = (ScanTask*)task;
             ScanMetaTableAsync(scan_task->table_name_,
                                scan_task->tablet_key_start_,
                                scan_task->tablet_key_end_, scan_task->done_);
             delete scan_task;
         } else if (task->type_ == kRepair) {
+            if (!fused_dones.empty()) {
+                BatchWriteMetaTableFusedAsync(fused_entries, fused_is_delete,
+                                              fused_dones);
+                fused_entries.clear();
+                fused_dones.clear();
+            }
             RepairTask* repair_task = (RepairTask*)task;
             RepairMetaTableAsync(repair_task->tablet_, repair_task->scan_resp_,
                                  repair_task->done_);
             delete repair_task;
         }
-        meta_task_queue_.pop();
+        pending_tasks.pop();
+    }
+    if (!fused_dones.empty()) {
+        BatchWriteMetaTableFusedAsync(fused_entries, fused_is_delete,
+                                      fused_dones);
     }
-    meta_task_mutex_.Unlock();
 }
 
 void MasterImpl::TryMoveTablet(TabletPtr tablet, const std::string& server_addr, bool in_place) {
@@ -5094,14 +5352,14 @@ void MasterImpl::TryMoveTablet(TabletPtr tablet, const std::string& server_addr,
     }
 }
 
-void MasterImpl::ProcessOffLineTablet(TabletPtr tablet) {
+void MasterImpl::ProcessOffLineTablet(const TabletPtr& tablet) {
     if (!tablet->IsBound()) {
         return;
     }
     tablet->SetStatusIf(kTabletDisable, kTableOffLine, kTableDisable);
 }
 
-void MasterImpl::ProcessReadyTablet(TabletPtr tablet) {
+void MasterImpl::ProcessReadyTablet(const TabletPtr& tablet) {
     if (tablet->SetStatusIf(kTableUnLoading, kTableReady, kTableDisable)) {
         UnloadClosure* done =
             NewClosure(this, &MasterImpl::UnloadTabletCallback, tablet,
@@ -5167,7 +5425,33 @@ void MasterImpl::DumpTabletNodeAddrToTable(const std::string& addr) {
     RowMutation* mutation = stat_table_->NewRowMutation(key);
     mutation->Put("tsinfo", "", "");
     mutation->SetCallBack(&DumpStatCallBack);
-    stat_table_->ApplyMutation(mutation);
+    AddStatMutation(mutation);
+}
+
+void MasterImpl::AddStatMutation(RowMutation* mutation) {
+    std::vector<RowMutation*> batch;
+    {
+        MutexLock lock(&stat_table_mutex_);
+        stat_mutation_buffer_.push_back(mutation);
+        if (stat_mutation_buffer_.size() <
+                (size_t)FLAGS_tera_master_stat_table_batch_num) {
+            return;
+        }
+        batch.swap(stat_mutation_buffer_);
+    }
+    stat_table_->ApplyMutation(batch);
+}
+
+void MasterImpl::FlushStatTable() {
+    std::vector<RowMutation*> batch;
+    {
+        MutexLock lock(&stat_table_mutex_);
+        if (stat_mutation_buffer_.empty()) {
+            return;
+        }
+        batch.swap(stat_mutation_buffer_);
+    }
+    stat_table_->ApplyMutation(batch);
 }
 
 void MasterImpl::DumpStatToTable(const TabletNode& stat) {
@@ -5196,7 +5480,7 @@ void MasterImpl::DumpStatToTable(const TabletNode& stat) {
     RowMutation* mutation = stat_table_->NewRowMutation(key);
     mutation->Put("tsinfo", "", value);
     mutation->SetCallBack(&DumpStatCallBack);
-    stat_table_->ApplyMutation(mutation);
+    AddStatMutation(mutation);
 }
 
 void MasterImpl::ScheduleTabletNodeGc() {
@@ -5228,13 +5512,15 @@ void MasterImpl::ScheduleAvailableCheck() {
     mutex_.AssertHeld();
     ThreadPool::Task task =
         boost::bind(&MasterImpl::DoAvailableCheck, this);
-    thread_pool_->DelayTask(
+    available_check_timer_id_ = thread_pool_->DelayTask(
         FLAGS_tera_master_availability_check_period * 1000, task);
 }
 
 void MasterImpl::EnableAvailabilityCheck() {
     MutexLock lock(&mutex_);
-    ScheduleAvailableCheck();
+    if (available_check_timer_id_ == kInvalidTimerId) {
+        ScheduleAvailableCheck();
+    }
 }
 
 void MasterImpl::DisableTabletNodeGcTimer() {
@@ -5305,13 +5591,13 @@ void MasterImpl::RenameTable(const RenameTableRequest* request,
     std::string internal_table_name;
 
     {
-        MutexLock locker(&alias_mutex_);
-        if (alias_.find(old_alias) == alias_.end()) {
+        AliasMapPtr alias_map = GetAliasMap();
+        if (alias_map->find(old_alias) == alias_map->end()) {
             LOG(ERROR) << "Fail to reanme, " << old_alias << " not exist";
             response->set_status(kTableNotExist);
             done->Run();
             return;
-        } else if (alias_.find(new_alias) != alias_.end()) {
+        } else if (alias_map->find(new_alias) != alias_map->end()) {
             LOG(ERROR) << "Fail to rename, " << new_alias << "already exist";
             response->set_status(kTableExist);
             done->Run();
@@ -5328,7 +5614,7 @@ void MasterImpl::RenameTable(const RenameTableRequest* request,
             done->Run();
             return;
         } else {
-            internal_table_name = alias_[old_alias];
+            internal_table_name = alias_map->find(old_alias)->second;
         }
     }
 
@@ -5377,9 +5663,17 @@ void MasterImpl::RefreshTableCounter() {
         << ((get_micros() - start) / 1000) << "ms.";
 }
 
+ThreadPool* MasterImpl::GetQueryThreadPool(const std::string& addr) {
+    uint32_t hash = leveldb::Hash(addr.data(), addr.size(), 0);
+    return query_thread_pools_[hash % query_thread_pools_.size()].get();
+}
+
 std::string MasterImpl::ProfilingLog() {
-    return "[main : " + thread_pool_->ProfilingLog() + "] [query : "
-        + query_thread_pool_->ProfilingLog() + "]";
+    std::string log = "[main : " + thread_pool_->ProfilingLog() + "]";
+    for (size_t i = 0; i < query_thread_pools_.size(); ++i) {
+        log += " [query : " + query_thread_pools_[i]->ProfilingLog() + "]";
+    }
+    return log;
 }
 
 } // namespace master
@@ -6,10 +6,11 @@
 #define TERA_MASTER_MASTER_IMPL_H_
 
 #include <stdint.h>
-#include <semaphore.h>
 #include <string>
 #include <vector>
 
+#include <boost/unordered_map.hpp>
+
 #include "common/event.h"
 #include "common/base/scoped_ptr.h"
 #include "common/mutex.h"
@@ -167,6 +168,8 @@ private:
     typedef Closure<void, ScanTabletRequest*, ScanTabletResponse*, bool, int> ScanClosure;
     typedef boost::function<void (std::string*, std::string*)> ToMetaFunc;
     typedef boost::shared_ptr<Mutex> MutexPtr;
+    typedef boost::unordered_map<std::string, std::string> AliasMap;
+    typedef boost::shared_ptr<const AliasMap> AliasMapPtr;
 
     enum MetaTaskType {
         kWrite = 0,
@@ -202,10 +205,11 @@ private:
         TablePtr table;
         std::vector<TabletPtr> tablets;
         std::vector<uint64_t> snapshot_id;
+        // task_num is fixed before any rpc is issued, so the callbacks
+        // fan in on a bare counter instead of a per-task mutex
         int task_num;
-        int finish_num;
-        mutable Mutex mutex;
-        bool aborted;
+        Counter finish_num;
+        Counter aborted;
     };
 
     struct RollbackTask {
@@ -216,9 +220,8 @@ private:
         std::vector<TabletPtr> tablets;
         std::vector<uint64_t> rollback_points;
         int task_num;
-        int finish_num;
-        mutable Mutex mutex;
-        bool aborted;
+        Counter finish_num;
+        Counter aborted;
     };
 
     struct MergeParam {
@@ -227,6 +230,19 @@ private:
         MergeParam(MutexPtr mu, TabletPtr tb) : mutex(mu), counter_part(tb) {}
     };
 
+    // shared state of one load-balance pass; lives on the stack of
+    // LoadBalance() and outlives the per-node tasks through the latch
+    struct LoadBalanceContext {
+        Scheduler* scheduler;
+        std::map<std::string, std::vector<TabletPtr> >* node_tablet_list;
+        std::string table_name;
+        uint32_t max_move_num;
+        Counter move_count;        // move tickets taken, capped at max_move_num
+        Counter round_move_count;  // moves committed in the current round
+        Counter pending_count;
+        AutoResetEvent done_event;
+    };
+
     void SafeModeCmdCtrl(const CmdCtrlRequest* request,
                          CmdCtrlResponse* response);
     void ReloadConfig(CmdCtrlResponse* response);
@@ -244,13 +260,15 @@ private:
                           const std::string& key_start,
                           const std::string& key_end,
                           const std::string& server_addr, StatusCode* status);
-    void UnloadTabletAsync(std::string table_name, std::string key_start,
-                           std::string server_addr, int32_t retry);
+    void UnloadTabletAsync(const std::string& table_name,
+                           const std::string& key_start,
+                           const std::string& server_addr, int32_t retry);
 
     void RetryLoadTablet(TabletPtr tablet, int32_t retry_times);
     void RetryUnloadTablet(TabletPtr tablet, int32_t retry_times);
-    bool TrySplitTablet(TabletPtr tablet);
+    bool TrySplitTablet(const TabletPtr& tablet);
     bool TryMergeTablet(TabletPtr tablet);
+    Mutex* GetTabletMutexShard(const std::string& table_name);
     void TryMoveTablet(TabletPtr tablet, const std::string& server_addr = "", bool in_place = false);
 
     void TryReleaseCache(bool enbaled_debug = false);
@@ -296,6 +314,8 @@ private:
     bool TabletNodeLoadBalance(TabletNodePtr tabletnode, Scheduler* scheduler,
                                const std::vector<TabletPtr>& tablet_list,
                                const std::string& table_name = "");
+    void TabletNodeLoadBalanceTask(TabletNodePtr node_copy,
+                                   LoadBalanceContext* ctx);
 
     void GetSnapshotAsync(TabletPtr tablet, int64_t snapshot_id, int32_t timeout,
                           SnapshotClosure* done);
@@ -339,8 +359,9 @@ private:
 
     void ScheduleQueryTabletNode();
     void QueryTabletNode();
-    void QueryTabletNodeAsync(std::string addr, int32_t timeout,
+    void QueryTabletNodeAsync(const std::string& addr, int32_t timeout,
                               bool is_gc, QueryClosure* done);
+    ThreadPool* GetQueryThreadPool(const std::string& addr);
 
     void ReleaseSnpashot(TabletPtr tablet, uint64_t snapshot);
     void ReleaseSnapshotCallback(ReleaseSnapshotRequest* request,
@@ -353,17 +374,23 @@ private:
                                  int error_code);
     void CollectTabletInfoCallback(std::string addr,
                                    std::vector<TabletMeta>* tablet_list,
-                                   sem_t* finish_counter, Mutex* mutex,
+                                   Counter* finish_counter,
+                                   AutoResetEvent* finish_event, Mutex* mutex,
                                    QueryRequest* request,
                                    QueryResponse* response, bool failed,
                                    int error_code);
     void TabletNodeRecoveryCallback(std::string addr, QueryRequest* request,
                                     QueryResponse* response, bool failed,
                                     int error_code);
-    void RetryCollectTabletInfo(std::string addr,
+    // the retry tasks are posted through boost::bind, which keeps its own
+    // copy of addr, so const-ref is safe here; the *Callback methods above
+    // stay by-value because NewClosure stores pre-bound arguments as the
+    // declared parameter type
+    void RetryCollectTabletInfo(const std::string& addr,
                                 std::vector<TabletMeta>* tablet_list,
-                                sem_t* finish_counter, Mutex* mutex);
-    void RetryQueryNewTabletNode(std::string addr);
+                                Counter* finish_counter,
+                                AutoResetEvent* finish_event, Mutex* mutex);
+    void RetryQueryNewTabletNode(const std::string& addr);
 
     void SplitTabletAsync(TabletPtr tablet);
     void SplitTabletCallback(TabletPtr tablet, SplitTabletRequest* request,
@@ -381,11 +408,18 @@ private:
     void MergeTabletFailed(TabletPtr tablet_p1, TabletPtr tablet_p2);
 
     void BatchWriteMetaTableAsync(ToMetaFunc meta_entry, bool is_delete, WriteClosure* done);
-    void BatchWriteMetaTableAsync(std::vector<ToMetaFunc> meta_entries,
+    void BatchWriteMetaTableAsync(const std::vector<ToMetaFunc>& meta_entries,
                                   bool is_delete, WriteClosure* done);
     void BatchWriteMetaTableAsync(TablePtr table,
                                   const std::vector<TabletPtr>& tablets,
                                   bool is_delete, WriteClosure* done);
+    void BatchWriteMetaTableFusedAsync(const std::vector<ToMetaFunc>& meta_entries,
+                                       bool is_delete,
+                                       const std::vector<WriteClosure*>& dones);
+    void MetaWriteFusedCallback(std::vector<WriteClosure*> dones,
+                                WriteTabletRequest* request,
+                                WriteTabletResponse* response,
+                                bool failed, int error_code);
     void AddMetaCallback(TablePtr table, std::vector<TabletPtr> tablets,
                          int32_t retry_times,
                          const CreateTableRequest* rpc_request,
@@ -482,11 +516,12 @@ private:
     // load metabale to master memory
     bool LoadMetaTable(const std::string& meta_tablet_addr,
                        StatusCode* ret_status);
+    void ParseMetaBatchTask(ScanTabletResponse* response,
+                            AutoResetEvent* parse_event);
     bool LoadMetaTableFromFile(const std::string& filename,
                                StatusCode* ret_status = NULL);
-    bool ReadFromStream(std::ifstream& ifs,
-                        std::string* key,
-                        std::string* value);
+    bool ParseMetaRecord(const char** pos, const char* end,
+                         std::string* key, std::string* value);
 
     // load metatable on a tabletserver
     bool LoadMetaTablet(std::string* server_addr);
@@ -530,8 +565,8 @@ private:
                               WriteClosure* done);
     void PushToMetaPendingQueue(MetaTask* task);
     void ResumeMetaOperation();
-    void ProcessOffLineTablet(TabletPtr tablet);
-    void ProcessReadyTablet(TabletPtr tablet);
+    void ProcessOffLineTablet(const TabletPtr& tablet);
+    void ProcessReadyTablet(const TabletPtr& tablet);
 
     bool CheckStatusSwitch(MasterStatus old_status, MasterStatus new_status);
 
@@ -540,6 +575,8 @@ private:
     static void DumpStatCallBack(RowMutation* mutation);
     void DumpTabletNodeAddrToTable(const std::string& addr);
     void DumpStatToTable(const TabletNode& stat);
+    void AddStatMutation(RowMutation* mutation);
+    void FlushStatTable();
 
     // garbage clean
     void EnableTabletNodeGcTimer();
@@ -552,6 +589,13 @@ private:
 
     bool CheckUserPermissionOnTable(const std::string& token, TablePtr table);
 
+    // non-template core shared by every rpc type; the templated wrappers
+    // below shrink to argument plumbing, so only this body exists once
+    bool HasPermissionOnTable(bool has_user_token,
+                              const std::string& user_token, TablePtr table);
+    void LogNoPermission(bool has_user_token, const std::string& user_token,
+                         const char* operate);
+
     template <typename Request>
     bool HasPermissionOnTable(const Request* request, TablePtr table);
 
@@ -560,14 +604,18 @@ private:
                                Callback* done, TablePtr table, const char* operate);
 
     void FillAlias(const std::string& key, const std::string& value);
+    AliasMapPtr GetAliasMap();
+    void UpdateAliasMap(const std::string& add_alias,
+                        const std::string& table_name,
+                        const std::string& del_alias);
     void RefreshTableCounter();
 
     void DoAvailableCheck();
     void ScheduleAvailableCheck();
     void EnableAvailabilityCheck();
-    void DeleteTablet(TabletPtr tablet);
-    void CopyTableMetaToUser(TablePtr table, TableMeta* meta_ptr);
-    bool IsUpdateCf(TablePtr table);
+    void DeleteTablet(const TabletPtr& tablet);
+    void CopyTableMetaToUser(const TablePtr& table, TableMeta* meta_ptr);
+    bool IsUpdateCf(const TablePtr& table);
 
 private:
     mutable Mutex status_mutex_;
@@ -585,13 +633,25 @@ private:
 
     Mutex mutex_;
     int64_t release_cache_timer_id_;
+    // stays a Counter: Inc() is a bare lock-xadd (what a relaxed
+    // fetch_add compiles to on x86) and TabletManager shares the id
+    // generator through a Counter*
     Counter this_sequence_id_;
 
     bool query_enabled_;
-    scoped_ptr<ThreadPool> query_thread_pool_;
+    // query callbacks are sharded by tabletnode address, so one node's
+    // responses always run on the same pool and its tablet list stays
+    // hot in that worker's cache
+    std::vector<boost::shared_ptr<ThreadPool> > query_thread_pools_;
     int64_t start_query_time_;
     int64_t query_tabletnode_timer_id_;
+    // the latch must stay a single counter (the last callback out turns
+    // off the light), so instead of sharding it, keep it on its own
+    // cacheline: every callback decrements it, while the neighbours
+    // above are read-mostly
+    char query_pending_pad0_[64];
     Counter query_pending_count_;
+    char query_pending_pad1_[64 - sizeof(Counter)];
 
     bool load_balance_scheduled_;
     bool load_balance_enabled_;
@@ -602,25 +662,39 @@ private:
     mutable Mutex meta_task_mutex_;
     std::queue<MetaTask*> meta_task_queue_;
 
+    // addr-keyed lookup tables below are never walked in order, so hash
+    // maps save the string tree-compares on every query tick
     mutable Mutex tabletnode_timer_mutex_;
-    std::map<std::string, int64_t> tabletnode_timer_id_map_;
+    boost::unordered_map<std::string, int64_t> tabletnode_timer_id_map_;
 
-    mutable Mutex tablet_mutex_;
+    // merge candidacy checks only race within one table, so the merge
+    // mutex is sharded by table name to keep concurrent merges on
+    // different tables from serializing on a single global lock
+    static const uint32_t kTabletMutexShardNum = 64;
+    mutable Mutex tablet_mutex_shards_[kTabletMutexShardNum];
 
     TabletPtr meta_tablet_;
 
     // stat table
     bool is_stat_table_;
-    std::map<std::string, int64_t> ts_stat_update_time_;
+    boost::unordered_map<std::string, int64_t> ts_stat_update_time_;
     mutable Mutex stat_table_mutex_;
     TableImpl* stat_table_;
+    // write-behind buffer: stat mutations collected during a query sweep
+    // go out in one ApplyMutation batch instead of one rpc per node
+    std::vector<RowMutation*> stat_mutation_buffer_;
 
     // tabletnode garbage clean
     bool gc_enabled_;
     int64_t gc_timer_id_;
     bool gc_query_enable_;
+    // availability check timer follows the gc/query timer-id pattern so a
+    // repeated enable cannot start a second self-rescheduling chain
+    int64_t available_check_timer_id_;
     boost::shared_ptr<GcStrategy> gc_strategy_;
-    std::map<std::string, std::string> alias_;
+    // copy-on-write: readers atomic_load the snapshot and look up without
+    // a lock; alias_mutex_ only serializes the rare writers
+    AliasMapPtr alias_;
     mutable Mutex alias_mutex_;
 
     boost::shared_ptr<TabletAvailability> tablet_availability_;
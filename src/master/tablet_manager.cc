@@ -4,9 +4,12 @@
 
 #include "master/tablet_manager.h"
 
-#include <fstream>
+#include <errno.h>
+#include <fcntl.h>
 #include <limits>
 #include <string>
+#include <string.h>
+#include <unistd.h>
 #include <vector>
 
 #include <gflags/gflags.h>
@@ -26,6 +29,7 @@
 #include "proto/proto_helper.h"
 #include "proto/tabletnode_client.h"
 #include "types.h"
+#include "util/hash.h"
 #include "utils/string_util.h"
 
 DECLARE_string(tera_working_dir);
@@ -43,6 +47,80 @@ DECLARE_string(tera_tabletnode_path_prefix);
 namespace tera {
 namespace master {
 
+namespace {
+
+// legal tablet status transitions as a bitmap: bit (new - MIN) of
+// allowed_[old - MIN] is set iff the switch is valid, so the check on
+// every lifecycle event is one shift and AND instead of a branch
+// cascade the predictor has to relearn per transition pair
+class TabletStatusSwitchTable {
+public:
+    TabletStatusSwitchTable() {
+        memset(allowed_, 0, sizeof(allowed_));
+        Allow(kTableNotInit, kTableReady);          // tablet is loaded when master up
+        Allow(kTableNotInit, kTableOffLine);        // tablet is unload when master up
+        Allow(kTableReady, kTabletPending);         // tabletnode down
+        Allow(kTableReady, kTableOffLine);          // tabletnode down (move immidiately)
+        Allow(kTableReady, kTableUnLoading);        // ready to move tablet
+        Allow(kTableReady, kTableOnSplit);          // begin to split
+        Allow(kTableReady, kTabletOnSnapshot);
+        Allow(kTableReady, kTabletDelSnapshot);
+        Allow(kTabletOnSnapshot, kTableReady);
+        Allow(kTabletDelSnapshot, kTableReady);
+        Allow(kTableOnLoad, kTableReady);           // load succe
+        Allow(kTableOnLoad, kTableOffLine);         // tabletnode down
+        Allow(kTableOnLoad, kTableLoadFail);        // don't know result, wait tabletnode to be killed
+        Allow(kTableLoadFail, kTableOffLine);       // tabletnode is killed
+        Allow(kTableOnSplit, kTableReady);          // request rejected
+        Allow(kTableOnSplit, kTableOffLine);        // split fail
+        Allow(kTableOnSplit, kTableSplitFail);      // don't know result, wait tabletnode to be killed
+        Allow(kTableSplitFail, kTableOnSplit);      // tabletnode is killed, ready to scan meta
+        Allow(kTabletPending, kTableReady);         // tabletnode up
+        Allow(kTabletPending, kTableOffLine);       // tabletnode down timeout
+        Allow(kTableOffLine, kTableReady);          // tabletnode up
+        Allow(kTableOffLine, kTableOnLoad);         // begin to load
+        Allow(kTableOffLine, kTabletPending);       // tabletnode down before load
+        Allow(kTableOffLine, kTabletDisable);       // table is disabled
+        Allow(kTableUnLoading, kTableOffLine);      // unload succe
+        Allow(kTableUnLoading, kTableReady);        // unload status rollback when merge failed
+        Allow(kTableUnLoading, kTableOnMerge);      // unload success, ready to merge phase2
+        Allow(kTableUnLoading, kTableUnLoadFail);   // don't know result, wait tabletnode to be killed
+        Allow(kTableUnLoadFail, kTableOffLine);     // tabletnode is killed, ready to load
+        Allow(kTableUnLoadFail, kTableOnMerge);     // tabletnode is killed, ready to merge phase2
+        Allow(kTableOnMerge, kTableOffLine);        // merge failed, ready to reload
+        Allow(kTabletDisable, kTableOffLine);
+    }
+
+    bool IsAllowed(TabletStatus old_status, TabletStatus new_status) const {
+        uint32_t old_index = old_status - TabletStatus_MIN;
+        uint32_t new_index = new_status - TabletStatus_MIN;
+        if (old_index >= kStatusNum || new_index >= kStatusNum) {
+            return false;
+        }
+        return (allowed_[old_index] >> new_index) & 1;
+    }
+
+private:
+    static const uint32_t kStatusNum = TabletStatus_MAX - TabletStatus_MIN + 1;
+
+    void Allow(TabletStatus old_status, TabletStatus new_status) {
+        allowed_[old_status - TabletStatus_MIN] |=
+            1ull << (new_status - TabletStatus_MIN);
+    }
+
+    uint64_t allowed_[kStatusNum];
+};
+
+const TabletStatusSwitchTable status_switch_table;
+
+// merge state is live on at most a handful of tablets at any moment,
+// so it sits in a sparse side map instead of costing every Tablet a
+// pointer; merges are rare enough that one mutex over the map is fine
+Mutex merge_param_mutex;
+std::map<const Tablet*, void*> merge_param_map;
+
+} // namespace
+
 std::ostream& operator << (std::ostream& o, const Tablet& tablet) {
     MutexLock lock(&tablet.mutex_);
     o << "table: " << tablet.meta_.table_name() << ", range: ["
@@ -60,22 +138,33 @@ std::ostream& operator << (std::ostream& o, const TabletPtr& tablet) {
 }
 
 Tablet::Tablet(const TabletMeta& meta)
-    : meta_(meta),
+    : refs_(0),
+      meta_(meta),
+      status_hint_(meta.status()),
+      server_addr_hash_(HashServerAddr(meta.server_addr())),
       update_time_(common::timer::get_micros()),
       load_time_(std::numeric_limits<int64_t>::max()),
-      merge_param_(NULL) {}
+      counter_seq_(0) {}
 
 Tablet::Tablet(const TabletMeta& meta, TablePtr table)
-    : meta_(meta),
+    : refs_(0),
+      meta_(meta),
+      status_hint_(meta.status()),
+      server_addr_hash_(HashServerAddr(meta.server_addr())),
       table_(table),
       update_time_(common::timer::get_micros()),
       load_time_(std::numeric_limits<int64_t>::max()),
-      merge_param_(NULL) {}
+      counter_seq_(0) {}
 
 Tablet::~Tablet() {
+    SetMergeParam(NULL);
     table_.reset();
 }
 
+uint32_t Tablet::HashServerAddr(const std::string& server_addr) {
+    return leveldb::Hash(server_addr.data(), server_addr.size(), 0);
+}
+
 void Tablet::ToMeta(TabletMeta* meta) {
     MutexLock lock(&mutex_);
     meta->CopyFrom(meta_);
@@ -91,7 +180,7 @@ const std::string& Tablet::GetServerAddr() {
     return meta_.server_addr();
 }
 
-std::string Tablet::GetServerId() {
+const std::string& Tablet::GetServerId() {
     MutexLock lock(&mutex_);
     return server_id_;
 }
@@ -144,23 +233,40 @@ const TableSchema& Tablet::GetSchema() {
     return table_->GetSchema();
 }
 
-const TabletCounter& Tablet::GetCounter() {
-    MutexLock lock(&mutex_);
-    if (counter_list_.size() > 0) {
-        return counter_list_.back();
-    } else {
-        return average_counter_;
+TabletCounter Tablet::GetCounter() {
+    TabletCounter counter;
+    while (true) {
+        int seq = counter_seq_;
+        if (!(seq & 1)) {
+            counter.CopyFrom(last_counter_);
+            if (seq == counter_seq_) {
+                break;
+            }
+        }
     }
+    return counter;
 }
 
-const TabletCounter& Tablet::GetAverageCounter() {
-    MutexLock lock(&mutex_);
-    return average_counter_;
+TabletCounter Tablet::GetAverageCounter() {
+    TabletCounter counter;
+    while (true) {
+        int seq = counter_seq_;
+        if (!(seq & 1)) {
+            counter.CopyFrom(average_counter_);
+            if (seq == counter_seq_) {
+                break;
+            }
+        }
+    }
+    return counter;
 }
 
 TabletStatus Tablet::GetStatus() {
-    MutexLock lock(&mutex_);
-    return meta_.status();
+    // status reads happen per rpc and per heartbeat for every tablet;
+    // the hint is written under mutex_ at every transition, so a plain
+    // read sees either the old or the new status, same as a locked
+    // read that ran a moment earlier
+    return (TabletStatus)status_hint_;
 }
 
 CompactStatus Tablet::GetCompactStatus() {
@@ -168,7 +274,7 @@ CompactStatus Tablet::GetCompactStatus() {
     return meta_.compact_status();
 }
 
-std::string Tablet::GetExpectServerAddr() {
+const std::string& Tablet::GetExpectServerAddr() {
     MutexLock lock(&mutex_);
     return expect_server_addr_;
 }
@@ -179,11 +285,7 @@ TablePtr Tablet::GetTable() {
 
 bool Tablet::IsBusy() {
     MutexLock lock(&mutex_);
-    if (counter_list_.size() > 0) {
-        return counter_list_.back().is_on_busy();
-    } else {
-        return false;
-    }
+    return last_counter_.is_on_busy();
 }
 
 std::string Tablet::DebugString() {
@@ -193,6 +295,37 @@ std::string Tablet::DebugString() {
 
 void Tablet::SetCounter(const TabletCounter& counter) {
     MutexLock lock(&mutex_);
+    SetCounterUnlocked(counter);
+}
+
+static bool TabletCounterIsZero(const TabletCounter& counter) {
+    return counter.low_read_cell() == 0
+        && counter.scan_rows() == 0
+        && counter.scan_kvs() == 0
+        && counter.scan_size() == 0
+        && counter.read_rows() == 0
+        && counter.read_kvs() == 0
+        && counter.read_size() == 0
+        && counter.write_rows() == 0
+        && counter.write_kvs() == 0
+        && counter.write_size() == 0
+        && counter.write_workload() == 0.0
+        && !counter.is_on_busy();
+}
+
+void Tablet::SetCounterUnlocked(const TabletCounter& counter) {
+    mutex_.AssertHeld();
+    // idle tablets report all-zero samples every sweep; once the
+    // decayed history has drained to zero as well, the update would
+    // rewrite every field with the value it already has, so skip it
+    // and leave the counter cache lines clean
+    if (TabletCounterIsZero(counter)
+        && TabletCounterIsZero(last_counter_)
+        && TabletCounterIsZero(average_counter_)) {
+        return;
+    }
+    ++counter_seq_;
+    last_counter_.CopyFrom(counter);
     average_counter_.set_low_read_cell(
         CounterWeightedSum(counter.low_read_cell(), average_counter_.low_read_cell()));
     average_counter_.set_scan_rows(
@@ -216,6 +349,7 @@ void Tablet::SetCounter(const TabletCounter& counter) {
     average_counter_.set_write_workload(counter.write_workload());
     average_counter_.set_is_on_busy(
         CounterWeightedSum(counter.is_on_busy(), average_counter_.is_on_busy()));
+    ++counter_seq_;
 }
 
 void Tablet::UpdateSize(const TabletMeta& meta) {
@@ -229,9 +363,18 @@ void Tablet::SetCompactStatus(CompactStatus compact_status) {
     meta_.set_compact_status(compact_status);
 }
 
+void Tablet::ApplyQueryReport(TabletMeta* meta, const TabletCounter& counter) {
+    MutexLock lock(&mutex_);
+    meta_.set_size(meta->size());
+    meta_.mutable_lg_size()->Swap(meta->mutable_lg_size());
+    meta_.set_compact_status(meta->compact_status());
+    SetCounterUnlocked(counter);
+}
+
 void Tablet::SetAddr(const std::string& server_addr) {
     MutexLock lock(&mutex_);
     meta_.set_server_addr(server_addr);
+    server_addr_hash_ = HashServerAddr(server_addr);
 }
 
 void Tablet::SetServerId(const std::string& server_id) {
@@ -251,6 +394,7 @@ bool Tablet::SetStatus(TabletStatus new_status, TabletStatus* old_status) {
     }
     if (CheckStatusSwitch(meta_.status(), new_status)) {
         meta_.set_status(new_status);
+        status_hint_ = new_status;
         return true;
     }
     return false;
@@ -265,6 +409,7 @@ bool Tablet::SetStatusIf(TabletStatus new_status, TabletStatus if_status,
     if (meta_.status() == if_status
         && CheckStatusSwitch(meta_.status(), new_status)) {
         meta_.set_status(new_status);
+        status_hint_ = new_status;
         return true;
     }
     return false;
@@ -283,6 +428,7 @@ bool Tablet::SetStatusIf(TabletStatus new_status, TabletStatus if_status,
     if (meta_.status() == if_status && table_->status_ == if_table_status
         && CheckStatusSwitch(meta_.status(), new_status)) {
         meta_.set_status(new_status);
+        status_hint_ = new_status;
         return true;
     }
     return false;
@@ -296,6 +442,7 @@ bool Tablet::SetAddrIf(const std::string& server_addr, TabletStatus if_status,
     }
     if (meta_.status() == if_status) {
         meta_.set_server_addr(server_addr);
+        server_addr_hash_ = HashServerAddr(server_addr);
         return true;
     }
     return false;
@@ -310,7 +457,9 @@ bool Tablet::SetAddrAndStatus(const std::string& server_addr,
     }
     if (CheckStatusSwitch(meta_.status(), new_status)) {
         meta_.set_status(new_status);
+        status_hint_ = new_status;
         meta_.set_server_addr(server_addr);
+        server_addr_hash_ = HashServerAddr(server_addr);
         return true;
     }
     return false;
@@ -326,38 +475,31 @@ bool Tablet::SetAddrAndStatusIf(const std::string& server_addr,
     if (meta_.status() == if_status
         && CheckStatusSwitch(meta_.status(), new_status)) {
         meta_.set_status(new_status);
+        status_hint_ = new_status;
         meta_.set_server_addr(server_addr);
+        server_addr_hash_ = HashServerAddr(server_addr);
         return true;
     }
     return false;
 }
 
 int64_t Tablet::UpdateTime() {
-    MutexLock lock(&mutex_);
     return update_time_;
 }
 
 int64_t Tablet::SetUpdateTime(int64_t timestamp) {
-    MutexLock lock(&mutex_);
-    int64_t ts = update_time_;
-    update_time_ = timestamp;
-    return ts;
+    return atomic_swap64(&update_time_, timestamp);
 }
 
 int64_t Tablet::LoadTime() {
-    MutexLock lock(&mutex_);
-    if (meta_.status() != kTableReady) {
+    if ((TabletStatus)status_hint_ != kTableReady) {
         return std::numeric_limits<int>::max();
-    } else {
-        return load_time_;
     }
+    return load_time_;
 }
 
 int64_t Tablet::SetLoadTime(int64_t timestamp) {
-    MutexLock lock(&mutex_);
-    int64_t ts = load_time_;
-    load_time_ = timestamp;
-    return ts;
+    return atomic_swap64(&load_time_, timestamp);
 }
 
 int32_t Tablet::AddSnapshot(uint64_t snapshot) {
@@ -440,108 +582,27 @@ void Tablet::ToMetaTableKeyValue(std::string* packed_key,
 }
 
 void* Tablet::GetMergeParam() {
-    MutexLock lock(&mutex_);
-    return merge_param_;
+    MutexLock lock(&merge_param_mutex);
+    std::map<const Tablet*, void*>::iterator it = merge_param_map.find(this);
+    if (it == merge_param_map.end()) {
+        return NULL;
+    }
+    return it->second;
 }
 
 void Tablet::SetMergeParam(void* merge_param) {
-    MutexLock lock(&mutex_);
-    merge_param_ = merge_param;
+    MutexLock lock(&merge_param_mutex);
+    if (merge_param == NULL) {
+        merge_param_map.erase(this);
+    } else {
+        merge_param_map[this] = merge_param;
+    }
 }
 
 bool Tablet::CheckStatusSwitch(TabletStatus old_status,
                                TabletStatus new_status) {
-    switch (old_status) {
-    case kTableNotInit:
-        if (new_status == kTableReady         // tablet is loaded when master up
-            || new_status == kTableOffLine) { // tablet is unload when master up
-            return true;
-        }
-        break;
-    case kTableReady:
-        if (new_status == kTabletPending        // tabletnode down
-            || new_status == kTableOffLine      // tabletnode down (move immidiately)
-            || new_status == kTableUnLoading    // ready to move tablet
-            || new_status == kTableOnSplit      // begin to split
-            || new_status == kTabletOnSnapshot
-            || new_status == kTabletDelSnapshot) {
-            return true;
-        }
-        break;
-    case kTabletOnSnapshot:
-        if (new_status == kTableReady) {
-            return true;
-        }
-        break;
-    case kTabletDelSnapshot:
-        if (new_status == kTableReady) {
-            return true;
-        }
-        break;
-    case kTableOnLoad:
-        if (new_status == kTableReady           // load succe
-            || new_status == kTableOffLine      // tabletnode down
-            || new_status == kTableLoadFail) {  // don't know result, wait tabletnode to be killed
-            return true;
-        }
-        break;
-    case kTableLoadFail:
-        if (new_status == kTableOffLine) {     // tabletnode is killed
-            return true;
-        }
-        break;
-    case kTableOnSplit:
-        if (new_status == kTableReady             // request rejected
-            || new_status == kTableOffLine        // split fail
-            || new_status == kTableSplitFail) {   // don't know result, wait tabletnode to be killed
-            return true;
-        }
-        break;
-    case kTableSplitFail:
-        if (new_status == kTableOnSplit) {       // tabletnode is killed, ready to scan meta
-            return true;
-        }
-        break;
-    case kTabletPending:
-        if (new_status == kTableReady            // tabletnode up
-            || new_status == kTableOffLine) {    // tabletnode down timeout
-            return true;
-        }
-        break;
-    case kTableOffLine:
-        if (new_status == kTableReady            // tabletnode up
-            || new_status == kTableOnLoad        // begin to load
-            || new_status == kTabletPending      // tabletnode down before load
-            || new_status == kTabletDisable) {   // table is disabled
-            return true;
-        }
-        break;
-    case kTableUnLoading:
-        if (new_status == kTableOffLine           // unload succe
-            || new_status == kTableReady          // unload status rollback when merge failed
-            || new_status == kTableOnMerge        // unload success, ready to merge phase2
-            || new_status == kTableUnLoadFail) {  // don't know result, wait tabletnode to be killed
-            return true;
-        }
-        break;
-    case kTableUnLoadFail:
-        if (new_status == kTableOffLine           // tabletnode is killed, ready to load
-            || new_status == kTableOnMerge) {     // tabletnode is killed, ready to merge phase2
-            return true;
-        }
-        break;
-    case kTableOnMerge:
-        if (new_status == kTableOffLine) {        // merge failed, ready to reload
-            return true;
-        }
-        break;
-    case kTabletDisable:
-        if (new_status == kTableOffLine) {
-            return true;
-        }
-        break;
-    default:
-        break;
+    if (status_switch_table.IsAllowed(old_status, new_status)) {
+        return true;
     }
 
     LOG(ERROR) << "not support status switch "
@@ -563,7 +624,8 @@ std::ostream& operator << (std::ostream& o, const TablePtr& table) {
 }
 
 Table::Table(const std::string& table_name)
-    : name_(table_name),
+    : refs_(0),
+      name_(table_name),
       status_(kTableEnable),
       deleted_tablet_num_(0),
       max_tablet_no_(0),
@@ -588,9 +650,15 @@ bool Table::FindTablet(const std::string& key_start, TabletPtr* tablet) {
 void Table::FindTablet(const std::string& server_addr,
                        std::vector<TabletPtr>* tablet_meta_list) {
     MutexLock lock(&mutex_);
+    uint32_t addr_hash = Tablet::HashServerAddr(server_addr);
     Table::TabletList::iterator it2 = tablets_list_.begin();
     for (; it2 != tablets_list_.end(); ++it2) {
         TabletPtr tablet = it2->second;
+        // cheap lock-free filter first; only hash matches pay for the
+        // tablet mutex and the exact compare
+        if (tablet->server_addr_hash_ != addr_hash) {
+            continue;
+        }
         tablet->mutex_.Lock();
         if (tablet->meta_.server_addr() == server_addr) {
             tablet_meta_list->push_back(tablet);
@@ -676,6 +744,11 @@ const TableCounter& Table::GetCounter() {
 
 int32_t Table::AddSnapshot(uint64_t snapshot) {
     MutexLock lock(&mutex_);
+    if (snapshot_list_.capacity() == 0) {
+        // tables rarely hold more than a few snapshots; grab the usual
+        // maximum up front instead of growing through 1 -> 2 -> 4
+        snapshot_list_.reserve(4);
+    }
     snapshot_list_.push_back(snapshot);
     return snapshot_list_.size() - 1;
 }
@@ -700,6 +773,9 @@ void Table::ListSnapshot(std::vector<uint64_t>* snapshots) {
 
 int32_t Table::AddRollback(std::string rollback_name) {
     MutexLock lock(&mutex_);
+    if (rollback_names_.capacity() == 0) {
+        rollback_names_.reserve(2);
+    }
     rollback_names_.push_back(rollback_name);
     return rollback_names_.size() - 1;
 }
@@ -710,8 +786,7 @@ void Table::ListRollback(std::vector<std::string>* rollback_names) {
 }
 
 int64_t Table::GetTabletsCount() {
-    MutexLock lock(&mutex_);
-    return tablets_list_.size();
+    return tablets_count_.Get();
 }
 
 void Table::AddDeleteTabletCount() {
@@ -918,7 +993,11 @@ void Table::RefreshCounter() {
     size_t lg_num = 0;
     std::vector<int64_t> lg_size;
 
-    std::vector<TabletPtr> tablet_list;
+    // hoisted out of the loop so the per-tablet lg size fetch reuses
+    // one vector's capacity instead of allocating per tablet
+    int64_t size_tmp;
+    std::vector<int64_t> lg_size_tmp;
+
     Table::TabletList::iterator it = tablets_list_.begin();
     for (; it != tablets_list_.end(); ++it) {
         tablet_num++;
@@ -926,8 +1005,6 @@ void Table::RefreshCounter() {
         if (tablet->GetStatus() != kTableReady) {
             notready++;
         }
-        int64_t size_tmp;
-        std::vector<int64_t> lg_size_tmp;
         tablet->GetDataSize(&size_tmp, &lg_size_tmp);
 
         size += size_tmp;
@@ -1070,6 +1147,8 @@ bool TabletManager::AddTablet(const TabletMeta& meta, const TableSchema& schema,
         table->max_tablet_no_ = tablet_num;
     }
     table->tablets_list_[key_start] = *tablet;
+    table->tablets_count_.Inc();
+    all_tablets_count_.Inc();
     table->mutex_.Unlock();
     return true;
 }
@@ -1091,13 +1170,7 @@ bool TabletManager::AddTablet(const std::string& table_name,
 }
 
 int64_t TabletManager::GetAllTabletsCount() {
-    MutexLock lock(&mutex_);
-    int64_t count = 0;
-    TableList::iterator it;
-    for (it = all_tables_.begin(); it != all_tables_.end(); ++it) {
-        count += it->second->GetTabletsCount();
-    }
-    return count;
+    return all_tablets_count_.Get();
 }
 
 bool TabletManager::FindTablet(const std::string& table_name,
@@ -1138,10 +1211,21 @@ bool TabletManager::FindTablet(const std::string& table_name,
 void TabletManager::FindTablet(const std::string& server_addr,
                                std::vector<TabletPtr>* tablet_meta_list,
                                bool need_disabled_tables) {
+    // snapshot the table list first so the manager mutex is not held
+    // across the whole sweep; concurrent finds and adds on other
+    // tables proceed while we walk
+    std::vector<TablePtr> tables;
     mutex_.Lock();
+    tables.reserve(all_tables_.size());
     TableList::iterator it = all_tables_.begin();
     for (; it != all_tables_.end(); ++it) {
-        Table& table = *it->second;
+        tables.push_back(it->second);
+    }
+    mutex_.Unlock();
+
+    uint32_t addr_hash = Tablet::HashServerAddr(server_addr);
+    for (size_t i = 0; i < tables.size(); ++i) {
+        Table& table = *tables[i];
         table.mutex_.Lock();
         if (table.status_ == kTableDisable && !need_disabled_tables) {
             VLOG(10) << "FindTablet skip disable table: " << table.name_;
@@ -1151,6 +1235,9 @@ void TabletManager::FindTablet(const std::string& server_addr,
         Table::TabletList::iterator it2 = table.tablets_list_.begin();
         for (; it2 != table.tablets_list_.end(); ++it2) {
             TabletPtr tablet = it2->second;
+            if (tablet->server_addr_hash_ != addr_hash) {
+                continue;
+            }
             tablet->mutex_.Lock();
             if (tablet->meta_.server_addr() == server_addr) {
                 tablet_meta_list->push_back(tablet);
@@ -1159,7 +1246,6 @@ void TabletManager::FindTablet(const std::string& server_addr,
         }
         table.mutex_.Unlock();
     }
-    mutex_.Unlock();
 }
 
 bool TabletManager::FindTable(const std::string& table_name,
@@ -1221,15 +1307,22 @@ int64_t TabletManager::SearchTable(std::vector<TabletPtr>* tablet_meta_list,
     mutex_.Lock();
 
     TableList::iterator lower_it = all_tables_.lower_bound(start_table_name);
-    TableList::iterator upper_it = all_tables_.upper_bound(prefix_table_name + "\xFF");
-    if (upper_it == all_tables_.begin() || lower_it == all_tables_.end()) {
+    if (lower_it == all_tables_.end()
+        || lower_it->first.compare(0, prefix_table_name.size(),
+                                   prefix_table_name) != 0) {
         mutex_.Unlock();
         SetStatusCode(kTableNotFound, ret_status);
         return -1;
     }
 
     uint32_t found_num = 0;
-    for (TableList::iterator it = lower_it; it != upper_it; ++it) {
+    for (TableList::iterator it = lower_it; it != all_tables_.end(); ++it) {
+        // stop once past the prefix range; this replaces an upper_bound
+        // on a concatenated "prefix\xFF" temporary
+        if (it->first.compare(0, prefix_table_name.size(),
+                              prefix_table_name) != 0) {
+            break;
+        }
         Table& table = *it->second;
         Table::TabletList::iterator it2;
         table.mutex_.Lock();
@@ -1329,6 +1422,7 @@ bool TabletManager::DeleteTable(const std::string& table_name,
     table.mutex_.Unlock();
 
     table.tablets_list_.clear();
+    all_tablets_count_.Sub(table.tablets_count_.Clear());
 //    // delete every tablet
 //    Table::TabletList::iterator it2 = table.tablets_list_.begin();
 //    for (; it2 != table.tablets_list_.end(); ++it) {
@@ -1379,6 +1473,8 @@ bool TabletManager::DeleteTablet(const std::string& table_name,
 //    tablet.mutex_.Unlock();
 //    delete &tablet;
     table.tablets_list_.erase(it2);
+    table.tablets_count_.Dec();
+    all_tablets_count_.Dec();
 
     if (table.tablets_list_.empty()) {
         // clean up specific table dir in file system
@@ -1393,22 +1489,39 @@ bool TabletManager::DeleteTablet(const std::string& table_name,
     return true;
 }
 
-void TabletManager::WriteToStream(std::ofstream& ofs,
-                                  const std::string& key,
-                                  const std::string& value) {
+void TabletManager::AppendMetaRecord(const std::string& key,
+                                     const std::string& value,
+                                     std::string* buf) {
     uint32_t key_size = key.size();
     uint32_t value_size = value.size();
-    ofs.write((char*)&key_size, sizeof(key_size));
-    ofs.write(key.data(), key_size);
-    ofs.write((char*)&value_size, sizeof(value_size));
-    ofs.write(value.data(), value_size);
+    buf->append((char*)&key_size, sizeof(key_size));
+    buf->append(key);
+    buf->append((char*)&value_size, sizeof(value_size));
+    buf->append(value);
+}
+
+bool TabletManager::WriteFull(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
 }
 
 bool TabletManager::DumpMetaTableToFile(const std::string& filename,
                                         StatusCode* status) {
-    std::ofstream ofs(filename.c_str(), std::ofstream::binary | std::ofstream::trunc);
-    if (!ofs.is_open()) {
-        LOG(WARNING) << "fail to open file " << filename << " for write";
+    const size_t kDumpBufferSize = 8 << 20;
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG(WARNING) << "fail to open file " << filename << " for write: "
+            << strerror(errno);
         SetStatusCode(kIOError, status);
         return false;
     }
@@ -1418,28 +1531,48 @@ bool TabletManager::DumpMetaTableToFile(const std::string& filename,
     std::vector<TabletPtr> tablet_list;
     ShowTable(&table_list, &tablet_list);
 
+    // records are framed into one large buffer and flushed in
+    // multi-megabyte writes, so a full dump costs a handful of
+    // syscalls instead of four buffered stream ops per record; the
+    // key/value pair is reused across records so nothing allocates
+    // per tablet once the buffer is warm
+    std::string buf;
+    buf.reserve(kDumpBufferSize + (4 << 10));
+    std::string key, value;
+    bool write_ok = true;
+
     // dump table meta
-    for (size_t i = 0; i < table_list.size(); i++) {
-        TablePtr table = table_list[i];
-        std::string key, value;
-        table->ToMetaTableKeyValue(&key, &value);
-        WriteToStream(ofs, key, value);
+    for (size_t i = 0; i < table_list.size() && write_ok; i++) {
+        table_list[i]->ToMetaTableKeyValue(&key, &value);
+        AppendMetaRecord(key, value, &buf);
+        if (buf.size() >= kDumpBufferSize) {
+            write_ok = WriteFull(fd, buf.data(), buf.size());
+            buf.clear();
+        }
     }
 
     // dump tablet meta
-    for (size_t i = 0; i < tablet_list.size(); i++) {
-        TabletPtr tablet = tablet_list[i];
-        std::string key, value;
-        tablet->ToMetaTableKeyValue(&key, &value);
-        WriteToStream(ofs, key, value);
+    for (size_t i = 0; i < tablet_list.size() && write_ok; i++) {
+        tablet_list[i]->ToMetaTableKeyValue(&key, &value);
+        AppendMetaRecord(key, value, &buf);
+        if (buf.size() >= kDumpBufferSize) {
+            write_ok = WriteFull(fd, buf.data(), buf.size());
+            buf.clear();
+        }
     }
 
-    if (ofs.fail()) {
-        LOG(WARNING) << "fail to write to file " << filename;
+    if (write_ok && !buf.empty()) {
+        write_ok = WriteFull(fd, buf.data(), buf.size());
+    }
+    if (close(fd) < 0) {
+        write_ok = false;
+    }
+    if (!write_ok) {
+        LOG(WARNING) << "fail to write to file " << filename << ": "
+            << strerror(errno);
         SetStatusCode(kIOError, status);
         return false;
     }
-    ofs.close();
     return true;
 }
 
@@ -1635,9 +1768,11 @@ void TabletManager::ClearTableList() {
         table.mutex_.Lock();
         table.mutex_.Unlock();
         table.tablets_list_.clear();
+        table.tablets_count_.Clear();
         //delete &table;
     }
     all_tables_.clear();
+    all_tablets_count_.Clear();
 }
 
 void TabletManager::PackTabletMeta(TabletMeta* meta,
@@ -1808,22 +1943,29 @@ void TabletManager::MajorCompactCallback(Tablet* tb, int32_t retry,
 
 double TabletManager::OfflineTabletRatio() {
     uint32_t offline_tablet_count = 0, tablet_count = 0;
+    std::vector<TablePtr> tables;
     mutex_.Lock();
+    tables.reserve(all_tables_.size());
     TableList::iterator it = all_tables_.begin();
     for (; it != all_tables_.end(); ++it) {
-        Table& table = *it->second;
+        tables.push_back(it->second);
+    }
+    mutex_.Unlock();
+
+    for (size_t i = 0; i < tables.size(); ++i) {
+        Table& table = *tables[i];
         table.mutex_.Lock();
         Table::TabletList::iterator it2 = table.tablets_list_.begin();
         for (; it2 != table.tablets_list_.end(); ++it2) {
-            TabletPtr tablet = it2->second;
-            if (tablet->GetStatus() == kTableOffLine) {
+            // monitoring ratio: the unlocked hint is as fresh as a
+            // locked read would have been a moment earlier
+            if (it2->second->status_hint_ == kTableOffLine) {
                 offline_tablet_count++;
             }
             tablet_count++;
         }
         table.mutex_.Unlock();
     }
-    mutex_.Unlock();
 
     if (tablet_count == 0) {
         return 0;
@@ -1831,11 +1973,6 @@ double TabletManager::OfflineTabletRatio() {
     return (double)offline_tablet_count / tablet_count;
 }
 
-int64_t CounterWeightedSum(int64_t a1, int64_t a2) {
-    const int64_t w1 = 2;
-    const int64_t w2 = 1;
-    return (a1 * w1 + a2 * w2) / (w1 + w2);
-}
 
 } // namespace master
 } // namespace tera
@@ -5,6 +5,7 @@
 #ifndef TERA_MASTER_TABLET_MANAGER_H_
 #define TERA_MASTER_TABLET_MANAGER_H_
 
+#include <algorithm>
 #include <limits>
 #include <list>
 #include <map>
@@ -13,6 +14,7 @@
 #include <string>
 #include <vector>
 
+#include <boost/intrusive_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "common/base/closure.h"
@@ -52,12 +54,19 @@ namespace master {
 
 class MasterImpl;
 class Table;
-typedef boost::shared_ptr<Table> TablePtr;
+// Tablet/Table carry their own atomic refcount so TabletPtr/TablePtr
+// need no separate control block: one allocation per object and the
+// count lives on the same cache lines as the object itself
+void intrusive_ptr_add_ref(Table* table);
+void intrusive_ptr_release(Table* table);
+typedef boost::intrusive_ptr<Table> TablePtr;
 
 class Tablet {
     friend class TabletManager;
     friend class Table;
     friend std::ostream& operator << (std::ostream& o, const Tablet& tablet);
+    friend void intrusive_ptr_add_ref(Tablet* tablet);
+    friend void intrusive_ptr_release(Tablet* tablet);
 
 public:
     Tablet();
@@ -77,12 +86,12 @@ public:
     const std::string& GetKeyEnd();
     const KeyRange& GetKeyRange();
     const TableSchema& GetSchema();
-    const TabletCounter& GetCounter();
-    const TabletCounter& GetAverageCounter();
+    TabletCounter GetCounter();
+    TabletCounter GetAverageCounter();
     TabletStatus GetStatus();
     CompactStatus GetCompactStatus();
-    std::string GetServerId();
-    std::string GetExpectServerAddr();
+    const std::string& GetServerId();
+    const std::string& GetExpectServerAddr();
     TablePtr GetTable();
     bool IsBusy();
     std::string DebugString();
@@ -90,6 +99,11 @@ public:
     void UpdateSize(const TabletMeta& meta);
     void SetCounter(const TabletCounter& counter);
     void SetCompactStatus(CompactStatus compact_status);
+    // coalesced size + counter + compact status update from one query
+    // report, taking the tablet mutex once instead of three times; the
+    // report is taken mutably so the lg size array is swapped out of
+    // the response proto instead of copied element by element
+    void ApplyQueryReport(TabletMeta* meta, const TabletCounter& counter);
     void SetAddr(const std::string& server_addr);
     bool SetStatus(TabletStatus new_status, TabletStatus* old_status = NULL);
     bool SetStatusIf(TabletStatus new_status, TabletStatus if_status,
@@ -133,6 +147,8 @@ public:
     void* GetMergeParam();
     void SetMergeParam(void* merge_param);
 
+    static uint32_t HashServerAddr(const std::string& server_addr);
+
 private:
     Tablet(const Tablet&) {}
     Tablet& operator=(const Tablet&) {return *this;}
@@ -140,35 +156,45 @@ private:
     static bool CheckStatusSwitch(TabletStatus old_status,
                                   TabletStatus new_status);
 
+    void SetCounterUnlocked(const TabletCounter& counter);
+
+    volatile int refs_;
     mutable Mutex mutex_;
     TabletMeta meta_;
+    // lock-free hints mirroring meta_.status()/server_addr(), kept in
+    // sync under mutex_ so manager-wide sweeps can filter millions of
+    // tablets without taking every tablet mutex or touching the proto
+    volatile int32_t status_hint_;
+    volatile uint32_t server_addr_hash_;
     TablePtr table_;
-    int64_t update_time_;
-    int64_t load_time_;
+    // plain timestamps hit on every heartbeat; reads are bare 64-bit
+    // loads and the set-and-return-old writers go through atomic_swap64,
+    // so neither side touches the tablet mutex
+    volatile int64_t update_time_;
+    volatile int64_t load_time_;
     std::string server_id_;
     std::string expect_server_addr_;
-    std::list<TabletCounter> counter_list_;
+    // seqlock over the two counters below: SetCounter (under mutex_)
+    // bumps it odd before and even after writing, readers retry on a
+    // torn or in-flight sequence and never block the heartbeat path
+    volatile int counter_seq_;
+    // latest raw sample from the query sweep; the decayed history lives
+    // in average_counter_, so no per-sample list is kept
+    TabletCounter last_counter_;
     TabletCounter average_counter_;
-    struct TabletAccumulateCounter {
-        uint64_t low_read_cell;
-        uint64_t scan_rows;
-        uint64_t scan_kvs;
-        uint64_t scan_size;
-        uint64_t read_rows;
-        uint64_t read_kvs;
-        uint64_t read_size;
-        uint64_t write_rows;
-        uint64_t write_kvs;
-        uint64_t write_size;
-
-        TabletAccumulateCounter() {
-            memset(this, 0, sizeof(TabletAccumulateCounter));
-        }
-    } accumu_counter_;
-    void* merge_param_;
 };
 
-typedef class boost::shared_ptr<Tablet> TabletPtr;
+inline void intrusive_ptr_add_ref(Tablet* tablet) {
+    atomic_inc(&tablet->refs_);
+}
+
+inline void intrusive_ptr_release(Tablet* tablet) {
+    if (atomic_add(&tablet->refs_, -1) == 1) {
+        delete tablet;
+    }
+}
+
+typedef boost::intrusive_ptr<Tablet> TabletPtr;
 std::ostream& operator << (std::ostream& o, const TabletPtr& tablet);
 std::ostream& operator << (std::ostream& o, const TablePtr& table);
 
@@ -176,6 +202,8 @@ class Table {
     friend class Tablet;
     friend class TabletManager;
     friend std::ostream& operator << (std::ostream& o, const Table& tablet);
+    friend void intrusive_ptr_add_ref(Table* table);
+    friend void intrusive_ptr_release(Table* table);
 
 public:
     Table(const std::string& table_name);
@@ -225,8 +253,52 @@ public:
 private:
     Table(const Table&) {}
     Table& operator=(const Table&) {return *this;}
-    typedef std::map<std::string, TabletPtr> TabletList;
+    // map-shaped wrapper over a key_start-sorted vector: lookups binary
+    // search one contiguous array instead of chasing tree nodes, which
+    // matters when a master holds millions of tablets; splits/merges are
+    // rare enough that sorted insert/erase is cheap
+    class TabletList {
+    public:
+        typedef std::pair<std::string, TabletPtr> Entry;
+        typedef std::vector<Entry>::iterator iterator;
+
+        iterator begin() { return entries_.begin(); }
+        iterator end() { return entries_.end(); }
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+        void clear() { entries_.clear(); }
+        iterator lower_bound(const std::string& key) {
+            return std::lower_bound(entries_.begin(), entries_.end(),
+                                    key, EntryLess());
+        }
+        iterator find(const std::string& key) {
+            iterator it = lower_bound(key);
+            if (it != entries_.end() && it->first == key) {
+                return it;
+            }
+            return entries_.end();
+        }
+        TabletPtr& operator[](const std::string& key) {
+            iterator it = lower_bound(key);
+            if (it == entries_.end() || it->first != key) {
+                it = entries_.insert(it, Entry(key, TabletPtr()));
+            }
+            return it->second;
+        }
+        void erase(iterator it) { entries_.erase(it); }
+
+    private:
+        struct EntryLess {
+            bool operator()(const Entry& entry, const std::string& key) const {
+                return entry.first < key;
+            }
+        };
+        std::vector<Entry> entries_;
+    };
+    volatile int refs_;
     TabletList tablets_list_;
+    // kept in sync with tablets_list_ so monitoring reads need no lock
+    Counter tablets_count_;
     mutable Mutex mutex_;
     std::string name_;
     TableSchema schema_;
@@ -244,6 +316,16 @@ private:
     TableSchema* old_schema_;
 };
 
+inline void intrusive_ptr_add_ref(Table* table) {
+    atomic_inc(&table->refs_);
+}
+
+inline void intrusive_ptr_release(Table* table) {
+    if (atomic_add(&table->refs_, -1) == 1) {
+        delete table;
+    }
+}
+
 class TabletManager {
 public:
     typedef Closure<bool, const std::string&, StatusCode*> FindCondCallback;
@@ -344,18 +426,74 @@ private:
                               CompactTabletResponse* response,
                               bool failed, int error_code);
 
-    void WriteToStream(std::ofstream& ofs, const std::string& key,
-                       const std::string& value);
+    static void AppendMetaRecord(const std::string& key,
+                                 const std::string& value, std::string* buf);
+    static bool WriteFull(int fd, const char* data, size_t size);
 
 private:
-    typedef std::map<std::string, TablePtr> TableList;
+    // map-shaped wrapper over a sorted vector, same layout trick as
+    // Table::TabletList: the prefix walks in SearchTable/ShowTable
+    // stream contiguous entries in name order instead of chasing tree
+    // nodes, and tables are added or dropped far too rarely for the
+    // shifting insert/erase to matter. Point lookups by name are a
+    // binary search over the same contiguous entries; a separate hash
+    // index was considered and rejected, since it would duplicate
+    // every name and need resyncing on add/drop to save a handful of
+    // in-cache comparisons at realistic table counts
+    class TableList {
+    public:
+        typedef std::pair<std::string, TablePtr> Entry;
+        typedef std::vector<Entry>::iterator iterator;
+
+        iterator begin() { return entries_.begin(); }
+        iterator end() { return entries_.end(); }
+        size_t size() const { return entries_.size(); }
+        void clear() { entries_.clear(); }
+        iterator lower_bound(const std::string& key) {
+            return std::lower_bound(entries_.begin(), entries_.end(),
+                                    key, EntryLess());
+        }
+        iterator find(const std::string& key) {
+            iterator it = lower_bound(key);
+            if (it != entries_.end() && it->first == key) {
+                return it;
+            }
+            return entries_.end();
+        }
+        std::pair<iterator, bool> insert(const Entry& entry) {
+            iterator it = lower_bound(entry.first);
+            if (it != entries_.end() && it->first == entry.first) {
+                return std::pair<iterator, bool>(it, false);
+            }
+            it = entries_.insert(it, entry);
+            return std::pair<iterator, bool>(it, true);
+        }
+        void erase(iterator it) { entries_.erase(it); }
+
+    private:
+        struct EntryLess {
+            bool operator()(const Entry& entry, const std::string& key) const {
+                return entry.first < key;
+            }
+        };
+        std::vector<Entry> entries_;
+    };
     TableList all_tables_;
+    // kept in sync with the per-table lists so monitoring reads need no lock
+    Counter all_tablets_count_;
     mutable Mutex mutex_;
     Counter* this_sequence_id_;
     MasterImpl* master_impl_;
 };
 
-int64_t CounterWeightedSum(int64_t a1, int64_t a2);
+// one-variable decaying average: 2/3 latest sample, 1/3 history;
+// inline so the per-field updates in the report paths fold into
+// straight-line arithmetic instead of a cross-module call each
+inline int64_t CounterWeightedSum(int64_t a1, int64_t a2) {
+    const int64_t w1 = 2;
+    const int64_t w2 = 1;
+    return (a1 * w1 + a2 * w2) / (w1 + w2);
+}
 
 } // namespace master
 } // namespace tera
@@ -19,7 +19,11 @@ void MakeMetaTableKeyValue(const TableMeta& meta, std::string* key,
 
 void MakeMetaTableKey(const std::string& table_name, std::string* key) {
     if (NULL != key) {
-        *key = "@" + table_name;
+        // build in place to reuse the caller's capacity across records
+        key->clear();
+        key->reserve(table_name.size() + 1);
+        key->push_back('@');
+        key->append(table_name);
     }
 }
 
@@ -67,7 +71,11 @@ void MakeMetaTableKey(const std::string& table_name,
                       const std::string& key_start,
                       std::string* key) {
     if (NULL != key) {
-        *key = table_name + "#" + key_start;
+        key->clear();
+        key->reserve(table_name.size() + 1 + key_start.size());
+        key->append(table_name);
+        key->push_back('#');
+        key->append(key_start);
     }
 }
 
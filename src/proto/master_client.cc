@@ -23,6 +23,10 @@ MasterClient::MasterClient(const std::string& server_addr,
 
 MasterClient::~MasterClient() {}
 
+void MasterClient::ResetMasterClient(const std::string& server_addr) {
+    ResetClient(server_addr);
+}
+
 bool MasterClient::GetSnapshot(const GetSnapshotRequest* request,
                                GetSnapshotResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::GetSnapshot,
@@ -31,6 +35,15 @@ bool MasterClient::GetSnapshot(const GetSnapshotRequest* request,
                                 "GetSnapshot", rpc_timeout_);
 }
 
+bool MasterClient::GetSnapshot(ThreadPool* thread_pool,
+                               const GetSnapshotRequest* request,
+                               GetSnapshotResponse* response,
+                               Closure<void, GetSnapshotRequest*, GetSnapshotResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::GetSnapshot,
+                                request, response, done,
+                                "GetSnapshot", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::DelSnapshot(const DelSnapshotRequest* request,
                                DelSnapshotResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::DelSnapshot,
@@ -39,6 +52,15 @@ bool MasterClient::DelSnapshot(const DelSnapshotRequest* request,
                                 "DelSnapshot", rpc_timeout_);
 }
 
+bool MasterClient::DelSnapshot(ThreadPool* thread_pool,
+                               const DelSnapshotRequest* request,
+                               DelSnapshotResponse* response,
+                               Closure<void, DelSnapshotRequest*, DelSnapshotResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::DelSnapshot,
+                                request, response, done,
+                                "DelSnapshot", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::GetRollback(const RollbackRequest* request,
                                RollbackResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::GetRollback,
@@ -47,6 +69,15 @@ bool MasterClient::GetRollback(const RollbackRequest* request,
                                 "GetRollback", rpc_timeout_);
 }
 
+bool MasterClient::GetRollback(ThreadPool* thread_pool,
+                               const RollbackRequest* request,
+                               RollbackResponse* response,
+                               Closure<void, RollbackRequest*, RollbackResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::GetRollback,
+                                request, response, done,
+                                "GetRollback", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::CreateTable(const CreateTableRequest* request,
                                CreateTableResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::CreateTable,
@@ -119,6 +150,15 @@ bool MasterClient::ShowTables(const ShowTablesRequest* request,
                                 "ShowTables", rpc_timeout_);
 }
 
+bool MasterClient::ShowTables(ThreadPool* thread_pool,
+                              const ShowTablesRequest* request,
+                              ShowTablesResponse* response,
+                              Closure<void, ShowTablesRequest*, ShowTablesResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::ShowTables,
+                                request, response, done,
+                                "ShowTables", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::ShowTabletNodes(const ShowTabletNodesRequest* request,
                                    ShowTabletNodesResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::ShowTabletNodes,
@@ -127,6 +167,15 @@ bool MasterClient::ShowTabletNodes(const ShowTabletNodesRequest* request,
                                 "ShowTabletNodes", rpc_timeout_);
 }
 
+bool MasterClient::ShowTabletNodes(ThreadPool* thread_pool,
+                                   const ShowTabletNodesRequest* request,
+                                   ShowTabletNodesResponse* response,
+                                   Closure<void, ShowTabletNodesRequest*, ShowTabletNodesResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::ShowTabletNodes,
+                                request, response, done,
+                                "ShowTabletNodes", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::Register(const RegisterRequest* request,
                             RegisterResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::Register,
@@ -151,6 +200,15 @@ bool MasterClient::CmdCtrl(const CmdCtrlRequest* request,
                                 "CmdCtrl", rpc_timeout_);
 }
 
+bool MasterClient::CmdCtrl(ThreadPool* thread_pool,
+                           const CmdCtrlRequest* request,
+                           CmdCtrlResponse* response,
+                           Closure<void, CmdCtrlRequest*, CmdCtrlResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::CmdCtrl,
+                                request, response, done,
+                                "CmdCtrl", rpc_timeout_, thread_pool);
+}
+
 bool MasterClient::OperateUser(const OperateUserRequest* request,
                                OperateUserResponse* response) {
     return SendMessageWithRetry(&MasterServer::Stub::OperateUser,
@@ -168,5 +226,15 @@ bool MasterClient::RenameTable(const RenameTableRequest* request,
                                 "RenameTable", rpc_timeout_);
 }
 
+bool MasterClient::RenameTable(ThreadPool* thread_pool,
+                               const RenameTableRequest* request,
+                               RenameTableResponse* response,
+                               Closure<void, RenameTableRequest*,
+                                       RenameTableResponse*, bool, int>* done) {
+    return SendMessageWithRetry(&MasterServer::Stub::RenameTable,
+                                request, response, done,
+                                "RenameTable", rpc_timeout_, thread_pool);
+}
+
 } // namespace master
 } // namespace tera
@@ -23,15 +23,38 @@ public:
                  int32_t rpc_timeout = FLAGS_tera_rpc_timeout_period);
     virtual ~MasterClient();
 
+    /// re-point the client at `server_addr'; a no-op when the address
+    /// is unchanged, so long-lived clients can refresh cheaply
+    void ResetMasterClient(const std::string& server_addr);
+
+    /// each operation also has an asynchronous twin taking a
+    /// completion closure, dispatched on `thread_pool'; independent
+    /// master operations can be issued together and joined at the
+    /// end instead of paying one round-trip each
     virtual bool GetSnapshot(const GetSnapshotRequest* request,
                              GetSnapshotResponse* response);
 
+    virtual bool GetSnapshot(ThreadPool* thread_pool,
+                             const GetSnapshotRequest* request,
+                             GetSnapshotResponse* response,
+                             Closure<void, GetSnapshotRequest*, GetSnapshotResponse*, bool, int>* done);
+
     virtual bool DelSnapshot(const DelSnapshotRequest* request,
                              DelSnapshotResponse* response);
 
+    virtual bool DelSnapshot(ThreadPool* thread_pool,
+                             const DelSnapshotRequest* request,
+                             DelSnapshotResponse* response,
+                             Closure<void, DelSnapshotRequest*, DelSnapshotResponse*, bool, int>* done);
+
     virtual bool GetRollback(const RollbackRequest* request,
                              RollbackResponse* response);
 
+    virtual bool GetRollback(ThreadPool* thread_pool,
+                             const RollbackRequest* request,
+                             RollbackResponse* response,
+                             Closure<void, RollbackRequest*, RollbackResponse*, bool, int>* done);
+
     virtual bool CreateTable(const CreateTableRequest* request,
                              CreateTableResponse* response);
 
@@ -59,9 +82,19 @@ public:
     virtual bool ShowTables(const ShowTablesRequest* request,
                             ShowTablesResponse* response);
 
+    virtual bool ShowTables(ThreadPool* thread_pool,
+                            const ShowTablesRequest* request,
+                            ShowTablesResponse* response,
+                            Closure<void, ShowTablesRequest*, ShowTablesResponse*, bool, int>* done);
+
     virtual bool ShowTabletNodes(const ShowTabletNodesRequest* request,
                                  ShowTabletNodesResponse* response);
 
+    virtual bool ShowTabletNodes(ThreadPool* thread_pool,
+                                 const ShowTabletNodesRequest* request,
+                                 ShowTabletNodesResponse* response,
+                                 Closure<void, ShowTabletNodesRequest*, ShowTabletNodesResponse*, bool, int>* done);
+
     virtual bool Register(const RegisterRequest* request,
                           RegisterResponse* response);
 
@@ -71,10 +104,20 @@ public:
     virtual bool CmdCtrl(const CmdCtrlRequest* request,
                          CmdCtrlResponse* response);
 
+    virtual bool CmdCtrl(ThreadPool* thread_pool,
+                         const CmdCtrlRequest* request,
+                         CmdCtrlResponse* response,
+                         Closure<void, CmdCtrlRequest*, CmdCtrlResponse*, bool, int>* done);
+
     virtual bool OperateUser(const OperateUserRequest* request,
                              OperateUserResponse* response);
     virtual bool RenameTable(const RenameTableRequest* request,
                              RenameTableResponse* response);
+
+    virtual bool RenameTable(ThreadPool* thread_pool,
+                             const RenameTableRequest* request,
+                             RenameTableResponse* response,
+                             Closure<void, RenameTableRequest*, RenameTableResponse*, bool, int>* done);
 private:
     int32_t rpc_timeout_;
 };
@@ -8,19 +8,19 @@
 
 namespace tera {
 
-std::string StatusCodeToString(StatusCode status) {
+const std::string& StatusCodeToString(StatusCode status) {
     return StatusCode_Name(status);
 }
 
-std::string StatusCodeToString(TabletStatus status) {
+const std::string& StatusCodeToString(TabletStatus status) {
     return TabletStatus_Name(status);
 }
 
-std::string StatusCodeToString(TableStatus status) {
+const std::string& StatusCodeToString(TableStatus status) {
     return TableStatus_Name(status);
 }
 
-std::string StatusCodeToString(CompactStatus status) {
+const std::string& StatusCodeToString(CompactStatus status) {
     return CompactStatus_Name(status);
 }
 
@@ -20,10 +20,13 @@ typedef ::google::protobuf::RepeatedPtrField< ::std::string> KeyList;
 typedef ::google::protobuf::RepeatedPtrField< ::tera::RowResult> RowResultList;
 typedef ::google::protobuf::RepeatedPtrField< ::tera::RowReaderInfo> RowReaderList;
 
-std::string StatusCodeToString(StatusCode status);
-std::string StatusCodeToString(TabletStatus status);
-std::string StatusCodeToString(TableStatus status);
-std::string StatusCodeToString(CompactStatus status);
+// the returned reference points at the name pooled in the generated
+// enum descriptor, so converting a status for a log line allocates
+// nothing; callers that need ownership copy at the assignment
+const std::string& StatusCodeToString(StatusCode status);
+const std::string& StatusCodeToString(TabletStatus status);
+const std::string& StatusCodeToString(TableStatus status);
+const std::string& StatusCodeToString(CompactStatus status);
 
 void SetStatusCode(const StatusCode& code, StatusCode* tera_status);
 void SetStatusCode(const TabletStatus& tablet_status, StatusCode* tera_status);
@@ -138,6 +138,11 @@ protected:
             }
 
             // async call
+            if (thread_pool == NULL) {
+                UserCallback(request, response, closure, true,
+                             (int)sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS);
+                return true;
+            }
             ThreadPool::Task callback =
                 boost::bind(&RpcClient::template UserCallback<Request, Response, Callback>,
                 request, response, closure, true,
@@ -192,6 +197,13 @@ protected:
         }
 
         // async call
+        // a NULL thread_pool means the caller wants the callback inline
+        // on the rpc io thread, skipping one pool handoff; only do this
+        // for callbacks that will not block
+        if (thread_pool == NULL) {
+            UserCallback(request, response, closure, failed, error);
+            return;
+        }
         ThreadPool::Task done =
             boost::bind(&RpcClient::template UserCallback<Request, Response, Callback>,
             request, response, closure, failed, error);
@@ -5,10 +5,12 @@
 #include "sdk/client_impl.h"
 #include "version.h"
 
-#include <iostream>
+#include <boost/bind.hpp>
+#include <google/protobuf/io/coded_stream.h>
 
 #include "gflags/gflags.h"
 
+#include "common/base/likely.h"
 #include "common/file/file_path.h"
 #include "common/mutex.h"
 #include "proto/kv_helper.h"
@@ -31,6 +33,8 @@ DECLARE_string(tera_user_identity);
 DECLARE_string(tera_user_passcode);
 
 DECLARE_int32(tera_sdk_retry_times);
+DECLARE_int32(tera_sdk_table_name_cache_timeout);
+DECLARE_int32(tera_sdk_meta_cache_ttl_ms);
 DECLARE_int32(tera_sdk_update_meta_internal);
 DECLARE_int32(tera_sdk_retry_period);
 DECLARE_int32(tera_sdk_thread_min_num);
@@ -47,6 +51,10 @@ DECLARE_bool(tera_online_schema_update_enabled);
 namespace tera {
 
 static pthread_once_t sdk_client_once_control = PTHREAD_ONCE_INIT;
+// threads that build many short-lived clients skip the pthread_once
+// acquire barrier after their first construction; pthread_once still
+// serializes the actual first call across threads
+static __thread bool sdk_version_logged = false;
 
 void LogSdkVersionInfo() {
     LOG(INFO) << "\n" << SystemVersionInfo();
@@ -56,84 +64,93 @@ ClientImpl::ClientImpl(const std::string& user_identity,
                        const std::string& user_passcode)
     : thread_pool_(FLAGS_tera_sdk_thread_max_num),
       user_identity_(user_identity),
-      user_passcode_(user_passcode) {
+      user_passcode_(user_passcode),
+      user_token_(GetUserToken(user_identity, user_passcode)) {
     tabletnode::TabletNodeClient::SetThreadPool(&thread_pool_);
     tabletnode::TabletNodeClient::SetRpcOption(
         FLAGS_tera_sdk_rpc_limit_enabled ? FLAGS_tera_sdk_rpc_limit_max_inflow : -1,
         FLAGS_tera_sdk_rpc_limit_enabled ? FLAGS_tera_sdk_rpc_limit_max_outflow : -1,
         FLAGS_tera_sdk_rpc_max_pending_buffer_size, FLAGS_tera_sdk_rpc_work_thread_num);
     cluster_ = sdk::NewClusterFinder();
-    pthread_once(&sdk_client_once_control, LogSdkVersionInfo);
+    if (!sdk_version_logged) {
+        pthread_once(&sdk_client_once_control, LogSdkVersionInfo);
+        sdk_version_logged = true;
+    }
 }
 
 ClientImpl::~ClientImpl() {
-    {
-        MutexLock l(&open_table_mutex_);
-        if (!open_table_map_.empty()) {
-            std::map<std::string, TableHandle>::iterator it = open_table_map_.begin() ;
-            for (; it != open_table_map_.end(); ++it) {
-                LOG(ERROR) << "table should be delete first: " << it->first;
-            }
+    for (uint32_t i = 0; i < kOpenTableShardNum; ++i) {
+        TableShard& shard = open_table_shards_[i];
+        MutexLock l(&shard.mutex);
+        TableHandleMap::iterator it = shard.handles.begin();
+        for (; it != shard.handles.end(); ++it) {
+            LOG(ERROR) << "table should be delete first: " << it->first;
         }
     }
     delete cluster_;
 }
 
+master::MasterClient* ClientImpl::GetMasterClient() {
+    master_client_mutex_.AssertHeld();
+    if (master_client_.get() == NULL) {
+        master_client_.reset(new master::MasterClient(cluster_->MasterAddr()));
+    } else {
+        // no-op unless the master has moved since the last admin rpc
+        master_client_->ResetMasterClient(cluster_->MasterAddr());
+    }
+    return master_client_.get();
+}
+
 bool ClientImpl::CreateTable(const TableDescriptor& desc, ErrorCode* err) {
     std::vector<string> empty_delimiter;
     return CreateTable(desc, empty_delimiter, err);
 }
 
 std::string ClientImpl::GetUserToken(const std::string& user, const std::string& password) {
-    std::string token_str = user + ":" + password;
+    std::string token_str;
+    token_str.reserve(user.size() + 1 + password.size());
+    token_str.append(user).append(1, ':').append(password);
     std::string token;
     GetHashString(token_str, 0, &token);
     return token;
 }
 
-bool ClientImpl::CheckReturnValue(StatusCode status, std::string& reason, ErrorCode* err) {
-    switch (status) {
-        case kMasterOk:
-            err->SetFailed(ErrorCode::kOK, "success");
-            LOG(INFO) << "master status is OK.";
-            return true;
-        case kTableExist:
-            reason = "table already exist.";
-            err->SetFailed(ErrorCode::kBadParam, reason);
-            break;
-        case kTableNotExist:
-            reason = "table not exist.";
-            err->SetFailed(ErrorCode::kBadParam, reason);
-            break;
-        case kTableNotFound:
-            reason = "table not found.";
-            err->SetFailed(ErrorCode::kBadParam, reason);
-            break;
-        case kTableStatusDisable:
-            reason = "table status: disable.";
-            err->SetFailed(ErrorCode::kBadParam, reason);
-            break;
-        case kTableStatusEnable:
-            reason = "table status: enable.";
-            err->SetFailed(ErrorCode::kSystem, reason);
-            break;
-        case kInvalidArgument:
-            reason = "invalid arguments.";
-            err->SetFailed(ErrorCode::kBadParam, reason);
-            break;
-        case kNotPermission:
-            reason = "permission denied.";
-            err->SetFailed(ErrorCode::kNoAuth, reason);
-            break;
-        case kTabletReady:
-            reason = "tablet is ready.";
-            err->SetFailed(ErrorCode::kOK, reason);
-            break;
-        default:
-            reason = "unknown system error, contact to cluster admin...";
-            err->SetFailed(ErrorCode::kSystem, reason);
-            break;
+// master status -> (sdk error code, message); the messages are string
+// literals, so classifying a response allocates nothing on the sdk side
+struct MasterStatusMapping {
+    StatusCode status;
+    ErrorCode::ErrorCodeType code;
+    const char* reason;
+};
+static const MasterStatusMapping kMasterStatusMappings[] = {
+    { kTableExist,         ErrorCode::kBadParam, "table already exist." },
+    { kTableNotExist,      ErrorCode::kBadParam, "table not exist." },
+    { kTableNotFound,      ErrorCode::kBadParam, "table not found." },
+    { kTableStatusDisable, ErrorCode::kBadParam, "table status: disable." },
+    { kTableStatusEnable,  ErrorCode::kSystem,   "table status: enable." },
+    { kInvalidArgument,    ErrorCode::kBadParam, "invalid arguments." },
+    { kNotPermission,      ErrorCode::kNoAuth,   "permission denied." },
+    { kTabletReady,        ErrorCode::kOK,       "tablet is ready." },
+};
+
+bool ClientImpl::CheckReturnValue(StatusCode status, const char** reason, ErrorCode* err) {
+    if (status == kMasterOk) {
+        *reason = "success";
+        err->SetFailed(ErrorCode::kOK, *reason);
+        LOG(INFO) << "master status is OK.";
+        return true;
+    }
+    const size_t mapping_num =
+        sizeof(kMasterStatusMappings) / sizeof(kMasterStatusMappings[0]);
+    for (size_t i = 0; i < mapping_num; ++i) {
+        if (kMasterStatusMappings[i].status == status) {
+            *reason = kMasterStatusMappings[i].reason;
+            err->SetFailed(kMasterStatusMappings[i].code, *reason);
+            return false;
+        }
     }
+    *reason = "unknown system error, contact to cluster admin...";
+    err->SetFailed(ErrorCode::kSystem, *reason);
     return false;
 }
 
@@ -143,7 +160,8 @@ bool ClientImpl::CreateTable(const TableDescriptor& desc,
     if (!CheckTableDescrptor(desc, err)) {
         return false;
     }
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     CreateTableRequest request;
     CreateTableResponse response;
@@ -156,27 +174,30 @@ bool ClientImpl::CreateTable(const TableDescriptor& desc,
         internal_table_name = desc.TableName();
     }
     request.set_table_name(internal_table_name);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
     TableSchema* schema = request.mutable_schema();
 
     TableDescToSchema(desc, schema);
     schema->set_alias(desc.TableName());
     schema->set_name(internal_table_name);
-    // add delimiter
+    // add delimiter; reserve the repeated field up front so a large
+    // split list does not regrow it geometrically
     size_t delim_num = tablet_delim.size();
+    request.mutable_delimiters()->Reserve(delim_num);
     for (size_t i = 0; i < delim_num; ++i) {
-        const string& delim = tablet_delim[i];
-        request.add_delimiters(delim);
+        *request.mutable_delimiters()->Add() = tablet_delim[i];
     }
-    string reason;
     if (master_client.CreateTable(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
+            InvalidateCachedTableName(desc.TableName());
             return true;
         }
         LOG(ERROR) << reason << "| status: " << StatusCodeToString(response.status());
     } else {
-        reason = "rpc fail to create table:" + desc.TableName();
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to create table:" + desc.TableName();
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -188,30 +209,28 @@ bool ClientImpl::UpdateTableSchema(const TableDescriptor& desc, ErrorCode* err)
 }
 
 bool ClientImpl::UpdateTable(const TableDescriptor& desc, ErrorCode* err) {
-    if (!IsTableExist(desc.TableName(), err)) {
+    // one meta fetch answers existence, old schema and enable status,
+    // where separate IsTableExist/GetTableDescriptor/IsTableEnabled
+    // calls cost a meta scan each
+    TableMeta table_meta;
+    if (!FetchTableMeta(desc.TableName(), &table_meta, err)) {
         LOG(ERROR) << "table not exist: " << desc.TableName();
         return false;
     }
 
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     UpdateTableRequest request;
     UpdateTableResponse response;
     request.set_sequence_id(0);
     request.set_table_name(desc.TableName());
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
     TableSchema* schema = request.mutable_schema();
     TableDescToSchema(desc, schema);
 
-    ErrorCode err2;
-    TableDescriptor* old_desc = GetTableDescriptor(desc.TableName(), &err2);
-    if (old_desc == NULL) {
-        return false;
-    }
-    TableSchema old_schema;
-    TableDescToSchema(*old_desc, &old_schema);
-    delete old_desc;
+    const TableSchema& old_schema = table_meta.schema();
 
     // if try to update lg, need to disable table
     bool is_update_lg = IsSchemaLgDiff(*schema, old_schema);
@@ -219,20 +238,22 @@ bool ClientImpl::UpdateTable(const TableDescriptor& desc, ErrorCode* err) {
 
     // compatible for old-master which no support for online-schema-update
     if (!FLAGS_tera_online_schema_update_enabled
-        && IsTableEnabled(desc.TableName(), err)
+        && table_meta.status() == kTableEnable
         && (is_update_lg || is_update_cf)) {
         err->SetFailed(ErrorCode::kBadParam, "disable this table if you want to update (Lg | Cf) property(ies)");
         return false;
     }
 
-    string reason;
     if (master_client.UpdateTable(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
+            InvalidateCachedTableName(desc.TableName());
             return true;
         }
         LOG(ERROR) << reason << "| status: " << StatusCodeToString(response.status());
     } else {
-        reason = "rpc fail to update table:" + desc.TableName();
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to update table:" + desc.TableName();
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -240,22 +261,24 @@ bool ClientImpl::UpdateTable(const TableDescriptor& desc, ErrorCode* err) {
 }
 
 bool ClientImpl::UpdateCheck(const std::string& table_name, bool* done, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
     UpdateCheckRequest request;
     UpdateCheckResponse response;
     request.set_sequence_id(0);
     request.set_table_name(table_name);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
-    string reason;
     if (master_client.UpdateCheck(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
             *done = response.done();
             return true;
         }
         err->SetFailed(ErrorCode::kSystem, reason);
     } else {
-        reason = "rpc fail to update-check table:" + table_name;
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to update-check table:" + table_name;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
     return false;
@@ -271,21 +294,24 @@ bool ClientImpl::DeleteTable(const std::string& name, ErrorCode* err) {
         LOG(ERROR) << "faild to scan meta schema";
         return false;
     }
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     DeleteTableRequest request;
     DeleteTableResponse response;
     request.set_sequence_id(0);
     request.set_table_name(internal_table_name);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
-    string reason;
     if (master_client.DeleteTable(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
+            InvalidateCachedTableName(name);
             return true;
         }
     } else {
-        reason = "rpc fail to delete table: " + name;
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to delete table: " + name;
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -298,22 +324,25 @@ bool ClientImpl::DisableTable(const std::string& name, ErrorCode* err) {
         LOG(ERROR) << "faild to scan meta schema";
         return false;
     }
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     DisableTableRequest request;
     DisableTableResponse response;
     request.set_sequence_id(0);
     request.set_table_name(internal_table_name);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
-    string reason;
     if (master_client.DisableTable(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
+            InvalidateCachedTableName(name);
             return true;
         }
         LOG(ERROR) << reason << "| status: " << StatusCodeToString(response.status());
     } else {
-        reason = "rpc fail to disable table: " + name;
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to disable table: " + name;
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -321,7 +350,8 @@ bool ClientImpl::DisableTable(const std::string& name, ErrorCode* err) {
 }
 
 bool ClientImpl::EnableTable(const std::string& name, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
     std::string internal_table_name;
     if (!GetInternalTableName(name, err, &internal_table_name)) {
         LOG(ERROR) << "faild to scan meta schema";
@@ -331,16 +361,18 @@ bool ClientImpl::EnableTable(const std::string& name, ErrorCode* err) {
     EnableTableResponse response;
     request.set_sequence_id(0);
     request.set_table_name(internal_table_name);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
-    std::string reason;
     if (master_client.EnableTable(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
+            InvalidateCachedTableName(name);
             return true;
         }
         LOG(ERROR) << reason << "| status: " << StatusCodeToString(response.status());
     } else {
-        reason = "rpc fail to enable table: " + name;
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to enable table: " + name;
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -361,17 +393,18 @@ void ClientImpl::DoShowUser(OperateUserResponse& response,
 
 bool ClientImpl::OperateUser(UserInfo& operated_user, UserOperateType type,
                              std::vector<std::string>& user_groups, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
     OperateUserRequest request;
     OperateUserResponse response;
     request.set_sequence_id(0);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
     request.set_op_type(type);
     UserInfo* user_info = request.mutable_user_info();
     user_info->CopyFrom(operated_user);
-    std::string reason;
     if (master_client.OperateUser(&request, &response)) {
-        if (CheckReturnValue(response.status(), reason, err)) {
+        const char* reason = NULL;
+        if (CheckReturnValue(response.status(), &reason, err)) {
             if (type == kShowUser) {
                 DoShowUser(response, user_groups);
             }
@@ -379,7 +412,8 @@ bool ClientImpl::OperateUser(UserInfo& operated_user, UserOperateType type,
         }
         LOG(ERROR) << reason << "| status: " << StatusCodeToString(response.status());
     } else {
-        reason = "rpc fail to operate user: " + operated_user.user_name();
+        cluster_->InvalidateMasterAddr();
+        std::string reason = "rpc fail to operate user: " + operated_user.user_name();
         LOG(ERROR) << reason;
         err->SetFailed(ErrorCode::kSystem, reason);
     }
@@ -415,7 +449,7 @@ bool ClientImpl::ShowUser(const std::string& user, std::vector<std::string>& use
                           ErrorCode* err) {
     UserInfo user_info;
     user_info.set_user_name(user);
-    user_info.set_token(GetUserToken(user_identity_, user_passcode_));
+    user_info.set_token(user_token_);
     return OperateUser(user_info, kShowUser, user_groups, err);
 }
 
@@ -437,19 +471,270 @@ bool ClientImpl::DeleteUserFromGroup(const std::string& user_name,
     return OperateUser(user, kDeleteFromGroup, null, err);
 }
 
+static bool SkipWireField(google::protobuf::io::CodedInputStream* input,
+                          uint32_t tag) {
+    uint64_t dummy64;
+    uint32_t size;
+    switch (tag & 7) {
+        case 0:  // varint
+            return input->ReadVarint64(&dummy64);
+        case 1:  // fixed64
+            return input->Skip(8);
+        case 2:  // length-delimited
+            return input->ReadVarint32(&size) && input->Skip(size);
+        case 5:  // fixed32
+            return input->Skip(4);
+        default:  // groups are not used by tera protos
+            return false;
+    }
+}
+
+// decode only schema.name and schema.alias out of a serialized
+// TableMeta, skipping every other field; comparing the names of every
+// record in a meta scan this way costs two short string reads per
+// record instead of a full TableMeta parse. returns false when the
+// record has no schema or does not look like a TableMeta, in which
+// case the caller should fall back to a full parse.
+static bool PeekMetaTableNames(const std::string& value,
+                               std::string* name, std::string* alias) {
+    name->clear();
+    alias->clear();
+    google::protobuf::io::CodedInputStream input(
+        reinterpret_cast<const google::protobuf::uint8*>(value.data()),
+        value.size());
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        if (tag == ((3 << 3) | 2)) {  // TableMeta.schema, length-delimited
+            uint32_t schema_size;
+            if (!input.ReadVarint32(&schema_size)) {
+                return false;
+            }
+            google::protobuf::io::CodedInputStream::Limit limit =
+                input.PushLimit(schema_size);
+            uint32_t schema_tag;
+            uint32_t size;
+            while ((schema_tag = input.ReadTag()) != 0) {
+                if (schema_tag == ((2 << 3) | 2)) {  // TableSchema.name
+                    if (!input.ReadVarint32(&size)
+                        || !input.ReadString(name, size)) {
+                        return false;
+                    }
+                } else if (schema_tag == ((13 << 3) | 2)) {  // TableSchema.alias
+                    if (!input.ReadVarint32(&size)
+                        || !input.ReadString(alias, size)) {
+                        return false;
+                    }
+                } else if (!SkipWireField(&input, schema_tag)) {
+                    return false;
+                }
+            }
+            input.PopLimit(limit);
+            return true;
+        }
+        if (!SkipWireField(&input, tag)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// compare one meta record against `table_name' by name or alias,
+// decoding it into `*meta' only on a match; `peek_name'/`peek_alias'
+// are caller-owned scratch strings so their buffers are reused across
+// records
+static bool MatchMetaTableRecord(const std::string& key,
+                                 const std::string& value,
+                                 const std::string& table_name,
+                                 std::string* peek_name,
+                                 std::string* peek_alias,
+                                 TableMeta* meta) {
+    if (PeekMetaTableNames(value, peek_name, peek_alias)) {
+        if (*peek_name != table_name && *peek_alias != table_name) {
+            return false;
+        }
+        ParseMetaTableKeyValue(key, value, meta);
+        return true;
+    }
+    // unexpected encoding: let the real parser decide
+    ParseMetaTableKeyValue(key, value, meta);
+    return meta->schema().name() == table_name
+        || meta->schema().alias() == table_name;
+}
+
+// locate the meta record matching `table_name' by name or alias and
+// decode it into `*meta'; returns false if no record matches.
+//
+// records are keyed '@' + internal name and arrive sorted, and a table
+// created as `foo' has internal name `foo' or `foo@<timestamp>', so
+// the usual match lies in the narrow key range sharing the
+// '@' + table_name prefix: binary search there and decode only the
+// candidates instead of every record in the response. a renamed table
+// keeps its original internal name, so its alias may not share the
+// prefix -- when the fast path misses, fall back to the full walk.
+static bool FindMetaTableRecord(const ScanTabletResponse& response,
+                                const std::string& table_name,
+                                TableMeta* meta) {
+    const RowResult& records = response.results();
+    std::string peek_name;
+    std::string peek_alias;
+    static const int32_t kLinearScanMax = 32;
+    if (records.key_values_size() > kLinearScanMax) {
+        std::string key_prefix("@");
+        key_prefix.append(table_name);
+        int32_t lo = 0;
+        int32_t hi = records.key_values_size();
+        while (lo < hi) {
+            int32_t mid = lo + (hi - lo) / 2;
+            if (records.key_values(mid).key() < key_prefix) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        for (; lo < records.key_values_size(); ++lo) {
+            const string& key = records.key_values(lo).key();
+            if (key.size() < key_prefix.size()
+                || key.compare(0, key_prefix.size(), key_prefix) != 0) {
+                break;
+            }
+            if (key.size() > key_prefix.size()
+                && key[key_prefix.size()] != '@') {
+                // a longer table name sharing the prefix, e.g. `foobar'
+                continue;
+            }
+            if (MatchMetaTableRecord(key, records.key_values(lo).value(),
+                                     table_name, &peek_name, &peek_alias,
+                                     meta)) {
+                return true;
+            }
+        }
+    }
+    // the records are sorted, so the '@' table region is contiguous:
+    // locate its first row once instead of re-classifying every key
+    // in the loop
+    int32_t i = 0;
+    int32_t end = records.key_values_size();
+    while (i < end) {
+        int32_t mid = i + (end - i) / 2;
+        if (records.key_values(mid).key() < "@") {
+            i = mid + 1;
+        } else {
+            end = mid;
+        }
+    }
+    for (; i < records.key_values_size(); ++i) {
+        const string& key = records.key_values(i).key();
+        if (key.empty() || key[0] != '@') {
+            break;  // past the table region
+        }
+        if (MatchMetaTableRecord(key, records.key_values(i).value(),
+                                 table_name, &peek_name, &peek_alias,
+                                 meta)) {
+            return true;
+        }
+    }
+    meta->Clear();
+    return false;
+}
+
+// locate the meta record for `table_name' with buffer-bounded paged
+// scans over the '@'-keyed table region instead of one full-region
+// scan: each page is matched as it arrives and the scan stops at the
+// first hit, so the bytes received and parsed grow with the match
+// position rather than with the cluster's table count. returns false
+// on scan failure; `*found' reports whether a record matched and was
+// decoded into `*meta'.
+static bool ScanMetaTableForRecord(sdk::ClusterFinder* cluster,
+                                   const std::string& table_name,
+                                   TableMeta* meta,
+                                   bool* found) {
+    tabletnode::TabletNodeClient meta_client(cluster->RootTableAddr());
+    *found = false;
+    // table records are keyed '@' + name; ['@', '@~') covers exactly
+    // the table region
+    std::string scan_start("@");
+    while (true) {
+        ScanTabletRequest request;
+        ScanTabletResponse response;
+        request.set_sequence_id(0);
+        request.set_table_name(FLAGS_tera_master_meta_table_name);
+        request.set_start(scan_start);
+        request.set_end("@~");
+        request.set_buffer_limit(64 * 1024);
+        if (TERA_UNLIKELY(!meta_client.ScanTablet(&request, &response)
+                          || response.status() != kTabletNodeOk)) {
+            cluster->InvalidateRootTableAddr();
+            LOG(ERROR) << "fail to scan meta: "
+                       << StatusCodeToString(response.status());
+            return false;
+        }
+        if (FindMetaTableRecord(response, table_name, meta)) {
+            *found = true;
+            return true;
+        }
+        const RowResult& records = response.results();
+        if (records.key_values_size() == 0 || response.complete()) {
+            return true;
+        }
+        // resume one key past the last row of this page
+        scan_start = records.key_values(records.key_values_size() - 1).key();
+        scan_start.append(1, '\0');
+    }
+}
+
+namespace {
+
+// caches keyed by lookup name hold (value, fill time in us); bound
+// them by evicting the stalest entry once they outgrow `max_size', so
+// a client cycling through many one-off names cannot grow them
+// without limit. called with the owning mutex held, after an insert.
+template <typename Map>
+void TrimTimestampedCache(Map* cache, size_t max_size) {
+    if (cache->size() <= max_size) {
+        return;
+    }
+    typename Map::iterator victim = cache->begin();
+    for (typename Map::iterator it = cache->begin(); it != cache->end(); ++it) {
+        if (it->second.second < victim->second.second) {
+            victim = it;
+        }
+    }
+    cache->erase(victim);
+}
+
+const size_t kMaxCachedNameEntries = 1024;
+
+} // namespace
+
 bool ClientImpl::GetInternalTableName(const std::string& table_name, ErrorCode* err,
                                       std::string* internal_table_name) {
     *internal_table_name = table_name;
-    tabletnode::TabletNodeClient meta_client(cluster_->RootTableAddr(true));
-    ScanTabletRequest request;
-    ScanTabletResponse response;
-    request.set_sequence_id(0);
-    request.set_table_name(FLAGS_tera_master_meta_table_name);
-    request.set_start("");
-    request.set_end("@~");
-    if (!meta_client.ScanTablet(&request, &response)
-          || response.status() != kTabletNodeOk) {
-        LOG(ERROR) << "fail to scan meta: " << StatusCodeToString(response.status());
+    // without renaming, tables are created under their external name
+    // (see CreateTable), so resolution is the identity and the meta
+    // scan buys nothing
+    if (!FLAGS_tera_sdk_table_rename_enabled) {
+        if (err != NULL) {
+            err->SetFailed(ErrorCode::kOK);
+        }
+        return true;
+    }
+    int64_t cache_timeout_us = FLAGS_tera_sdk_table_name_cache_timeout * 1000000LL;
+    if (cache_timeout_us > 0) {
+        MutexLock lock(&table_name_cache_mutex_);
+        std::map<std::string, std::pair<std::string, int64_t> >::iterator it =
+            table_name_cache_.find(table_name);
+        if (it != table_name_cache_.end()
+            && get_micros() - it->second.second < cache_timeout_us) {
+            *internal_table_name = it->second.first;
+            if (err != NULL) {
+                err->SetFailed(ErrorCode::kOK);
+            }
+            return true;
+        }
+    }
+    TableMeta meta;
+    bool found = false;
+    if (!ScanMetaTableForRecord(cluster_, table_name, &meta, &found)) {
         if (err != NULL) {
             err->SetFailed(ErrorCode::kSystem, "system error");
         }
@@ -458,64 +743,112 @@ bool ClientImpl::GetInternalTableName(const std::string& table_name, ErrorCode*
     if (err != NULL) {
         err->SetFailed(ErrorCode::kOK);
     }
-    int32_t table_size = response.results().key_values_size();
-    for (int32_t i = 0; i < table_size; i++) {
-        const KeyValuePair& record = response.results().key_values(i);
-        const string& key = record.key();
-        const string& value = record.value();
-        if (key[0] == '@') {
-            TableMeta meta;
-            ParseMetaTableKeyValue(key, value, &meta);
-            if (meta.schema().alias() == table_name) {
-                *internal_table_name =  meta.table_name();
-                break;
+    if (found) {
+        *internal_table_name = meta.table_name();
+    }
+    if (cache_timeout_us > 0) {
+        MutexLock lock(&table_name_cache_mutex_);
+        table_name_cache_[table_name] =
+            std::make_pair(*internal_table_name, get_micros());
+        TrimTimestampedCache(&table_name_cache_, kMaxCachedNameEntries);
+    }
+    return true;
+}
+
+void ClientImpl::InvalidateCachedTableName(const std::string& table_name) {
+    {
+        MutexLock lock(&table_name_cache_mutex_);
+        table_name_cache_.erase(table_name);
+    }
+    MutexLock lock(&table_meta_cache_mutex_);
+    table_meta_cache_.erase(table_name);
+}
+
+bool ClientImpl::FetchTableMeta(const std::string& table_name,
+                                TableMeta* meta, ErrorCode* err) {
+    int64_t meta_ttl_us = FLAGS_tera_sdk_meta_cache_ttl_ms * 1000LL;
+    if (meta_ttl_us > 0) {
+        MutexLock lock(&table_meta_cache_mutex_);
+        std::map<std::string, std::pair<TableMeta, int64_t> >::iterator it =
+            table_meta_cache_.find(table_name);
+        if (it != table_meta_cache_.end()
+            && get_micros() - it->second.second < meta_ttl_us) {
+            meta->CopyFrom(it->second.first);
+            if (err != NULL) {
+                err->SetFailed(ErrorCode::kOK);
             }
-        } else if (key[0] > '@') {
-            break;
-        } else {
-            continue;
+            return true;
         }
     }
-    return true;
+    bool found = false;
+    if (!ScanMetaTableForRecord(cluster_, table_name, meta, &found)) {
+        if (err != NULL) {
+            err->SetFailed(ErrorCode::kSystem, "system error");
+        }
+        return false;
+    }
+    if (err != NULL) {
+        err->SetFailed(ErrorCode::kOK);
+    }
+    if (found) {
+        // the record carries the resolved name; refresh the name
+        // cache so the next admin op skips its scan
+        if (FLAGS_tera_sdk_table_name_cache_timeout > 0) {
+            MutexLock lock(&table_name_cache_mutex_);
+            table_name_cache_[table_name] =
+                std::make_pair(meta->table_name(), get_micros());
+            TrimTimestampedCache(&table_name_cache_, kMaxCachedNameEntries);
+        }
+        if (meta_ttl_us > 0) {
+            MutexLock lock(&table_meta_cache_mutex_);
+            std::pair<TableMeta, int64_t>& entry = table_meta_cache_[table_name];
+            entry.first.CopyFrom(*meta);
+            entry.second = get_micros();
+            TrimTimestampedCache(&table_meta_cache_, kMaxCachedNameEntries);
+        }
+        return true;
+    }
+    return false;
 }
 
 Table* ClientImpl::OpenTable(const std::string& table_name,
                              ErrorCode* err) {
-    open_table_mutex_.Lock();
-    TableHandle& th = open_table_map_[table_name];
+    TableShard* shard = GetTableShard(table_name);
+    MutexLock l(&shard->mutex);
+    TableHandle& th = shard->handles[table_name];
     th.ref++;
 
-    if (th.mu == NULL) {
-        // open a new table
+    if (th.ref == 1) {
+        // first opener: run the open outside the shard lock, then
+        // publish the result and wake any waiters; the held ref keeps
+        // the entry alive while the lock is dropped
         CHECK(th.handle == NULL);
-        th.mu = new Mutex();
-        th.mu->Lock();
-        open_table_mutex_.Unlock();
+        shard->mutex.Unlock();
         VLOG(10) << "open a new table: " << table_name;
-        th.handle = OpenTableInternal(table_name, &th.err);
-        th.mu->Unlock();
+        ErrorCode open_err;
+        Table* handle = OpenTableInternal(table_name, &open_err);
+        shard->mutex.Lock();
+        th.handle = handle;
+        th.err = open_err;
+        th.open_done = true;
+        shard->cond.Broadcast();
     } else {
-        open_table_mutex_.Unlock();
+        while (!th.open_done) {
+            shard->cond.Wait();
+        }
     }
 
-    th.mu->Lock();
     if (err) {
         *err = th.err;
     }
     if (th.handle == NULL) {
         VLOG(10) << "open null table: " << table_name;
-        th.mu->Unlock();
-        MutexLock l(&open_table_mutex_);
         if (--th.ref == 0) {
-            delete th.mu;
-            open_table_map_.erase(table_name);
+            shard->handles.erase(table_name);
         }
         return NULL;
     }
-
-    Table* table_impl = th.handle;
-    th.mu->Unlock();
-    return new TableWrapper(table_impl, this);
+    return new TableWrapper(th.handle, this);
 }
 
 TableImpl* ClientImpl::OpenTableInternal(const std::string& table_name,
@@ -547,18 +880,25 @@ TableImpl* ClientImpl::OpenTableInternal(const std::string& table_name,
 }
 
 void ClientImpl::CloseTable(const std::string& table_name) {
-    MutexLock l(&open_table_mutex_);
-    std::map<std::string, TableHandle>::iterator it;
-    it = open_table_map_.find(table_name);
-    assert(it != open_table_map_.end());
+    TableShard* shard = GetTableShard(table_name);
+    MutexLock l(&shard->mutex);
+    TableHandleMap::iterator it = shard->handles.find(table_name);
+    assert(it != shard->handles.end());
     TableHandle& h = it->second;
     h.ref--;
     if (h.ref == 0) {
         VLOG(10) << "close table: " << table_name;
         delete h.handle;
-        delete h.mu;
-        open_table_map_.erase(it);
+        shard->handles.erase(it);
+    }
+}
+
+ClientImpl::TableShard* ClientImpl::GetTableShard(const std::string& table_name) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < table_name.size(); ++i) {
+        hash = (hash ^ (unsigned char)table_name[i]) * 16777619u;
     }
+    return &open_table_shards_[hash & (kOpenTableShardNum - 1)];
 }
 
 bool ClientImpl::GetTabletLocation(const string& table_name,
@@ -572,26 +912,142 @@ bool ClientImpl::GetTabletLocation(const string& table_name,
         return false;
     }
 
-    for (int i = 0; i < tablet_list.meta_size(); ++i) {
-        ParseTabletEntry(tablet_list.meta(i), tablets);
+    int32_t meta_size = tablet_list.meta_size();
+    // entry conversion is independent per row, so large tables fan it
+    // out over the sdk pool; small lists stay serial to skip the
+    // dispatch and join cost
+    static const int32_t kParallelParseMin = 256;
+    if (meta_size < kParallelParseMin) {
+        tablets->reserve(tablets->size() + meta_size);
+        for (int32_t i = 0; i < meta_size; ++i) {
+            ParseTabletEntry(tablet_list.mutable_meta(i), tablets);
+        }
+        return true;
+    }
+
+    int32_t pool_threads = FLAGS_tera_sdk_thread_max_num;
+    if (pool_threads < 1) {
+        pool_threads = 1;
+    }
+    int32_t shard_size = (meta_size + pool_threads - 1) / pool_threads;
+    if (shard_size < 64) {
+        // keep each shard worth its dispatch
+        shard_size = 64;
+    }
+    int32_t shard_num = (meta_size + shard_size - 1) / shard_size;
+    std::vector<std::vector<TabletInfo> > shard_out(shard_num);
+    Counter pending;
+    pending.Set(shard_num - 1);
+    AutoResetEvent done;
+    for (int32_t s = 1; s < shard_num; ++s) {
+        int32_t begin = s * shard_size;
+        int32_t end = begin + shard_size;
+        if (end > meta_size) {
+            end = meta_size;
+        }
+        thread_pool_.AddTask(boost::bind(&ClientImpl::ParseTabletEntryShard,
+                                         this, &tablet_list, begin, end,
+                                         &shard_out[s], &pending, &done));
+    }
+    // the first shard runs on the calling thread while the pool
+    // drains the rest
+    shard_out[0].reserve(shard_size);
+    for (int32_t i = 0; i < shard_size && i < meta_size; ++i) {
+        ParseTabletEntry(tablet_list.mutable_meta(i), &shard_out[0]);
+    }
+    if (shard_num > 1) {
+        done.Wait();
+    }
+
+    size_t total = tablets->size();
+    for (int32_t s = 0; s < shard_num; ++s) {
+        total += shard_out[s].size();
+    }
+    tablets->reserve(total);
+    for (int32_t s = 0; s < shard_num; ++s) {
+        std::vector<TabletInfo>& part = shard_out[s];
+        for (size_t i = 0; i < part.size(); ++i) {
+            tablets->push_back(TabletInfo());
+            TabletInfo& dst = tablets->back();
+            dst.table_name.swap(part[i].table_name);
+            dst.path.swap(part[i].path);
+            dst.server_addr.swap(part[i].server_addr);
+            dst.start_key.swap(part[i].start_key);
+            dst.end_key.swap(part[i].end_key);
+            dst.data_size = part[i].data_size;
+            dst.status.swap(part[i].status);
+        }
+    }
+    return true;
+}
+
+void ClientImpl::ParseTabletEntryShard(TabletMetaList* tablet_list,
+                                       int32_t begin, int32_t end,
+                                       std::vector<TabletInfo>* out,
+                                       Counter* pending,
+                                       AutoResetEvent* done) {
+    out->reserve(end - begin);
+    for (int32_t i = begin; i < end; ++i) {
+        ParseTabletEntry(tablet_list->mutable_meta(i), out);
+    }
+    if (pending->Dec() == 0) {
+        done->Set();
+    }
+}
+
+bool ClientImpl::GetTabletLocation(const string& table_name,
+                                   TabletListSoA* tablets,
+                                   ErrorCode* err) {
+    TableMeta table_meta;
+    TabletMetaList tablet_list;
+
+    if (!ShowTablesInfo(table_name, &table_meta, &tablet_list, err)) {
+        LOG(ERROR) << "table not exist: " << table_name;
+        return false;
+    }
+
+    int32_t meta_size = tablet_list.meta_size();
+    tablets->table_names.reserve(tablets->table_names.size() + meta_size);
+    tablets->paths.reserve(tablets->paths.size() + meta_size);
+    tablets->server_addrs.reserve(tablets->server_addrs.size() + meta_size);
+    tablets->start_keys.reserve(tablets->start_keys.size() + meta_size);
+    tablets->end_keys.reserve(tablets->end_keys.size() + meta_size);
+    tablets->statuses.reserve(tablets->statuses.size() + meta_size);
+    tablets->data_sizes.reserve(tablets->data_sizes.size() + meta_size);
+    for (int32_t i = 0; i < meta_size; ++i) {
+        ParseTabletEntrySoA(tablet_list.mutable_meta(i), tablets);
     }
     return true;
 }
 
+void ClientImpl::ParseTabletEntrySoA(TabletMeta* meta, TabletListSoA* out) {
+    out->table_names.push_back(std::string());
+    out->table_names.back().swap(*meta->mutable_table_name());
+    out->paths.push_back(std::string());
+    out->paths.back().swap(*meta->mutable_path());
+    out->server_addrs.push_back(std::string());
+    out->server_addrs.back().swap(*meta->mutable_server_addr());
+    out->start_keys.push_back(std::string());
+    out->start_keys.back().swap(*meta->mutable_key_range()->mutable_key_start());
+    out->end_keys.push_back(std::string());
+    out->end_keys.back().swap(*meta->mutable_key_range()->mutable_key_end());
+    out->statuses.push_back(StatusCodeToString(meta->status()));
+    out->data_sizes.push_back(meta->size());
+}
+
 TableDescriptor* ClientImpl::GetTableDescriptor(const string& table_name,
                                                 ErrorCode* err) {
-    std::string internal_table_name;
-    if (!GetInternalTableName(table_name, err, &internal_table_name)) {
-        LOG(ERROR) << "faild to scan meta schema";
+    TableMeta meta;
+    if (!FetchTableMeta(table_name, &meta, err)) {
+        LOG(ERROR) << "table not exist: " << table_name;
         return NULL;
     }
-    std::vector<TableInfo> table_list;
-    ListInternal(&table_list, NULL, internal_table_name, "", 1, 0, err);
-    if (table_list.size() > 0
-        && table_list[0].table_desc->TableName() == internal_table_name) {
-        return table_list[0].table_desc;
+    TableDescriptor* desc = new TableDescriptor(meta.schema().name());
+    TableSchemaToDesc(meta.schema(), desc);
+    for (int i = 0; i < meta.snapshot_list_size(); ++i) {
+        desc->AddSnapshot(meta.snapshot_list(i));
     }
-    return NULL;
+    return desc;
 }
 
 //bool ClientImpl::List(std::vector<TableInfo>* table_list,
@@ -644,41 +1100,116 @@ bool ClientImpl::List(std::vector<TableInfo>* table_list, ErrorCode* err) {
                         0, err);
 }
 
+bool ClientImpl::ListBatch(const std::vector<std::string>& table_names,
+                           std::vector<TableInfo>* table_list,
+                           ErrorCode* err) {
+    table_list->clear();
+    table_list->resize(table_names.size());
+    for (size_t i = 0; i < table_list->size(); ++i) {
+        (*table_list)[i].table_desc = NULL;
+    }
+    if (table_names.empty()) {
+        if (err != NULL) {
+            err->SetFailed(ErrorCode::kOK);
+        }
+        return true;
+    }
+
+    // map each internal name to the output slot it fills; for
+    // duplicated input names the first occurrence wins
+    boost::unordered_map<std::string, size_t> slots;
+    std::string min_name;
+    std::string max_name;
+    for (size_t i = 0; i < table_names.size(); ++i) {
+        std::string internal_table_name;
+        if (!GetInternalTableName(table_names[i], err, &internal_table_name)) {
+            LOG(ERROR) << "faild to scan meta schema";
+            return false;
+        }
+        slots.insert(std::make_pair(internal_table_name, i));
+        if (min_name.empty() || internal_table_name < min_name) {
+            min_name = internal_table_name;
+        }
+        if (internal_table_name > max_name) {
+            max_name = internal_table_name;
+        }
+    }
+
+    master::MasterClient master_client(cluster_->MasterAddr());
+    uint64_t sequence_id = 0;
+    size_t remain = slots.size();
+    std::string start_name = min_name;
+    while (remain > 0) {
+        ShowTablesRequest request;
+        ShowTablesResponse response;
+        request.set_sequence_id(sequence_id++);
+        request.set_max_table_num(FLAGS_tera_sdk_show_max_num);
+        request.set_max_tablet_num(0);
+        request.set_start_table_name(start_name);
+        request.set_user_token(user_token_);
+        bool rpc_ok = master_client.ShowTables(&request, &response);
+        if (TERA_UNLIKELY(!rpc_ok || (response.status() != kMasterOk
+                                      && response.status() != kTableNotFound))) {
+            if (!rpc_ok) {
+                cluster_->InvalidateMasterAddr();
+            }
+            LOG(ERROR) << "fail to show tables from table: " << start_name
+                << ", status: " << StatusCodeToString(response.status());
+            if (err != NULL) {
+                err->SetFailed(ErrorCode::kSystem);
+            }
+            return false;
+        }
+        if (response.status() == kTableNotFound) {
+            // the start name sorts after every table: nothing left
+            break;
+        }
+        const tera::TableMetaList& table_meta_list = response.table_meta_list();
+        int32_t meta_size = table_meta_list.meta_size();
+        if (meta_size == 0) {
+            break;
+        }
+        for (int32_t i = 0; i < meta_size && remain > 0; ++i) {
+            const TableMeta& meta = table_meta_list.meta(i);
+            boost::unordered_map<std::string, size_t>::iterator it =
+                slots.find(meta.table_name());
+            if (it == slots.end()) {
+                // a table in the span nobody asked about
+                continue;
+            }
+            std::vector<TableInfo> entry;
+            ParseTableEntry(meta, &entry);
+            (*table_list)[it->second] = entry[0];
+            slots.erase(it);
+            remain--;
+        }
+        const std::string& last_name =
+            table_meta_list.meta(meta_size - 1).table_name();
+        if (last_name >= max_name
+            || meta_size < FLAGS_tera_sdk_show_max_num) {
+            break;
+        }
+        start_name = NextKey(last_name);
+    }
+    if (err != NULL) {
+        err->SetFailed(ErrorCode::kOK);
+    }
+    return true;
+}
+
 bool ClientImpl::ShowTableSchema(const string& name, TableSchema* schema,
                                  ErrorCode* err) {
-    tabletnode::TabletNodeClient meta_client(cluster_->RootTableAddr(true));
-    ScanTabletRequest request;
-    ScanTabletResponse response;
-    request.set_sequence_id(0);
-    request.set_table_name(FLAGS_tera_master_meta_table_name);
-    request.set_start("");
-    request.set_end("@~");
-    if (!meta_client.ScanTablet(&request, &response)
-        || response.status() != kTabletNodeOk) {
-        LOG(ERROR) << "fail to scan meta: " << StatusCodeToString(response.status());
+    TableMeta meta;
+    bool found = false;
+    if (!ScanMetaTableForRecord(cluster_, name, &meta, &found)) {
         err->SetFailed(ErrorCode::kSystem, "system error");
         return false;
     }
-    int32_t table_size = response.results().key_values_size();
-    for (int32_t i = 0; i < table_size; i++) {
-        const KeyValuePair& record = response.results().key_values(i);
-        const string& key = record.key();
-        const string& value = record.value();
-        if (key[0] == '@') {
-            TableMeta meta;
-            ParseMetaTableKeyValue(key, value, &meta);
-            if (meta.schema().name() == name
-                || meta.schema().alias() == name) {
-                *schema = meta.schema();
-                return true;
-            }
-        } else if (key[0] > '@') {
-            break;
-        } else {
-            continue;
-        }
+    if (!found) {
+        return false;
     }
-    return false;
+    schema->Swap(meta.mutable_schema());
+    return true;
 }
 
 // show exactly one table
@@ -699,7 +1230,7 @@ bool ClientImpl::ShowTablesInfo(const string& name,
         return false;
     }
     if (result) {
-        meta->CopyFrom(table_list.meta(0));
+        meta->Swap(table_list.mutable_meta(0));
     }
     return result;
 }
@@ -711,6 +1242,32 @@ bool ClientImpl::ShowTablesInfo(TableMetaList* table_list,
     return DoShowTablesInfo(table_list, tablet_list, "", is_brief, err);
 }
 
+void ClientImpl::ShowTablesRpcCallback(AutoResetEvent* event, bool* rpc_failed,
+                                       ShowTablesRequest* request,
+                                       ShowTablesResponse* response,
+                                       bool failed, int error_code) {
+    *rpc_failed = failed;
+    event->Set();
+}
+
+static void FillShowTablesRequest(const std::string& table_name,
+                                  const std::string& start_table_name,
+                                  const std::string& start_tablet_key,
+                                  const std::string& user_token,
+                                  bool is_brief,
+                                  ShowTablesRequest* request) {
+    request->Clear();
+    if (!table_name.empty()) {
+        request->set_max_table_num(1);
+    }
+    request->set_start_table_name(start_table_name);
+    request->set_start_tablet_key(start_tablet_key);
+    request->set_max_tablet_num(FLAGS_tera_sdk_show_max_num); //tablets be fetched at most in one RPC
+    request->set_sequence_id(0);
+    request->set_user_token(user_token);
+    request->set_all_brief(is_brief);
+}
+
 bool ClientImpl::DoShowTablesInfo(TableMetaList* table_list,
                                   TabletMetaList* tablet_list,
                                   const string& table_name,
@@ -729,78 +1286,110 @@ bool ClientImpl::DoShowTablesInfo(TableMetaList* table_list,
     bool has_error = false;
     bool table_meta_copied = false;
     std::string err_msg;
-    while(has_more && !has_error) {
-        ShowTablesRequest request;
-        ShowTablesResponse response;
-        if (!table_name.empty()) {
-            request.set_max_table_num(1);
-        }
-        request.set_start_table_name(start_table_name);
-        request.set_start_tablet_key(start_tablet_key);
-        request.set_max_tablet_num(FLAGS_tera_sdk_show_max_num); //tablets be fetched at most in one RPC
-        request.set_sequence_id(0);
-        request.set_user_token(GetUserToken(user_identity_, user_passcode_));
-        request.set_all_brief(is_brief);
-
-        if (master_client.ShowTables(&request, &response) &&
-            response.status() == kMasterOk) {
-            if (response.all_brief()) {
-                // show all table brief
-                table_list->CopyFrom(response.table_meta_list());
-                return true;
-            }
 
-            if (response.table_meta_list().meta_size() == 0) {
-                has_error = true;
-                err_msg = StatusCodeToString(response.status());
-                break;
+    // double-buffered pipeline: the cursor for the next batch depends
+    // only on the last record of the current one, so the next rpc is
+    // already in flight while this batch is filtered and copied into
+    // the output lists, overlapping the round-trip with the copy work
+    ShowTablesRequest request[2];
+    ShowTablesResponse response[2];
+    AutoResetEvent rpc_event;
+    bool rpc_failed = false;
+    int cur = 0;
+
+    FillShowTablesRequest(table_name, start_table_name, start_tablet_key,
+                          user_token_, is_brief, &request[cur]);
+    master_client.ShowTables(NULL, &request[cur], &response[cur],
+        NewClosure(this, &ClientImpl::ShowTablesRpcCallback, &rpc_event, &rpc_failed));
+
+    while (has_more && !has_error) {
+        rpc_event.Wait();
+        ShowTablesResponse* resp = &response[cur];
+        if (TERA_UNLIKELY(rpc_failed || resp->status() != kMasterOk)) {
+            if (rpc_failed) {
+                cluster_->InvalidateMasterAddr();
             }
-            if (!table_meta_copied) {
-                table_list->CopyFrom(response.table_meta_list());
-                table_meta_copied = true;
+            if (resp->status() != kMasterOk &&
+                resp->status() != kTableNotFound) {
+                has_error = true;
+                err_msg = StatusCodeToString(resp->status());
             }
-            if (response.tablet_meta_list().meta_size() == 0) {
+            has_more = false;
+            break;
+        }
+        if (resp->all_brief()) {
+            // show all table brief
+            table_list->Swap(resp->mutable_table_meta_list());
+            return true;
+        }
+
+        if (resp->table_meta_list().meta_size() == 0) {
+            has_error = true;
+            err_msg = StatusCodeToString(resp->status());
+            break;
+        }
+
+        int tablet_num = resp->tablet_meta_list().meta_size();
+        if (tablet_num == 0) {
+            has_more = false;
+        }
+
+        // advance the cursor from the last record before walking the
+        // batch, so the next fetch can start immediately
+        std::string prev_table_name = start_table_name;
+        std::string prev_tablet_key = start_tablet_key;
+        if (tablet_num > 0) {
+            const TabletMeta& last_meta = resp->tablet_meta_list().meta(tablet_num - 1);
+            start_table_name = last_meta.table_name();
+            const std::string& last_key = last_meta.key_range().key_start();
+            // compatible to old master
+            if (prev_table_name > start_table_name
+                || (prev_table_name == start_table_name && last_key <= prev_tablet_key)) {
+                LOG(WARNING) << "the master has older version";
                 has_more = false;
+            } else {
+                start_tablet_key = last_key;
             }
-            for(int i = 0; i < response.tablet_meta_list().meta_size(); i++){
-                const std::string& table_name = response.tablet_meta_list().meta(i).table_name();
-                const std::string& tablet_key = response.tablet_meta_list().meta(i).key_range().key_start();
-                // compatible to old master
-                if (table_name > start_table_name
-                    || (table_name == start_table_name && tablet_key >= start_tablet_key)) {
-                    tablet_list->add_meta()->CopyFrom(response.tablet_meta_list().meta(i));
-                    tablet_list->add_counter()->CopyFrom(response.tablet_meta_list().counter(i));
-                    // old tera master will not return timestamp #963
-                    if (response.tablet_meta_list().timestamp_size() > 0) {
-                        tablet_list->add_timestamp(response.tablet_meta_list().timestamp(i));
-                    }
-                }
-                if (i == response.tablet_meta_list().meta_size() - 1 ) {
-                    std::string prev_table_name = start_table_name;
-                    start_table_name = response.tablet_meta_list().meta(i).table_name();
-                    std::string last_key = response.tablet_meta_list().meta(i).key_range().key_start();
-                    if (prev_table_name > start_table_name
-                        || (prev_table_name == start_table_name && last_key <= start_tablet_key)) {
-                        LOG(WARNING) << "the master has older version";
-                        has_more = false;
-                        break;
-                    }
-                    start_tablet_key = last_key;
+        }
+        start_tablet_key.append(1,'\0'); // fetch next tablet
+
+        if (has_more) {
+            int next = 1 - cur;
+            FillShowTablesRequest(table_name, start_table_name, start_tablet_key,
+                                  user_token_, is_brief, &request[next]);
+            response[next].Clear();
+            master_client.ShowTables(NULL, &request[next], &response[next],
+                NewClosure(this, &ClientImpl::ShowTablesRpcCallback, &rpc_event, &rpc_failed));
+        }
+
+        if (!table_meta_copied) {
+            table_list->Swap(resp->mutable_table_meta_list());
+            table_meta_copied = true;
+        }
+        // steal the accepted records instead of deep-copying them; the
+        // cursor was already saved above and the response buffer is
+        // cleared before its next reuse, so the swapped-out husks are
+        // never read again
+        TabletMetaList* src = resp->mutable_tablet_meta_list();
+        for (int i = 0; i < tablet_num; i++) {
+            const std::string& meta_table_name = src->meta(i).table_name();
+            const std::string& tablet_key = src->meta(i).key_range().key_start();
+            // compatible to old master
+            if (meta_table_name > prev_table_name
+                || (meta_table_name == prev_table_name && tablet_key >= prev_tablet_key)) {
+                tablet_list->add_meta()->Swap(src->mutable_meta(i));
+                tablet_list->add_counter()->Swap(src->mutable_counter(i));
+                // old tera master will not return timestamp #963
+                if (src->timestamp_size() > 0) {
+                    tablet_list->add_timestamp(src->timestamp(i));
                 }
             }
-            start_tablet_key.append(1,'\0'); // fetch next tablet
-        } else {
-            if (response.status() != kMasterOk &&
-                response.status() != kTableNotFound) {
-                has_error = true;
-                err_msg = StatusCodeToString(response.status());
-            }
-            has_more = false;
         }
         VLOG(16) << "fetch meta table name: " << start_table_name
-                 << " tablet size: " << response.tablet_meta_list().meta_size()
+                 << " tablet size: " << tablet_num
                  << " next start: " << DebugString(start_tablet_key);
-    };
+        cur = 1 - cur;
+    }
 
     if (has_error) {
         LOG(ERROR) << "fail to show table info.";
@@ -822,22 +1411,25 @@ bool ClientImpl::ShowTabletNodesInfo(const string& addr,
     info->Clear();
     tablet_list->Clear();
 
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     ShowTabletNodesRequest request;
     ShowTabletNodesResponse response;
     request.set_sequence_id(0);
     request.set_addr(addr);
     request.set_is_showall(false);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
+    request.set_user_token(user_token_);
 
-    if (master_client.ShowTabletNodes(&request, &response) &&
-        response.status() == kMasterOk) {
+    if (TERA_LIKELY(master_client.ShowTabletNodes(&request, &response) &&
+                    response.status() == kMasterOk)) {
         if (response.tabletnode_info_size() == 0) {
             return false;
         }
-        info->CopyFrom(response.tabletnode_info(0));
-        tablet_list->CopyFrom(response.tabletmeta_list());
+        // the response is thrown away below: steal its messages
+        // instead of deep-copying a potentially multi-MB tablet list
+        info->Swap(response.mutable_tabletnode_info(0));
+        tablet_list->Swap(response.mutable_tabletmeta_list());
         return true;
     }
     LOG(ERROR) << "fail to show tabletnode info: " << addr;
@@ -852,20 +1444,25 @@ bool ClientImpl::ShowTabletNodesInfo(std::vector<TabletNodeInfo>* infos,
     }
     infos->clear();
 
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     ShowTabletNodesRequest request;
     ShowTabletNodesResponse response;
     request.set_sequence_id(0);
     request.set_is_showall(true);
 
-    if (master_client.ShowTabletNodes(&request, &response) &&
-        response.status() == kMasterOk) {
+    if (TERA_LIKELY(master_client.ShowTabletNodes(&request, &response) &&
+                    response.status() == kMasterOk)) {
         if (response.tabletnode_info_size() == 0) {
             return true;
         }
+        // reserve once, then swap each node entry out of the response
+        // rather than copying its repeated string fields
+        infos->reserve(response.tabletnode_info_size());
         for (int i = 0; i < response.tabletnode_info_size(); ++i) {
-            infos->push_back(response.tabletnode_info(i));
+            infos->push_back(TabletNodeInfo());
+            infos->back().Swap(response.mutable_tabletnode_info(i));
         }
         return true;
     }
@@ -892,39 +1489,20 @@ bool ClientImpl::List(const string& table_name, TableInfo* table_info,
 }
 
 bool ClientImpl::IsTableExist(const string& table_name, ErrorCode* err) {
-    std::vector<TableInfo> table_list;
-    std::string internal_table_name;
-    if (!GetInternalTableName(table_name, err, &internal_table_name)) {
-        LOG(ERROR) << "faild to scan meta schema";
-        return false;
-    }
-    ListInternal(&table_list, NULL, internal_table_name, "", 1, 0, err);
-    if (table_list.size() > 0
-        && table_list[0].table_desc->TableName() == internal_table_name) {
-        return true;
-    }
-    return false;
+    // existence is answered from the meta table's record region alone
+    // (cached, paged, no tablet metas and no master round-trip), so
+    // the response stays a few hundred bytes regardless of table size
+    TableMeta meta;
+    return FetchTableMeta(table_name, &meta, err);
 }
 
 bool ClientImpl::IsTableEnabled(const string& table_name, ErrorCode* err) {
-    std::vector<TableInfo> table_list;
-    std::string internal_table_name;
-    if (!GetInternalTableName(table_name, err, &internal_table_name)) {
-        LOG(ERROR) << "faild to scan meta schema";
-        return false;
-    }
-    ListInternal(&table_list, NULL, internal_table_name, "", 1, 0, err);
-    if (table_list.size() > 0
-        && table_list[0].table_desc->TableName() == internal_table_name) {
-        if (table_list[0].status == "kTableEnable") {
-            return true;
-        } else {
-            return false;
-        }
-    } else {
+    TableMeta meta;
+    if (!FetchTableMeta(table_name, &meta, err)) {
         LOG(ERROR) << "table not exist: " << table_name;
+        return false;
     }
-    return false;
+    return meta.status() == kTableEnable;
 }
 
 bool ClientImpl::IsTableEmpty(const string& table_name, ErrorCode* err) {
@@ -950,7 +1528,8 @@ bool ClientImpl::IsTableEmpty(const string& table_name, ErrorCode* err) {
 }
 
 bool ClientImpl::GetSnapshot(const string& name, uint64_t* snapshot, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     std::string internal_table_name;
     if (!GetInternalTableName(name, err, &internal_table_name)) {
@@ -962,20 +1541,21 @@ bool ClientImpl::GetSnapshot(const string& name, uint64_t* snapshot, ErrorCode*
     request.set_sequence_id(0);
     request.set_table_name(internal_table_name);
 
-    if (master_client.GetSnapshot(&request, &response)) {
+    if (TERA_LIKELY(master_client.GetSnapshot(&request, &response))) {
         if (response.status() == kMasterOk) {
-            std::cout << name << " get snapshot successfully" << std::endl;
+            VLOG(10) << name << " get snapshot successfully";
             *snapshot = response.snapshot_id();
             return true;
         }
     }
     err->SetFailed(ErrorCode::kSystem, StatusCodeToString(response.status()));
-    std::cout << name << " get snapshot failed";
+    LOG(ERROR) << name << " get snapshot failed";
     return false;
 }
 
 bool ClientImpl::DelSnapshot(const string& name, uint64_t snapshot, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     std::string internal_table_name;
     if (!GetInternalTableName(name, err, &internal_table_name)) {
@@ -988,20 +1568,21 @@ bool ClientImpl::DelSnapshot(const string& name, uint64_t snapshot, ErrorCode* e
     request.set_table_name(internal_table_name);
     request.set_snapshot_id(snapshot);
 
-    if (master_client.DelSnapshot(&request, &response)) {
+    if (TERA_LIKELY(master_client.DelSnapshot(&request, &response))) {
         if (response.status() == kMasterOk) {
-            std::cout << name << " del snapshot successfully" << std::endl;
+            VLOG(10) << name << " del snapshot successfully";
             return true;
         }
     }
     err->SetFailed(ErrorCode::kSystem, StatusCodeToString(response.status()));
-    std::cout << name << " del snapshot failed";
+    LOG(ERROR) << name << " del snapshot failed";
     return false;
 }
 
 bool ClientImpl::Rollback(const string& name, uint64_t snapshot,
                           const std::string& rollback_name, ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     std::string internal_table_name;
     if (!GetInternalTableName(name, err, &internal_table_name)) {
@@ -1014,16 +1595,15 @@ bool ClientImpl::Rollback(const string& name, uint64_t snapshot,
     request.set_table_name(internal_table_name);
     request.set_snapshot_id(snapshot);
     request.set_rollback_name(rollback_name);
-    std::cout << name << " " << rollback_name << std::endl;
 
-    if (master_client.GetRollback(&request, &response)) {
+    if (TERA_LIKELY(master_client.GetRollback(&request, &response))) {
         if (response.status() == kMasterOk) {
-            std::cout << name << " rollback to snapshot sucessfully" << std::endl;
+            VLOG(10) << name << " rollback to snapshot sucessfully";
             return true;
         }
     }
     err->SetFailed(ErrorCode::kSystem, StatusCodeToString(response.status()));
-    std::cout << name << " rollback to snapshot failed";
+    LOG(ERROR) << name << " rollback to snapshot failed";
     return false;
 }
 
@@ -1032,19 +1612,21 @@ bool ClientImpl::CmdCtrl(const string& command,
                          bool* bool_result,
                          string* str_result,
                          ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
 
     CmdCtrlRequest request;
     CmdCtrlResponse response;
     request.set_sequence_id(0);
     request.set_command(command);
     std::vector<string>::const_iterator it = arg_list.begin();
+    request.mutable_arg_list()->Reserve(arg_list.size());
     for (; it != arg_list.end(); ++it) {
         request.add_arg_list(*it);
     }
 
-    if (!master_client.CmdCtrl(&request, &response)
-        || response.status() != kMasterOk) {
+    if (TERA_UNLIKELY(!master_client.CmdCtrl(&request, &response)
+                      || response.status() != kMasterOk)) {
         LOG(ERROR) << "fail to run cmd: " << command;
         err->SetFailed(ErrorCode::kBadParam);
         return false;
@@ -1061,7 +1643,8 @@ bool ClientImpl::CmdCtrl(const string& command,
 bool ClientImpl::Rename(const std::string& old_table_name,
                         const std::string& new_table_name,
                         ErrorCode* err) {
-    master::MasterClient master_client(cluster_->MasterAddr());
+    MutexLock lock(&master_client_mutex_);
+    master::MasterClient& master_client = *GetMasterClient();
     RenameTableRequest request;
     RenameTableResponse response;
     uint64_t sequence_id = 0;
@@ -1069,10 +1652,12 @@ bool ClientImpl::Rename(const std::string& old_table_name,
     request.set_old_table_name(old_table_name);
     request.set_new_table_name(new_table_name);
     bool ok = master_client.RenameTable(&request, &response);
-    if (!ok || response.status() != kMasterOk) {
+    if (TERA_UNLIKELY(!ok || response.status() != kMasterOk)) {
         err->SetFailed(ErrorCode::kSystem, "failed to rename table");
         return false;
     }
+    InvalidateCachedTableName(old_table_name);
+    InvalidateCachedTableName(new_table_name);
     LOG(INFO) << "rename table OK. " << old_table_name
               << " -> " << new_table_name;
     return true;
@@ -1088,56 +1673,94 @@ bool ClientImpl::ListInternal(std::vector<TableInfo>* table_list,
     master::MasterClient master_client(cluster_->MasterAddr());
 
     uint64_t sequence_id = 0;
-    ShowTablesRequest request;
-    ShowTablesResponse response;
-    request.set_sequence_id(sequence_id);
-    request.set_max_table_num(max_table_found);
-    request.set_max_tablet_num(max_tablet_found);
-    request.set_start_table_name(start_table_name);
-    request.set_start_tablet_key(start_tablet_key);
-    request.set_user_token(GetUserToken(user_identity_, user_passcode_));
-
-    bool is_more = true;
-    while (is_more) {
-        if (!master_client.ShowTables(&request, &response)
-            || response.status() != kMasterOk) {
+    // double-buffered pipeline, as in DoShowTablesInfo: the next
+    // page's cursor depends only on the last record of the current
+    // one, so its rpc is already in flight while this page is parsed
+    ShowTablesRequest request[2];
+    ShowTablesResponse response[2];
+    AutoResetEvent rpc_event;
+    bool rpc_failed = false;
+    int cur = 0;
+
+    request[cur].set_sequence_id(sequence_id++);
+    request[cur].set_max_table_num(max_table_found);
+    request[cur].set_max_tablet_num(max_tablet_found);
+    request[cur].set_start_table_name(start_table_name);
+    request[cur].set_start_tablet_key(start_tablet_key);
+    request[cur].set_user_token(user_token_);
+    master_client.ShowTables(NULL, &request[cur], &response[cur],
+        NewClosure(this, &ClientImpl::ShowTablesRpcCallback, &rpc_event, &rpc_failed));
+
+    while (true) {
+        rpc_event.Wait();
+        ShowTablesResponse* resp = &response[cur];
+        if (TERA_UNLIKELY(rpc_failed || resp->status() != kMasterOk)) {
+            if (rpc_failed) {
+                cluster_->InvalidateMasterAddr();
+            }
             LOG(ERROR) << "fail to show tables from table: "
-                << request.start_table_name() << ", key: "
-                << request.start_tablet_key() << ", status: "
-                << StatusCodeToString(response.status());
+                << request[cur].start_table_name() << ", key: "
+                << request[cur].start_tablet_key() << ", status: "
+                << StatusCodeToString(resp->status());
             err->SetFailed(ErrorCode::kSystem);
             return false;
         }
 
-        const tera::TableMetaList& table_meta_list = response.table_meta_list();
-        const tera::TabletMetaList& tablet_meta_list = response.tablet_meta_list();
-        for (int32_t i = 0; i < table_meta_list.meta_size(); ++i) {
-            const TableMeta& meta = table_meta_list.meta(i);
-            ParseTableEntry(meta, table_list);
+        const tera::TableMetaList& table_meta_list = resp->table_meta_list();
+        tera::TabletMetaList* tablet_meta_list = resp->mutable_tablet_meta_list();
+        bool is_more = resp->has_is_more() && resp->is_more();
+        // launch the next fetch before parsing: the parse loops below
+        // move the strings out of the response
+        //argument @max_tablet_found maybe zero
+        bool fetch_next = is_more && tablet_meta_list->meta_size() > 0;
+        int next = 1 - cur;
+        if (fetch_next) {
+            const tera::TabletMeta& meta =
+                tablet_meta_list->meta(tablet_meta_list->meta_size() - 1);
+            const string& last_key = meta.key_range().key_start();
+            request[next].Clear();
+            request[next].set_sequence_id(sequence_id++);
+            request[next].set_max_table_num(max_table_found);
+            request[next].set_max_tablet_num(max_tablet_found);
+            request[next].set_start_table_name(meta.table_name());
+            request[next].set_start_tablet_key(tera::NextKey(last_key));
+            request[next].set_user_token(user_token_);
+            response[next].Clear();
+            master_client.ShowTables(NULL, &request[next], &response[next],
+                NewClosure(this, &ClientImpl::ShowTablesRpcCallback, &rpc_event, &rpc_failed));
         }
-        for (int32_t i = 0; i < tablet_meta_list.meta_size(); ++i) {
-            const TabletMeta& meta = tablet_meta_list.meta(i);
-            ParseTabletEntry(meta, tablet_list);
+        // grow the outputs once per page instead of letting push_back
+        // reallocate through the loops
+        if (table_list != NULL) {
+            table_list->reserve(table_list->size() + table_meta_list.meta_size());
         }
-        if (!response.has_is_more() || !response.is_more()) {
-            is_more = false;
-        } else {
-            if (tablet_meta_list.meta_size() == 0) { //argument @max_tablet_found maybe zero
-                break;
-            }
-            const tera::TabletMeta& meta = tablet_meta_list.meta(tablet_meta_list.meta_size()-1);
-            const string& last_key = meta.key_range().key_start();
-            request.set_start_table_name(meta.table_name());
-            request.set_start_tablet_key(tera::NextKey(last_key));
-            request.set_sequence_id(sequence_id++);
+        if (tablet_list != NULL) {
+            tablet_list->reserve(tablet_list->size() + tablet_meta_list->meta_size());
+        }
+        // walk the repeated fields by iterator: no per-iteration
+        // meta_size() call or index bounds check in the hot loop
+        typedef ::google::protobuf::RepeatedPtrField<TableMeta> TableMetaField;
+        for (TableMetaField::const_iterator it = table_meta_list.meta().begin();
+             it != table_meta_list.meta().end(); ++it) {
+            ParseTableEntry(*it, table_list);
+        }
+        typedef ::google::protobuf::RepeatedPtrField<TabletMeta> TabletMetaField;
+        TabletMetaField* tablet_metas = tablet_meta_list->mutable_meta();
+        for (TabletMetaField::iterator it = tablet_metas->begin();
+             it != tablet_metas->end(); ++it) {
+            ParseTabletEntry(&*it, tablet_list);
+        }
+        if (!fetch_next) {
+            break;
         }
+        cur = next;
     }
 
     return true;
 }
 
-bool ClientImpl::ParseTableEntry(const TableMeta meta, std::vector<TableInfo>* table_list) {
-    if (table_list == NULL) {
+bool ClientImpl::ParseTableEntry(const TableMeta& meta, std::vector<TableInfo>* table_list) {
+    if (TERA_UNLIKELY(table_list == NULL)) {
         return true;
     }
     TableInfo table_info;
@@ -1154,25 +1777,31 @@ bool ClientImpl::ParseTableEntry(const TableMeta meta, std::vector<TableInfo>* t
     return true;
 }
 
-bool ClientImpl::ParseTabletEntry(const TabletMeta& meta, std::vector<TabletInfo>* tablet_list) {
-    if (tablet_list == NULL) {
+bool ClientImpl::ParseTabletEntry(TabletMeta* meta, std::vector<TabletInfo>* tablet_list) {
+    if (TERA_UNLIKELY(tablet_list == NULL)) {
         return true;
     }
-    TabletInfo tablet;
-    tablet.table_name = meta.table_name();
-    tablet.path = meta.path();
-    tablet.start_key = meta.key_range().key_start();
-    tablet.end_key = meta.key_range().key_end();
-    tablet.server_addr = meta.server_addr();
-    tablet.data_size = meta.size();
-    tablet.status = StatusCodeToString(meta.status());
-
-    tablet_list->push_back(tablet);
+    // build the entry in place and steal the strings from the meta,
+    // which every caller throws away afterwards
+    tablet_list->push_back(TabletInfo());
+    TabletInfo& tablet = tablet_list->back();
+    tablet.table_name.swap(*meta->mutable_table_name());
+    tablet.path.swap(*meta->mutable_path());
+    tablet.start_key.swap(*meta->mutable_key_range()->mutable_key_start());
+    tablet.end_key.swap(*meta->mutable_key_range()->mutable_key_end());
+    tablet.server_addr.swap(*meta->mutable_server_addr());
+    tablet.data_size = meta->size();
+    tablet.status = StatusCodeToString(meta->status());
     return true;
 }
 
 static Mutex g_mutex;
 static bool g_is_glog_init = false;
+// points at the conf path of the last successful InitFlags; written
+// only under g_mutex, read without it on the NewClient fast path.
+// mixing distinct conf paths resets it to NULL so every call keeps
+// reloading and the last writer wins, as before.
+static const std::string* volatile g_inited_confpath = NULL;
 
 static int SpecifiedFlagfileCount(const std::string& confpath) {
     int count = 0;
@@ -1194,26 +1823,38 @@ static int InitFlags(const std::string& confpath, const std::string& log_prefix)
         return -1;
     }
 
-    if (!confpath.empty() && IsExist(confpath)){
+    if (!confpath.empty()) {
+        // an explicitly passed path must exist
+        if (!IsExist(confpath)) {
+            LOG(ERROR) << "specified config file(function argument) not found: "
+                << confpath;
+            return -1;
+        }
         flagfile = confpath;
-    } else if(!confpath.empty() && !IsExist(confpath)){
-        LOG(ERROR) << "specified config file(function argument) not found: "
-            << confpath;
-        return -1;
-    } else if (!FLAGS_tera_sdk_conf_file.empty() && IsExist(confpath)) {
+    } else if (!FLAGS_tera_sdk_conf_file.empty()) {
+        // probe the flag's own path; `confpath' is empty in this branch
+        if (!IsExist(FLAGS_tera_sdk_conf_file)) {
+            LOG(ERROR) << "specified config file(FLAGS_tera_sdk_conf_file) not found";
+            return -1;
+        }
         flagfile = FLAGS_tera_sdk_conf_file;
-    } else if (!FLAGS_tera_sdk_conf_file.empty() && !IsExist(confpath)) {
-        LOG(ERROR) << "specified config file(FLAGS_tera_sdk_conf_file) not found";
-        return -1;
-    } else if (IsExist("./tera.flag")) {
-        flagfile = "./tera.flag";
-    } else if (IsExist("../conf/tera.flag")) {
-        flagfile = "../conf/tera.flag";
-    } else if (IsExist(utils::GetValueFromEnv("TERA_CONF"))) {
-        flagfile = utils::GetValueFromEnv("TERA_CONF");
     } else {
-        LOG(ERROR) << "hasn't specify the flagfile, but default config file not found";
-        return -1;
+        // default candidates, one stat each
+        const std::string candidates[] = {
+            "./tera.flag",
+            "../conf/tera.flag",
+            utils::GetValueFromEnv("TERA_CONF"),
+        };
+        for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i) {
+            if (!candidates[i].empty() && IsExist(candidates[i])) {
+                flagfile = candidates[i];
+                break;
+            }
+        }
+        if (flagfile.empty()) {
+            LOG(ERROR) << "hasn't specify the flagfile, but default config file not found";
+            return -1;
+        }
     }
 
     utils::LoadFlagFile(flagfile);
@@ -1230,6 +1871,14 @@ static int InitFlags(const std::string& confpath, const std::string& log_prefix)
 }
 
 Client* Client::NewClient(const string& confpath, const string& log_prefix, ErrorCode* err) {
+    // fast path: the flags were already loaded from this very conf
+    // path and reloading them would be a no-op, so skip the global
+    // lock that otherwise serializes every client construction
+    const std::string* inited_confpath = g_inited_confpath;
+    if (inited_confpath != NULL && *inited_confpath == confpath) {
+        return new ClientImpl(FLAGS_tera_user_identity,
+                              FLAGS_tera_user_passcode);
+    }
     // Protect the section from [load flagfile] to [new a client instance],
     // because the client constructor will use flagfile options to initial its private options
     MutexLock locker(&g_mutex);
@@ -1240,6 +1889,14 @@ Client* Client::NewClient(const string& confpath, const string& log_prefix, Erro
         }
         return NULL;
     }
+    if (g_inited_confpath == NULL) {
+        g_inited_confpath = new std::string(confpath);
+    } else if (*g_inited_confpath != confpath) {
+        // distinct conf paths are being mixed: disable the fast path
+        // so each call reloads its own file (the string is leaked on
+        // purpose, a lock-free reader may still hold it)
+        g_inited_confpath = NULL;
+    }
     return new ClientImpl(FLAGS_tera_user_identity,
                           FLAGS_tera_user_passcode);
 }
@@ -5,17 +5,26 @@
 #ifndef TERA_SDK_CLIENT_IMPL_
 #define TERA_SDK_CLIENT_IMPL_
 
+#include <boost/unordered_map.hpp>
+
+#include "common/base/scoped_ptr.h"
+#include "common/event.h"
 #include "common/thread_pool.h"
 #include "proto/master_rpc.pb.h"
 #include "proto/tabletnode_client.h"
 #include "sdk/sdk_zk.h"
 #include "tera.h"
+#include "utils/counter.h"
 #include "utils/timer.h"
 
 using std::string;
 
 namespace tera {
 
+namespace master {
+class MasterClient;
+} // namespace master
+
 struct TSInfo {
     std::string addr;
     std::string query_status;
@@ -71,10 +80,33 @@ public:
                                    std::vector<TabletInfo>* tablets,
                                    ErrorCode* err);
 
+    /// column-oriented view of a tablet listing: consumers that scan
+    /// one field (size accounting, balance planning) walk one dense
+    /// vector instead of striding over whole TabletInfo structs; the
+    /// vectors are parallel, index i describes tablet i
+    struct TabletListSoA {
+        std::vector<std::string> table_names;
+        std::vector<std::string> paths;
+        std::vector<std::string> server_addrs;
+        std::vector<std::string> start_keys;
+        std::vector<std::string> end_keys;
+        std::vector<std::string> statuses;
+        std::vector<int64_t> data_sizes;
+    };
+
+    bool GetTabletLocation(const string& table_name, TabletListSoA* tablets,
+                           ErrorCode* err);
+
     virtual TableDescriptor* GetTableDescriptor(const string& table_name, ErrorCode* err);
 
     virtual bool List(std::vector<TableInfo>* table_list, ErrorCode* err);
 
+    /// probe many tables with one paged ShowTables sweep instead of
+    /// one rpc per table; `table_list' gets one entry per input name,
+    /// in input order, with a NULL table_desc for missing tables
+    bool ListBatch(const std::vector<std::string>& table_names,
+                   std::vector<TableInfo>* table_list, ErrorCode* err);
+
     virtual bool List(const string& table_name, TableInfo* table_info,
                       std::vector<TabletInfo>* tablet_list, ErrorCode* err);
 
@@ -126,18 +158,50 @@ private:
                       uint32_t max_tablet_found,
                       ErrorCode* err);
 
-    bool ParseTableEntry(const TableMeta meta,
+    bool ParseTableEntry(const TableMeta& meta,
                          std::vector<TableInfo>* table_list);
 
-    bool ParseTabletEntry(const TabletMeta& meta,
+    /// consumes `meta': its strings are moved into the entry
+    bool ParseTabletEntry(TabletMeta* meta,
                           std::vector<TabletInfo>* tablet_list);
 
+    /// consumes `meta' like ParseTabletEntry, but appends each field
+    /// to its column vector in `*out'
+    void ParseTabletEntrySoA(TabletMeta* meta, TabletListSoA* out);
+
+    /// parse entries [begin, end) of `tablet_list' into `*out'; the
+    /// worker that drops `pending' to zero signals `done'
+    void ParseTabletEntryShard(TabletMetaList* tablet_list,
+                               int32_t begin, int32_t end,
+                               std::vector<TabletInfo>* out,
+                               Counter* pending, AutoResetEvent* done);
+
     std::string GetUserToken(const std::string& user, const std::string& password);
     void DoShowUser(OperateUserResponse& response,
                     std::vector<std::string>& user_groups);
-    bool CheckReturnValue(StatusCode status, std::string& reason, ErrorCode* err);
+    /// maps a master response status to an sdk ErrorCode; `*reason' is
+    /// pointed at a string literal describing the status
+    bool CheckReturnValue(StatusCode status, const char** reason, ErrorCode* err);
     bool GetInternalTableName(const std::string& table_name, ErrorCode* err,
                               std::string* internal_table_name);
+    void InvalidateCachedTableName(const std::string& table_name);
+
+    /// resolve `table_name' (alias or internal name) and return its
+    /// full meta record in one meta-table scan; answers existence,
+    /// schema and status together where GetInternalTableName plus
+    /// ListInternal would cost two fetches
+    bool FetchTableMeta(const std::string& table_name, TableMeta* meta,
+                        ErrorCode* err);
+
+    /// returns the shared master client, re-pointed at the current
+    /// master address; master_client_mutex_ must be held across the
+    /// whole rpc, since the sync call path keeps per-client state
+    master::MasterClient* GetMasterClient();
+
+    void ShowTablesRpcCallback(AutoResetEvent* event, bool* rpc_failed,
+                               ShowTablesRequest* request,
+                               ShowTablesResponse* response,
+                               bool failed, int error_code);
 
     /// show all tables info: `table_name' should be an empty string
     /// show a single table info: `table_name' should be the table name
@@ -154,6 +218,9 @@ private:
 
     std::string user_identity_;
     std::string user_passcode_;
+    // credentials never change after construction, so the token they
+    // hash to is computed once instead of per admin rpc
+    std::string user_token_;
 
     /// cluster_ could cache the master_addr & root_table_addr.
     /// if there is no cluster_,
@@ -162,15 +229,56 @@ private:
     ///    we save master_addr & root_table_addr in cluster_, access zookeeper only once.
     sdk::ClusterFinder* cluster_;
 
-    Mutex open_table_mutex_;
+    // one long-lived master client shared by the one-shot admin rpcs,
+    // instead of a fresh channel lookup and stub allocation per call;
+    // paginated fetches keep their own local client so they do not pin
+    // this one across many round-trips -- that stays cheap because
+    // RpcClientBase pools the underlying tcp channels process-wide by
+    // address, so a local client never opens a new connection
+    Mutex master_client_mutex_;
+    scoped_ptr<master::MasterClient> master_client_;
+
     struct TableHandle {
         Table* handle;
-        Mutex* mu;
+        bool open_done;
         int ref;
         ErrorCode err;
-        TableHandle() : handle(NULL), mu(NULL), ref(0) {}
+        TableHandle() : handle(NULL), open_done(false), ref(0) {}
+    };
+    // handles are sharded by table name hash so concurrent open/close
+    // of different tables do not serialize on one client-wide mutex;
+    // ref counts are still mutated under the owning shard lock, which
+    // keeps the drop-to-zero erase race-free. concurrent openers of
+    // the same table wait on the shard condvar until the first opener
+    // publishes, instead of each entry allocating its own mutex
+    static const uint32_t kOpenTableShardNum = 16;
+    // hashed rather than ordered: lookups are exact-name only, and the
+    // node-based buckets keep TableHandle references stable while
+    // OpenTable drops the shard lock mid-open
+    typedef boost::unordered_map<std::string, TableHandle> TableHandleMap;
+    struct TableShard {
+        Mutex mutex;
+        CondVar cond;  // signalled when an in-flight open publishes
+        TableHandleMap handles;
+        TableShard() : cond(&mutex) {}
     };
-    std::map<std::string, TableHandle> open_table_map_;
+    TableShard open_table_shards_[kOpenTableShardNum];
+    TableShard* GetTableShard(const std::string& table_name);
+
+    // resolved-name cache: every admin op resolves the external table
+    // name through a meta scan first, and the mapping changes only on
+    // create/delete/update/rename, so short-lived entries absorb the
+    // repeated scans; value is (internal name, resolve time in us)
+    Mutex table_name_cache_mutex_;
+    std::map<std::string, std::pair<std::string, int64_t> > table_name_cache_;
+
+    // meta-record cache: IsTableExist/IsTableEnabled and friends are
+    // typically probed back-to-back by cli/etl flows, so a short-ttl
+    // copy of the fetched TableMeta collapses the repeated meta scans;
+    // dropped on every ddl issued through this client; value is
+    // (meta record, fetch time in us)
+    Mutex table_meta_cache_mutex_;
+    std::map<std::string, std::pair<TableMeta, int64_t> > table_meta_cache_;
 };
 
 } // namespace tera
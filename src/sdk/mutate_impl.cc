@@ -122,8 +122,20 @@ void RowMutationImpl::Append(const std::string& family, const std::string& quali
 /// 修改一个列
 void RowMutationImpl::Put(const std::string& family, const std::string& qualifier,
                           const int64_t value, int64_t timestamp) {
-    std::string value_str((char*)&value, sizeof(int64_t));
-    Put(family, qualifier, value_str, timestamp);
+    // 8字节的counter值不会超长，直接assign到mutation里，
+    // 省去中间临时string的一次分配和拷贝
+    SetErrorIfInvalid(qualifier, kQualifier);
+    RowMutation::Mutation& mutation = AddMutation();
+    mutation.type = RowMutation::kPut;
+    mutation.family = family;
+    mutation.qualifier = qualifier;
+    if (timestamp == -1) {
+        mutation.timestamp = kLatestTimestamp;
+    } else {
+        mutation.timestamp = timestamp;
+    }
+    mutation.value.assign((char*)&value, sizeof(int64_t));
+    mutation.ttl = -1;
 }
 
 /// 带TTL修改一个列
@@ -187,8 +199,7 @@ void RowMutationImpl::Put(const std::string& family, const std::string& qualifie
 
 /// 修改默认列
 void RowMutationImpl::Put(const int64_t value) {
-    std::string value_str((char*)&value, sizeof(int64_t));
-    Put(value_str, -1);
+    Put("", "", value, -1);
 }
 
 /// 带TTL的修改默认列
@@ -391,66 +402,43 @@ RowMutation::Mutation& RowMutationImpl::AddMutation() {
 }
 
 void SerializeMutation(const RowMutation::Mutation& src, tera::Mutation* dst) {
+    // 理想情况是把cell直接写进rpc输出流, 省掉中间pb消息; 但sofa-pbrpc
+    // 的stub只接受Message并在内部自行序列化, 做不到. 这里按字段类别
+    // 合并写出逻辑, 每个字段只出现一处, 去掉逐类型的重复代码块
+    switch (src.type) {
+        case RowMutation::kPut:          dst->set_type(tera::kPut);           break;
+        case RowMutation::kAdd:          dst->set_type(tera::kAdd);           break;
+        case RowMutation::kAddInt64:     dst->set_type(tera::kAddInt64);      break;
+        case RowMutation::kPutIfAbsent:  dst->set_type(tera::kPutIfAbsent);   break;
+        case RowMutation::kAppend:       dst->set_type(tera::kAppend);        break;
+        case RowMutation::kDeleteColumn: dst->set_type(tera::kDeleteColumn);  break;
+        case RowMutation::kDeleteColumns:dst->set_type(tera::kDeleteColumns); break;
+        case RowMutation::kDeleteFamily: dst->set_type(tera::kDeleteFamily);  break;
+        case RowMutation::kDeleteRow:    dst->set_type(tera::kDeleteRow);     break;
+        default:
+            assert(false);
+            break;
+    }
+    dst->set_timestamp(src.timestamp);
     switch (src.type) {
         case RowMutation::kPut:
-            dst->set_type(tera::kPut);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            dst->set_value(src.value);
             dst->set_ttl(src.ttl);
-            break;
+            // fall through
         case RowMutation::kAdd:
-            dst->set_type(tera::kAdd);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            dst->set_value(src.value);
-            break;
         case RowMutation::kAddInt64:
-            dst->set_type(tera::kAddInt64);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            dst->set_value(src.value);
-            break;
         case RowMutation::kPutIfAbsent:
-            dst->set_type(tera::kPutIfAbsent);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            dst->set_value(src.value);
-            break;
         case RowMutation::kAppend:
-            dst->set_type(tera::kAppend);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
             dst->set_value(src.value);
-            break;
+            // fall through
         case RowMutation::kDeleteColumn:
-            dst->set_type(tera::kDeleteColumn);
-            dst->set_family(src.family);
-            dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            break;
         case RowMutation::kDeleteColumns:
-            dst->set_type(tera::kDeleteColumns);
-            dst->set_family(src.family);
             dst->set_qualifier(src.qualifier);
-            dst->set_timestamp(src.timestamp);
-            break;
+            // fall through
         case RowMutation::kDeleteFamily:
-            dst->set_type(tera::kDeleteFamily);
             dst->set_family(src.family);
-            dst->set_timestamp(src.timestamp);
-            break;
-        case RowMutation::kDeleteRow:
-            dst->set_type(tera::kDeleteRow);
-            dst->set_timestamp(src.timestamp);
             break;
         default:
-            assert(false);
+            // kDeleteRow只带timestamp
             break;
     }
 }
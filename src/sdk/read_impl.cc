@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
 #include "sdk/read_impl.h"
 
 namespace tera {
@@ -128,10 +130,21 @@ std::string RowReaderImpl::Value() {
     }
 }
 
+/// 读取结果的引用
+const std::string& RowReaderImpl::ValueRef() {
+    // 字段未设置时protobuf返回默认空串的引用, 无需拷贝
+    return result_.key_values(result_pos_).value();
+}
+
 /// 读取的结果
 int64_t RowReaderImpl::ValueInt64() {
-    std::string v = Value();
-    return (v.size() == sizeof(int64_t)) ? *(int64_t*)v.c_str() : 0;
+    const std::string& v = ValueRef();
+    int64_t value = 0;
+    if (v.size() == sizeof(int64_t)) {
+        // memcpy既避免未对齐访问也不违反strict-aliasing
+        memcpy(&value, v.data(), sizeof(int64_t));
+    }
+    return value;
 }
 
 /// Timestamp
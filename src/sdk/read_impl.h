@@ -71,6 +71,8 @@ public:
     const std::string& RowKey();
     /// 读取的结果
     std::string Value();
+    /// 读取结果的引用, 不做拷贝; 仅限sdk内部使用, 引用随result_失效
+    const std::string& ValueRef();
     /// 读取的结果
     int64_t ValueInt64();
     /// Timestamp
@@ -103,6 +103,40 @@ bool SdkTimeoutManager::PutTask(SdkTask* task, int64_t timeout,
     return insert_success;
 }
 
+void SdkTimeoutManager::PutTasks(const std::vector<SdkTask*>& tasks,
+                                 const std::vector<int64_t>& timeouts,
+                                 SdkTask::TimeoutFunc timeout_func) {
+    CHECK_EQ(tasks.size(), timeouts.size());
+    int64_t now_ms = get_millis();
+    std::vector<SdkTask*> shard_tasks[kShardNum];
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        SdkTask* task = tasks[i];
+        int64_t task_id = task->GetId();
+        CHECK_GE(task_id, 0);
+        if (timeouts[i] > 0) {
+            task->SetDueTime(now_ms + timeouts[i]);
+            task->SetTimeoutFunc(timeout_func);
+        }
+        shard_tasks[Shard(task_id)].push_back(task);
+    }
+
+    for (uint32_t shard_id = 0; shard_id < kShardNum; shard_id++) {
+        std::vector<SdkTask*>& batch = shard_tasks[shard_id];
+        if (batch.empty()) {
+            continue;
+        }
+        TaskMap& map = map_shard_[shard_id];
+        Mutex& mutex = mutex_shard_[shard_id];
+
+        MutexLock l(&mutex);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (map.insert(batch[i]).second) {
+                batch[i]->IncRef();
+            }
+        }
+    }
+}
+
 SdkTask* SdkTimeoutManager::GetTask(int64_t task_id) {
     uint32_t shard_id = Shard(task_id);
     TaskMap& map = map_shard_[shard_id];
@@ -121,6 +155,38 @@ SdkTask* SdkTimeoutManager::GetTask(int64_t task_id) {
     }
 }
 
+void SdkTimeoutManager::GetTasks(const std::vector<int64_t>& ids,
+                                 std::vector<SdkTask*>* tasks) {
+    tasks->assign(ids.size(), NULL);
+
+    std::vector<size_t> shard_index[kShardNum];
+    for (size_t i = 0; i < ids.size(); ++i) {
+        shard_index[Shard(ids[i])].push_back(i);
+    }
+
+    for (uint32_t shard_id = 0; shard_id < kShardNum; shard_id++) {
+        std::vector<size_t>& index = shard_index[shard_id];
+        if (index.empty()) {
+            continue;
+        }
+        TaskMap& map = map_shard_[shard_id];
+        Mutex& mutex = mutex_shard_[shard_id];
+
+        MutexLock l(&mutex);
+        TaskIdIndex& id_index = map.get<INDEX_BY_ID>();
+        for (size_t i = 0; i < index.size(); ++i) {
+            int64_t task_id = ids[index[i]];
+            TaskIdIndex::iterator it = id_index.find(task_id);
+            if (it != id_index.end()) {
+                SdkTask* task = *it;
+                CHECK_EQ(task->GetId(), task_id);
+                task->IncRef();
+                (*tasks)[index[i]] = task;
+            }
+        }
+    }
+}
+
 SdkTask* SdkTimeoutManager::PopTask(int64_t task_id) {
     uint32_t shard_id = Shard(task_id);
     TaskMap& map = map_shard_[shard_id];
@@ -87,7 +87,21 @@ public:
     // timeout <= 0 means NEVER timeout
     bool PutTask(SdkTask* task, int64_t timeout = 0,
                  SdkTask::TimeoutFunc timeout_func = NULL);
+
+    // batched PutTask: tasks are grouped by shard first, so each shard
+    // mutex is taken once per batch instead of once per task;
+    // timeouts[i] <= 0 means tasks[i] NEVER timeout
+    void PutTasks(const std::vector<SdkTask*>& tasks,
+                  const std::vector<int64_t>& timeouts,
+                  SdkTask::TimeoutFunc timeout_func = NULL);
     SdkTask* GetTask(int64_t task_id);
+
+    // batched GetTask: ids are grouped by shard first, so each shard
+    // mutex is taken once per batch; (*tasks)[i] is NULL when ids[i]
+    // is not in the pool, found tasks carry a reference like GetTask
+    void GetTasks(const std::vector<int64_t>& ids,
+                  std::vector<SdkTask*>* tasks);
+
     SdkTask* PopTask(int64_t task_id);
 
     void CheckTimeout();
@@ -25,14 +25,20 @@ namespace tera {
 namespace sdk {
 
 std::string ClusterFinder::MasterAddr(bool update) {
-    std::string master_addr;
-    if (update || master_addr_ == "") {
-        if (!ReadNode(kMasterNodePath, &master_addr)) {
-            master_addr = "";
+    if (!update) {
+        // happy path: no zk traffic, and the copy is made under the
+        // lock so a concurrent refresh cannot tear it
+        MutexLock lock(&mutex_);
+        if (!master_addr_.empty()) {
+            return master_addr_;
         }
     }
+    std::string master_addr;
+    if (!ReadNode(kMasterNodePath, &master_addr)) {
+        master_addr = "";
+    }
+    MutexLock lock(&mutex_);
     if (!master_addr.empty()) {
-        MutexLock lock(&mutex_);
         master_addr_ = master_addr;
         LOG(INFO) << "master addr: " << master_addr_;
     }
@@ -40,20 +46,34 @@ std::string ClusterFinder::MasterAddr(bool update) {
 }
 
 std::string ClusterFinder::RootTableAddr(bool update) {
-    std::string root_table_addr;
-    if (update || root_table_addr_ == "") {
-        if (!ReadNode(kRootTabletNodePath, &root_table_addr)) {
-            root_table_addr = "";
+    if (!update) {
+        MutexLock lock(&mutex_);
+        if (!root_table_addr_.empty()) {
+            return root_table_addr_;
         }
     }
+    std::string root_table_addr;
+    if (!ReadNode(kRootTabletNodePath, &root_table_addr)) {
+        root_table_addr = "";
+    }
+    MutexLock lock(&mutex_);
     if (!root_table_addr.empty()) {
-        MutexLock lock(&mutex_);
         root_table_addr_ = root_table_addr;
         LOG(INFO) << "root addr: " << root_table_addr_;
     }
     return root_table_addr_;
 }
 
+void ClusterFinder::InvalidateMasterAddr() {
+    MutexLock lock(&mutex_);
+    master_addr_.clear();
+}
+
+void ClusterFinder::InvalidateRootTableAddr() {
+    MutexLock lock(&mutex_);
+    root_table_addr_.clear();
+}
+
 std::string ClusterFinder::ClusterId() {
     std::string name = Name();
     std::string authority = Authority();
@@ -19,6 +19,11 @@ public:
     virtual ~ClusterFinder() {}
     std::string MasterAddr(bool update = false);
     std::string RootTableAddr(bool update = false);
+    // drop the cached address so the next lookup re-reads zk; called
+    // when an rpc to the cached address fails, instead of paying a zk
+    // read on every call just in case the server moved
+    void InvalidateMasterAddr();
+    void InvalidateRootTableAddr();
     std::string ClusterId(); // cluster URI: <scheme>://<authority>/<path>
 
 private:
@@ -8,16 +8,21 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
+#include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 #include <boost/bind.hpp>
+#include <boost/unordered_map.hpp>
 #include <gflags/gflags.h>
 
+#include "common/base/likely.h"
 #include "common/base/string_format.h"
+#include "common/base/string_number.h"
 #include "common/file/file_path.h"
 #include "common/file/recordio/record_io.h"
 
@@ -38,12 +43,14 @@
 
 DECLARE_string(tera_master_meta_table_name);
 DECLARE_int32(tera_sdk_delay_send_internal);
+DECLARE_int32(tera_sdk_delay_send_max_internal);
 DECLARE_int32(tera_sdk_retry_times);
 DECLARE_int32(tera_sdk_retry_period);
 DECLARE_int32(tera_sdk_update_meta_internal);
 DECLARE_bool(tera_sdk_write_sync);
 DECLARE_int32(tera_sdk_batch_size);
 DECLARE_int32(tera_sdk_write_send_interval);
+DECLARE_int32(tera_sdk_max_inflight_batch_rpc);
 DECLARE_int32(tera_sdk_read_send_interval);
 DECLARE_int64(tera_sdk_max_mutation_pending_num);
 DECLARE_int64(tera_sdk_max_reader_pending_num);
@@ -61,6 +68,27 @@ DECLARE_int32(tera_rpc_timeout_period);
 
 namespace tera {
 
+// maps a sofa-pbrpc transport error to the StatusCode the retry logic
+// keys on; shared by every rpc callback in this file
+static StatusCode TranslateRpcError(int error_code) {
+    switch (error_code) {
+    case sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN:
+    case sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE:
+    case sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE:
+        return kServerError;
+    case sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED:
+    case sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL:
+        return kClientError;
+    case sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED:
+    case sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS:
+        return kConnectError;
+    case sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT:
+        return kRPCTimeout;
+    default:
+        return kRPCError;
+    }
+}
+
 TableImpl::TableImpl(const std::string& table_name,
                      common::ThreadPool* thread_pool,
                      sdk::ClusterFinder* cluster)
@@ -71,15 +99,17 @@ TableImpl::TableImpl(const std::string& table_name,
       commit_size_(FLAGS_tera_sdk_batch_size),
       write_commit_timeout_(FLAGS_tera_sdk_write_send_interval),
       read_commit_timeout_(FLAGS_tera_sdk_read_send_interval),
-      mutation_batch_seq_(0),
-      reader_batch_seq_(0),
       max_commit_pending_num_(FLAGS_tera_sdk_max_mutation_pending_num),
       max_reader_pending_num_(FLAGS_tera_sdk_max_reader_pending_num),
-      meta_cond_(&meta_mutex_),
-      meta_updating_count_(0),
+      async_blocking_enabled_(FLAGS_tera_sdk_async_blocking_enabled),
+      max_inflight_batch_rpc_(FLAGS_tera_sdk_max_inflight_batch_rpc),
+      pending_cond_(&pending_mutex_),
+      meta_cond_(&meta_sync_mutex_),
       table_meta_cond_(&table_meta_mutex_),
       table_meta_updating_(false),
       task_pool_(thread_pool),
+      mutation_timeout_func_(boost::bind(&TableImpl::MutationTimeout, this, _1)),
+      reader_timeout_func_(boost::bind(&TableImpl::ReaderTimeout, this, _1)),
       master_client_(NULL),
       tabletnode_client_(NULL),
       thread_pool_(thread_pool),
@@ -90,6 +120,50 @@ TableImpl::TableImpl(const std::string& table_name,
         cluster_ = sdk::NewClusterFinder();
         cluster_private_ = true;
     }
+    // 预计算重试退避表, 重试路径上查表即可, 不再每次调pow做浮点运算;
+    // 每档封顶, 防止高重试档位算出小时级的间隔
+    retry_backoff_ms_.reserve(FLAGS_tera_sdk_retry_times + 1);
+    for (int32_t i = 0; i <= FLAGS_tera_sdk_retry_times; ++i) {
+        int64_t delay_ms =
+            static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal, i) * 1000);
+        if (delay_ms > FLAGS_tera_sdk_delay_send_max_internal) {
+            delay_ms = FLAGS_tera_sdk_delay_send_max_internal;
+        }
+        retry_backoff_ms_.push_back(delay_ms);
+    }
+}
+
+// 线程局部的xorshift64随机数, 给退避间隔加抖动用;
+// 不用rand()是因为glibc实现内部带全局锁
+static uint64_t FastRand() {
+    static __thread uint64_t rand_state = 0;
+    if (rand_state == 0) {
+        rand_state = (uint64_t)common::timer::get_micros() ^ (uint64_t)pthread_self();
+    }
+    rand_state ^= rand_state << 13;
+    rand_state ^= rand_state >> 7;
+    rand_state ^= rand_state << 17;
+    return rand_state;
+}
+
+int64_t TableImpl::RetryBackoffMs(uint32_t retry_times) {
+    if (retry_times >= retry_backoff_ms_.size()) {
+        retry_times = retry_backoff_ms_.size() - 1;
+    }
+    int64_t delay_ms = retry_backoff_ms_[retry_times];
+    // 加最多25%的抖动: 同一批失败的请求落在同一档时,
+    // 把重试在时间上摊开, 避免对同一tabletnode的重试风暴
+    return delay_ms + (int64_t)(FastRand() % ((uint64_t)delay_ms / 4 + 1));
+}
+
+tabletnode::TabletNodeClient* TableImpl::GetTabletNodeClient(
+        const std::string& server_addr) {
+    MutexLock lock(&client_cache_mutex_);
+    tabletnode::TabletNodeClient*& client = client_cache_[server_addr];
+    if (client == NULL) {
+        client = new tabletnode::TabletNodeClient(server_addr);
+    }
+    return client;
 }
 
 TableImpl::~TableImpl() {
@@ -100,6 +174,11 @@ TableImpl::~TableImpl() {
     if (cluster_private_) {
         delete cluster_;
     }
+    std::map<std::string, tabletnode::TabletNodeClient*>::iterator it =
+        client_cache_.begin();
+    for (; it != client_cache_.end(); ++it) {
+        delete it->second;
+    }
 }
 
 RowMutation* TableImpl::NewRowMutation(const std::string& row_key) {
@@ -135,6 +214,7 @@ void TableImpl::ApplyMutation(RowMutation* row_mu) {
 
 void TableImpl::ApplyMutation(const std::vector<RowMutation*>& row_mutations) {
     std::vector<RowMutationImpl*> mu_list;
+    mu_list.reserve(row_mutations.size());
     for (uint32_t i = 0; i < row_mutations.size(); i++) {
         if (row_mutations[i]->GetError().GetType() != ErrorCode::kOK) {
             ThreadPool::Task task =
@@ -151,8 +231,11 @@ void TableImpl::ApplyMutation(const std::vector<RowMutation*>& row_mutations) {
 bool TableImpl::Put(const std::string& row_key, const std::string& family,
                     const std::string& qualifier, const int64_t value,
                     ErrorCode* err) {
-    std::string value_str((char*)&value, sizeof(int64_t));
-    return Put(row_key, family, qualifier, value_str, err);
+    RowMutation* row_mu = NewRowMutation(row_key);
+    row_mu->Put(family, qualifier, value);
+    ApplyMutation(row_mu);
+    *err = row_mu->GetError();
+    return (err->GetType() == ErrorCode::kOK ? true : false);
 }
 
 bool TableImpl::Put(const std::string& row_key, const std::string& family,
@@ -290,11 +373,20 @@ bool TableImpl::Get(const std::string& row_key, const std::string& family,
 bool TableImpl::Get(const std::string& row_key, const std::string& family,
                     const std::string& qualifier, int64_t* value,
                     uint64_t snapshot_id, ErrorCode* err) {
-    std::string value_str;
-    if (Get(row_key, family, qualifier, &value_str, err, snapshot_id)
-        && value_str.size() == sizeof(int64_t)) {
-        *value = *(int64_t*)value_str.c_str();
-        return true;
+    RowReader* row_reader = NewRowReader(row_key);
+    row_reader->AddColumn(family, qualifier);
+    row_reader->SetSnapshot(snapshot_id);
+    Get(row_reader);
+    *err = row_reader->GetError();
+    if (err->GetType() == ErrorCode::kOK) {
+        // 直接引用读取结果的8个字节, 不经过std::string中转拷贝;
+        // memcpy避免未对齐访问和strict-aliasing问题
+        const std::string& value_ref =
+            static_cast<RowReaderImpl*>(row_reader)->ValueRef();
+        if (value_ref.size() == sizeof(int64_t)) {
+            memcpy(value, value_ref.data(), sizeof(int64_t));
+            return true;
+        }
     }
     return false;
 }
@@ -361,7 +453,7 @@ void TableImpl::ScanTabletAsync(ScanTask* scan_task, bool called_by_user) {
 
 void TableImpl::CommitScan(ScanTask* scan_task,
                            const std::string& server_addr) {
-    tabletnode::TabletNodeClient tabletnode_client(server_addr);
+    tabletnode::TabletNodeClient* tabletnode_client = GetTabletNodeClient(server_addr);
     ResultStreamImpl* stream = scan_task->stream;
     ScanTabletRequest* request = scan_task->request;
     ScanTabletResponse* response = scan_task->response;
@@ -400,15 +492,21 @@ void TableImpl::CommitScan(ScanTask* scan_task,
         FilterList* filter_list = request->mutable_filter_list();
         filter_list->CopyFrom(impl->GetFilterList());
     }
-    for (int32_t i = 0; i < impl->GetSizeofColumnFamilyList(); ++i) {
-        tera::ColumnFamily* column_family = request->add_cf_list();
-        column_family->CopyFrom(*(impl->GetColumnFamily(i)));
+    // the scan descriptor has to stay intact for the next page and for
+    // retries, so its messages are copied rather than swapped out; the
+    // Reserve keeps the repeated field from growing element by element
+    int32_t cf_num = impl->GetSizeofColumnFamilyList();
+    if (cf_num > 0) {
+        request->mutable_cf_list()->Reserve(cf_num);
+        for (int32_t i = 0; i < cf_num; ++i) {
+            request->add_cf_list()->CopyFrom(*(impl->GetColumnFamily(i)));
+        }
     }
 
     request->set_timestamp(common::timer::get_micros());
     Closure<void, ScanTabletRequest*, ScanTabletResponse*, bool, int>* done =
         NewClosure(this, &TableImpl::ScanCallBack, scan_task);
-    tabletnode_client.ScanTablet(request, response, done);
+    tabletnode_client->ScanTablet(request, response, done);
 }
 
 void TableImpl::ScanCallBack(ScanTask* scan_task,
@@ -420,21 +518,7 @@ void TableImpl::ScanCallBack(ScanTask* scan_task,
     ResultStreamImpl* stream = scan_task->stream;
 
     if (failed) {
-        if (error_code == sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE) {
-            response->set_status(kServerError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL) {
-            response->set_status(kClientError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS) {
-            response->set_status(kConnectError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT) {
-            response->set_status(kRPCTimeout);
-        } else {
-            response->set_status(kRPCError);
-        }
+        response->set_status(TranslateRpcError(error_code));
     }
 
     StatusCode err = response->status();
@@ -461,9 +545,7 @@ void TableImpl::ScanCallBack(ScanTask* scan_task,
         ThreadPool::Task retry_task =
             boost::bind(&TableImpl::ScanTabletAsync, this, scan_task, false);
         CHECK(scan_task->RetryTimes() > 0);
-        int64_t retry_interval =
-            static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal,
-                                     scan_task->RetryTimes() - 1) * 1000);
+        int64_t retry_interval = RetryBackoffMs(scan_task->RetryTimes() - 1);
         thread_pool_->DelayTask(retry_interval, retry_task);
     }
 }
@@ -507,9 +589,30 @@ struct MuFlushPair {
     MuFlushPair() : flush(false) {}
 };
 
+void TableImpl::WaitPendingDrained(Counter* counter, int64_t max_pending) {
+    pending_waiter_counter_.Inc();
+    MutexLock lock(&pending_mutex_);
+    while (counter->Get() > max_pending) {
+        pending_cond_.Wait();
+    }
+    pending_waiter_counter_.Dec();
+}
+
+void TableImpl::SignalPendingDrained() {
+    // waiter先登记计数再拿锁检查pending值，所以这里读到0时
+    // 不会丢失唤醒；无人等待的常规回调路径因此不必加锁
+    if (pending_waiter_counter_.Get() > 0) {
+        MutexLock lock(&pending_mutex_);
+        pending_cond_.Broadcast();
+    }
+}
+
 void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list,
                                     bool called_by_user) {
-    typedef std::map<std::string, MuFlushPair> TsMuMap;
+    // hashed rather than ordered: the grouping is ephemeral and commit
+    // order across tabletnodes does not matter, so there is no reason
+    // to pay a tree node allocation and O(log N) walk per mutation
+    typedef boost::unordered_map<std::string, MuFlushPair> TsMuMap;
     TsMuMap ts_mu_list;
 
     int64_t sync_min_timeout = -1;
@@ -527,13 +630,18 @@ void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list
                 }
             }
         }
-    }
 
-    for (uint32_t i = 0; i < mu_list.size(); i++) {
-        RowMutationImpl* row_mutation = (RowMutationImpl*)mu_list[i];
-        perf_counter_.mutate_cnt.Inc();
-        if (called_by_user) {
-            row_mutation->SetId(next_task_id_.Inc());
+        // register the whole batch in the task pool with one bulk
+        // insert, taking each pool shard mutex once instead of per row
+        std::vector<SdkTask*> batch_tasks;
+        std::vector<int64_t> batch_timeouts;
+        batch_tasks.reserve(mu_list.size());
+        batch_timeouts.reserve(mu_list.size());
+        // 一次原子加领出整批id, 每行只做本地加法
+        int64_t base_id = next_task_id_.Add(mu_list.size()) - mu_list.size();
+        for (uint32_t i = 0; i < mu_list.size(); i++) {
+            RowMutationImpl* row_mutation = (RowMutationImpl*)mu_list[i];
+            row_mutation->SetId(base_id + 1 + i);
 
             int64_t row_timeout = -1;
             if (!row_mutation->IsAsync()) {
@@ -541,20 +649,29 @@ void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list
             } else {
                 row_timeout = row_mutation->TimeOut() > 0 ? row_mutation->TimeOut() : timeout_;
             }
-            SdkTask::TimeoutFunc task = boost::bind(&TableImpl::MutationTimeout, this, _1);
-            task_pool_.PutTask(row_mutation, row_timeout, task);
+            batch_tasks.push_back(row_mutation);
+            batch_timeouts.push_back(row_timeout);
         }
+        task_pool_.PutTasks(batch_tasks, batch_timeouts, mutation_timeout_func_);
+    }
+
+    // 整批一次累加, 不在循环里逐行做原子加
+    perf_counter_.mutate_cnt.Add(mu_list.size());
+    std::string last_addr;
+    MuFlushPair* last_pair = NULL;
+    TabletRouteHint route_hint;
+    for (uint32_t i = 0; i < mu_list.size(); i++) {
+        RowMutationImpl* row_mutation = (RowMutationImpl*)mu_list[i];
 
         // flow control
         if (called_by_user
             && cur_commit_pending_counter_.Add(row_mutation->MutationNum()) > max_commit_pending_num_
             && row_mutation->IsAsync()) {
-            if (FLAGS_tera_sdk_async_blocking_enabled) {
-                while (cur_commit_pending_counter_.Get() > max_commit_pending_num_) {
-                    usleep(100000);
-                }
+            if (async_blocking_enabled_) {
+                WaitPendingDrained(&cur_commit_pending_counter_, max_commit_pending_num_);
             } else {
                 cur_commit_pending_counter_.Sub(row_mutation->MutationNum());
+                SignalPendingDrained();
                 row_mutation->SetError(ErrorCode::kBusy, "pending too much mutations, try it later.");
                 ThreadPool::Task task =
                     boost::bind(&TableImpl::BreakRequest, this, row_mutation->GetId());
@@ -566,16 +683,22 @@ void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list
 
         std::string server_addr;
         if (!GetTabletAddrOrScheduleUpdateMeta(row_mutation->RowKey(),
-                                               row_mutation, &server_addr)) {
+                                               row_mutation, &server_addr,
+                                               &route_hint)) {
             continue;
         }
 
-        MuFlushPair& mu_flush_pair = ts_mu_list[server_addr];
-        std::vector<RowMutationImpl*>& ts_row_mutations = mu_flush_pair.mu_list;
-        ts_row_mutations.push_back(row_mutation);
+        // consecutive mutations usually hit the same tablet, so reuse
+        // the last group instead of hashing again; MuFlushPair
+        // references stay valid across inserts (node-based buckets)
+        if (last_pair == NULL || server_addr != last_addr) {
+            last_pair = &ts_mu_list[server_addr];
+            last_addr.swap(server_addr);
+        }
+        last_pair->mu_list.push_back(row_mutation);
 
         if (!row_mutation->IsAsync()) {
-            mu_flush_pair.flush = true;
+            last_pair->flush = true;
         }
     }
 
@@ -593,9 +716,7 @@ void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list
 
     // 等待同步操作返回或超时
     for (uint32_t i = 0; i < sync_mu_list.size(); i++) {
-        while (cur_commit_pending_counter_.Get() > max_commit_pending_num_) {
-            usleep(100000);
-        }
+        WaitPendingDrained(&cur_commit_pending_counter_, max_commit_pending_num_);
 
         RowMutationImpl* row_mutation = (RowMutationImpl*)sync_mu_list[i];
         row_mutation->Wait();
@@ -603,41 +724,89 @@ void TableImpl::DistributeMutations(const std::vector<RowMutationImpl*>& mu_list
 }
 
 void TableImpl::DistributeMutationsById(std::vector<int64_t>* mu_id_list) {
-    std::vector<RowMutationImpl*> mu_list;
-    for (uint32_t i = 0; i < mu_id_list->size(); ++i) {
-        int64_t mu_id = (*mu_id_list)[i];
-        SdkTask* task = task_pool_.GetTask(mu_id);
+    // 重试路径单遍完成: 取task和按TS分组并在一个循环里,
+    // 不再先物化中间mu_list再让DistributeMutations重扫一遍
+    typedef boost::unordered_map<std::string, MuFlushPair> TsMuMap;
+    TsMuMap ts_mu_list;
+
+    std::vector<SdkTask*> tasks;
+    task_pool_.GetTasks(*mu_id_list, &tasks);
+
+    int64_t mutate_cnt = 0;
+    std::string last_addr;
+    MuFlushPair* last_pair = NULL;
+    TabletRouteHint route_hint;
+    for (uint32_t i = 0; i < tasks.size(); ++i) {
+        SdkTask* task = tasks[i];
         if (task == NULL) {
-            VLOG(10) << "mutation " << mu_id << " timeout when retry mutate";;
+            VLOG(10) << "mutation " << (*mu_id_list)[i] << " timeout when retry mutate";;
             continue;
         }
         CHECK_EQ(task->Type(), SdkTask::MUTATION);
         RowMutationImpl* row_mutation = (RowMutationImpl*)task;
-        mu_list.push_back(row_mutation);
+        ++mutate_cnt;
+
+        std::string server_addr;
+        if (!GetTabletAddrOrScheduleUpdateMeta(row_mutation->RowKey(),
+                                               row_mutation, &server_addr,
+                                               &route_hint)) {
+            continue;
+        }
+        if (last_pair == NULL || server_addr != last_addr) {
+            last_pair = &ts_mu_list[server_addr];
+            last_addr.swap(server_addr);
+        }
+        last_pair->mu_list.push_back(row_mutation);
+        if (!row_mutation->IsAsync()) {
+            last_pair->flush = true;
+        }
+    }
+    if (mutate_cnt > 0) {
+        perf_counter_.mutate_cnt.Add(mutate_cnt);
+    }
+
+    TsMuMap::iterator it = ts_mu_list.begin();
+    for (; it != ts_mu_list.end(); ++it) {
+        MuFlushPair& mu_flush_pair = it->second;
+        PackMutations(it->first, mu_flush_pair.mu_list, mu_flush_pair.flush);
     }
-    DistributeMutations(mu_list, false);
     delete mu_id_list;
 }
 
+TableImpl::BatchShard* TableImpl::GetBatchShard(BatchShard* shards,
+                                                const std::string& server_addr) {
+    uint32_t hash = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < server_addr.size(); ++i) {
+        hash = (hash ^ (unsigned char)server_addr[i]) * 16777619u;
+    }
+    return &shards[hash & (kBatchShardNum - 1)];
+}
+
 void TableImpl::PackMutations(const std::string& server_addr,
                               std::vector<RowMutationImpl*>& mu_list,
                               bool flush) {
-    MutexLock lock(&mutation_batch_mutex_);
+    // 锁内只做收集: 到达提交条件的batch先摘进ready_batches,
+    // 出锁后统一提交, 不在持锁期间做序列化/发rpc等慢操作
+    std::vector<std::vector<int64_t>*> ready_batches;
+    BatchShard* shard = GetBatchShard(mutation_batch_shards_, server_addr);
+    const BatchKey batch_key(server_addr, 0);
+    shard->mutex.Lock();
     TaskBatch* mutation_batch = NULL;
     for (size_t i = 0; i < mu_list.size(); ++i) {
         // find existing batch or create a new batch
         if (mutation_batch == NULL) {
-            std::map<std::string, TaskBatch>::iterator it = mutation_batch_map_.find(server_addr);
-            if (it != mutation_batch_map_.end()) {
+            std::map<BatchKey, TaskBatch>::iterator it = shard->batch_map.find(batch_key);
+            if (it != shard->batch_map.end()) {
                 mutation_batch = &it->second;
             } else {
-                mutation_batch = &mutation_batch_map_[server_addr];
-                mutation_batch->sequence_num = mutation_batch_seq_++;
+                mutation_batch = &shard->batch_map[batch_key];
+                mutation_batch->sequence_num = shard->next_sequence_num++;
                 mutation_batch->row_id_list = new std::vector<int64_t>;
-                ThreadPool::Task task = boost::bind(&TableImpl::MutationBatchTimeout, this,
-                                                    server_addr, mutation_batch->sequence_num);
-                int64_t timer_id = thread_pool_->DelayTask(write_commit_timeout_, task);
-                mutation_batch->timer_id = timer_id;
+                mutation_batch->row_id_list->reserve(commit_size_);
+                // the flush timer is armed lazily after the loop; a
+                // batch committed within this call never touches the
+                // thread-pool timer wheel at all
+                mutation_batch->timer_id = 0;
                 mutation_batch->byte_size = 0;
             }
         }
@@ -653,33 +822,67 @@ void TableImpl::PackMutations(const std::string& server_addr,
         // for the *LAST* batch, commit it if:
         // 2) any mutation is sync (flush == true)
         // 3) batch_row_num >= min_batch_row_num
-        if (mutation_batch->byte_size >= kMaxRpcSize ||
+        bool commit_now = mutation_batch->byte_size >= kMaxRpcSize ||
             (i == mu_list.size() - 1 &&
-             (flush || mutation_batch->row_id_list->size() >= commit_size_))) {
+             (flush || mutation_batch->row_id_list->size() >= commit_size_));
+        // size-triggered commits wait while the per-server rpc window
+        // is full; the batch keeps absorbing rows and goes out with a
+        // later flush, its delay timer, or the rpc-completion drain
+        if (commit_now && !flush && max_inflight_batch_rpc_ > 0) {
+            std::map<std::string, uint32_t>::iterator inflight_it =
+                shard->inflight_map.find(server_addr);
+            if (inflight_it != shard->inflight_map.end() &&
+                inflight_it->second >= (uint32_t)max_inflight_batch_rpc_) {
+                commit_now = false;
+            }
+        }
+        if (commit_now) {
             std::vector<int64_t>* mu_id_list = mutation_batch->row_id_list;
             uint64_t timer_id = mutation_batch->timer_id;
-            const bool non_block_cancel = true;
-            bool is_running = false;
-            if (!thread_pool_->CancelTask(timer_id, non_block_cancel, &is_running)) {
-                CHECK(is_running); // this delay task must be waiting for mutation_batch_mutex_
+            if (timer_id != 0) {
+                const bool non_block_cancel = true;
+                bool is_running = false;
+                if (!thread_pool_->CancelTask(timer_id, non_block_cancel, &is_running)) {
+                    CHECK(is_running); // this delay task must be waiting for the shard mutex
+                }
+            }
+            if (max_inflight_batch_rpc_ > 0) {
+                ++shard->inflight_map[server_addr];
             }
-            mutation_batch_map_.erase(server_addr);
-            mutation_batch_mutex_.Unlock();
-            CommitMutationsById(server_addr, *mu_id_list);
-            delete mu_id_list;
+            shard->batch_map.erase(batch_key);
+            ready_batches.push_back(mu_id_list);
             mutation_batch = NULL;
-            mutation_batch_mutex_.Lock();
         }
     }
+
+    // a partial batch stayed installed: arm its flush timer now. the
+    // unarmed state is never visible outside this call, because the
+    // batch is only left in the map while the shard mutex is held
+    if (mutation_batch != NULL && mutation_batch->timer_id == 0) {
+        // 地址串放进shared_ptr, bind/function的层层拷贝只复制指针
+        boost::shared_ptr<std::string> addr(new std::string(server_addr));
+        ThreadPool::Task task = boost::bind(&TableImpl::MutationBatchTimeout, this,
+                                            addr, mutation_batch->sequence_num);
+        mutation_batch->timer_id = thread_pool_->DelayTask(write_commit_timeout_, task);
+    }
+    shard->mutex.Unlock();
+
+    for (size_t i = 0; i < ready_batches.size(); ++i) {
+        CommitMutationsById(server_addr, *ready_batches[i]);
+        delete ready_batches[i];
+    }
 }
 
-void TableImpl::MutationBatchTimeout(std::string server_addr, uint64_t batch_seq) {
+void TableImpl::MutationBatchTimeout(boost::shared_ptr<std::string> addr,
+                                     uint64_t batch_seq) {
+    const std::string& server_addr = *addr;
     std::vector<int64_t>* mu_id_list = NULL;
     {
-        MutexLock lock(&mutation_batch_mutex_);
-        std::map<std::string, TaskBatch>::iterator it =
-            mutation_batch_map_.find(server_addr);
-        if (it == mutation_batch_map_.end()) {
+        BatchShard* shard = GetBatchShard(mutation_batch_shards_, server_addr);
+        MutexLock lock(&shard->mutex);
+        std::map<BatchKey, TaskBatch>::iterator it =
+            shard->batch_map.find(BatchKey(server_addr, 0));
+        if (it == shard->batch_map.end()) {
             return;
         }
         TaskBatch* mutation_batch = &it->second;
@@ -687,7 +890,10 @@ void TableImpl::MutationBatchTimeout(std::string server_addr, uint64_t batch_seq
             return;
         }
         mu_id_list = mutation_batch->row_id_list;
-        mutation_batch_map_.erase(it);
+        if (max_inflight_batch_rpc_ > 0) {
+            ++shard->inflight_map[server_addr];
+        }
+        shard->batch_map.erase(it);
     }
     CommitMutationsById(server_addr, *mu_id_list);
     delete mu_id_list;
@@ -696,11 +902,13 @@ void TableImpl::MutationBatchTimeout(std::string server_addr, uint64_t batch_seq
 void TableImpl::CommitMutationsById(const std::string& server_addr,
                                     std::vector<int64_t>& mu_id_list) {
     std::vector<RowMutationImpl*> mu_list;
-    for (size_t i = 0; i < mu_id_list.size(); i++) {
-        int64_t mu_id = mu_id_list[i];
-        SdkTask* task = task_pool_.GetTask(mu_id);
+    mu_list.reserve(mu_id_list.size());
+    std::vector<SdkTask*> tasks;
+    task_pool_.GetTasks(mu_id_list, &tasks);
+    for (size_t i = 0; i < tasks.size(); i++) {
+        SdkTask* task = tasks[i];
         if (task == NULL) {
-            VLOG(10) << "mutation " << mu_id << " timeout";
+            VLOG(10) << "mutation " << mu_id_list[i] << " timeout";
             continue;
         }
         CHECK_EQ(task->Type(), SdkTask::MUTATION);
@@ -711,7 +919,7 @@ void TableImpl::CommitMutationsById(const std::string& server_addr,
 
 void TableImpl::CommitMutations(const std::string& server_addr,
                                 std::vector<RowMutationImpl*>& mu_list) {
-    tabletnode::TabletNodeClient tabletnode_client_async(server_addr);
+    tabletnode::TabletNodeClient* tabletnode_client_async = GetTabletNodeClient(server_addr);
     WriteTabletRequest* request = new WriteTabletRequest;
     WriteTabletResponse* response = new WriteTabletResponse;
     request->set_sequence_id(last_sequence_id_++);
@@ -719,11 +927,18 @@ void TableImpl::CommitMutations(const std::string& server_addr,
     request->set_is_sync(FLAGS_tera_sdk_write_sync);
 
     std::vector<int64_t>* mu_id_list = new std::vector<int64_t>;
+    mu_id_list->reserve(mu_list.size());
+    // grow the repeated fields' slot arrays once up front; protobuf
+    // here predates arenas, so per-message allocation stays, but the
+    // pointer-array doubling does not
+    request->mutable_row_list()->Reserve(mu_list.size());
     for (uint32_t i = 0; i < mu_list.size(); ++i) {
         RowMutationImpl* row_mutation = mu_list[i];
         RowMutationSequence* mu_seq = request->add_row_list();
         mu_seq->set_row_key(row_mutation->RowKey());
-        for (uint32_t j = 0; j < row_mutation->MutationNum(); j++) {
+        uint32_t mutation_num = row_mutation->MutationNum();
+        mu_seq->mutable_mutation_sequence()->Reserve(mutation_num);
+        for (uint32_t j = 0; j < mutation_num; j++) {
             const RowMutation::Mutation& mu = row_mutation->GetMutation(j);
             tera::Mutation* mutation = mu_seq->add_mutation_sequence();
             SerializeMutation(mu, mutation);
@@ -740,36 +955,29 @@ void TableImpl::CommitMutations(const std::string& server_addr,
     VLOG(20) << "commit " << mu_list.size() << " mutations to " << server_addr;
     request->set_timestamp(common::timer::get_micros());
     Closure<void, WriteTabletRequest*, WriteTabletResponse*, bool, int>* done =
-        NewClosure(this, &TableImpl::MutateCallBack, mu_id_list);
-    tabletnode_client_async.WriteTablet(request, response, done);
+        NewClosure(this, &TableImpl::MutateCallBack, server_addr, mu_id_list);
+    tabletnode_client_async->WriteTablet(request, response, done);
 }
 
-void TableImpl::MutateCallBack(std::vector<int64_t>* mu_id_list,
+void TableImpl::MutateCallBack(std::string server_addr,
+                               std::vector<int64_t>* mu_id_list,
                                WriteTabletRequest* request,
                                WriteTabletResponse* response,
                                bool failed, int error_code) {
     perf_counter_.rpc_w.Add(common::timer::get_micros() - request->timestamp());
     perf_counter_.rpc_w_cnt.Inc();
     if (failed) {
-        if (error_code == sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE) {
-            response->set_status(kServerError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL) {
-            response->set_status(kClientError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS) {
-            response->set_status(kConnectError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT) {
-            response->set_status(kRPCTimeout);
-        } else {
-            response->set_status(kRPCError);
-        }
+        response->set_status(TranslateRpcError(error_code));
     }
 
-    std::map<uint32_t, std::vector<int64_t>* > retry_times_list;
+    // 重试次数有界且很小, 按次数直接索引的平坦数组代替std::map,
+    // 省掉每档红黑树节点分配; 超界次数并入最后一档, 退避本就按它封顶
+    std::vector<std::vector<int64_t>*> retry_buckets(retry_backoff_ms_.size());
     std::vector<RowMutationImpl*> not_in_range_list;
+    // 循环内先累加到栈上, 出循环一次性写计数器,
+    // 把每行一次的原子读改写合并成每次回调一次
+    int64_t ok_cnt = 0, fail_cnt = 0, range_cnt = 0;
+    int64_t cb_cnt = 0, cb_time_total = 0;
     for (uint32_t i = 0; i < mu_id_list->size(); ++i) {
         const std::string& row = request->row_list(i).row_key();
         int64_t mu_id = (*mu_id_list)[i];
@@ -779,7 +987,7 @@ void TableImpl::MutateCallBack(std::vector<int64_t>* mu_id_list,
         }
 
         if (err == kTabletNodeOk || err == kTxnFail) {
-            perf_counter_.mutate_ok_cnt.Inc();
+            ++ok_cnt;
             SdkTask* task = task_pool_.PopTask(mu_id);
             if (task == NULL) {
                 VLOG(10) << "mutation " << mu_id << " finish but timeout: " << DebugString(row);
@@ -796,13 +1004,14 @@ void TableImpl::MutateCallBack(std::vector<int64_t>* mu_id_list,
 
             // only for flow control
             cur_commit_pending_counter_.Sub(row_mutation->MutationNum());
+            SignalPendingDrained();
             int64_t perf_time = common::timer::get_micros();
             row_mutation->RunCallback();
-            perf_counter_.user_callback.Add(common::timer::get_micros() - perf_time);
-            perf_counter_.user_callback_cnt.Inc();
+            cb_time_total += common::timer::get_micros() - perf_time;
+            ++cb_cnt;
             continue;
         }
-        perf_counter_.mutate_fail_cnt.Inc();
+        ++fail_cnt;
 
         VLOG(10) << "fail to mutate table: " << name_
             << " row: " << DebugString(row)
@@ -818,42 +1027,96 @@ void TableImpl::MutateCallBack(std::vector<int64_t>* mu_id_list,
         row_mutation->SetInternalError(err);
 
         if (err == kKeyNotInRange) {
-            perf_counter_.mutate_range_cnt.Inc();
+            ++range_cnt;
             row_mutation->IncRetryTimes();
             not_in_range_list.push_back(row_mutation);
         } else {
             row_mutation->IncRetryTimes();
-            std::vector<int64_t>* retry_mu_id_list = NULL;
-            std::map<uint32_t, std::vector<int64_t>* >::iterator it =
-                retry_times_list.find(row_mutation->RetryTimes());
-            if (it != retry_times_list.end()) {
-                retry_mu_id_list = it->second;
-            } else {
-                retry_mu_id_list = new std::vector<int64_t>;
-                retry_times_list[row_mutation->RetryTimes()] = retry_mu_id_list;
+            uint32_t bucket = row_mutation->RetryTimes();
+            if (bucket >= retry_buckets.size()) {
+                bucket = retry_buckets.size() - 1;
             }
-            retry_mu_id_list->push_back(mu_id);
+            if (retry_buckets[bucket] == NULL) {
+                retry_buckets[bucket] = new std::vector<int64_t>;
+            }
+            retry_buckets[bucket]->push_back(mu_id);
             row_mutation->DecRef();
         }
     }
 
+    if (ok_cnt > 0) perf_counter_.mutate_ok_cnt.Add(ok_cnt);
+    if (fail_cnt > 0) perf_counter_.mutate_fail_cnt.Add(fail_cnt);
+    if (range_cnt > 0) perf_counter_.mutate_range_cnt.Add(range_cnt);
+    if (cb_cnt > 0) {
+        perf_counter_.user_callback.Add(cb_time_total);
+        perf_counter_.user_callback_cnt.Add(cb_cnt);
+    }
+
     if (not_in_range_list.size() > 0) {
         DistributeMutations(not_in_range_list, false);
     }
-    std::map<uint32_t, std::vector<int64_t>* >::iterator it;
-    for (it = retry_times_list.begin(); it != retry_times_list.end(); ++it) {
-        int64_t retry_interval =
-            static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal, it->first) * 1000);
+    for (uint32_t level = 0; level < retry_buckets.size(); ++level) {
+        if (retry_buckets[level] == NULL) {
+            continue;
+        }
         ThreadPool::Task retry_task =
-            boost::bind(&TableImpl::DistributeMutationsById, this, it->second);
-        thread_pool_->DelayTask(retry_interval, retry_task);
+            boost::bind(&TableImpl::DistributeMutationsById, this, retry_buckets[level]);
+        thread_pool_->DelayTask(RetryBackoffMs(level), retry_task);
     }
 
+    OnMutationBatchRpcFinished(server_addr);
+
     delete request;
     delete response;
     delete mu_id_list;
 }
 
+void TableImpl::OnMutationBatchRpcFinished(const std::string& server_addr) {
+    if (max_inflight_batch_rpc_ <= 0) {
+        return;
+    }
+    BatchShard* shard = GetBatchShard(mutation_batch_shards_, server_addr);
+    std::vector<int64_t>* mu_id_list = NULL;
+    {
+        MutexLock lock(&shard->mutex);
+        std::map<std::string, uint32_t>::iterator inflight_it =
+            shard->inflight_map.find(server_addr);
+        uint32_t inflight_num = 0;
+        if (inflight_it != shard->inflight_map.end()) {
+            inflight_num = --inflight_it->second;
+            if (inflight_num == 0) {
+                shard->inflight_map.erase(inflight_it);
+            }
+        }
+        if (inflight_num >= (uint32_t)max_inflight_batch_rpc_) {
+            // window still full, a later completion will drain
+            return;
+        }
+        std::map<BatchKey, TaskBatch>::iterator it =
+            shard->batch_map.find(BatchKey(server_addr, 0));
+        if (it == shard->batch_map.end()) {
+            return;
+        }
+        TaskBatch* mutation_batch = &it->second;
+        if (mutation_batch->byte_size < kMaxRpcSize &&
+            mutation_batch->row_id_list->size() < commit_size_) {
+            // not held back by the window, leave it to its delay timer
+            return;
+        }
+        const bool non_block_cancel = true;
+        bool is_running = false;
+        if (!thread_pool_->CancelTask(mutation_batch->timer_id,
+                                      non_block_cancel, &is_running)) {
+            CHECK(is_running); // this delay task must be waiting for the shard mutex
+        }
+        mu_id_list = mutation_batch->row_id_list;
+        ++shard->inflight_map[server_addr];
+        shard->batch_map.erase(it);
+    }
+    CommitMutationsById(server_addr, *mu_id_list);
+    delete mu_id_list;
+}
+
 void TableImpl::MutationTimeout(SdkTask* task) {
     perf_counter_.mutate_timeout_cnt.Inc();
     CHECK_NOTNULL(task);
@@ -880,6 +1143,7 @@ void TableImpl::MutationTimeout(SdkTask* task) {
     }
     // only for flow control
     cur_commit_pending_counter_.Sub(row_mutation->MutationNum());
+    SignalPendingDrained();
     int64_t perf_time = common::timer::get_micros();
     row_mutation->RunCallback();
     perf_counter_.user_callback.Add(common::timer::get_micros() - perf_time);
@@ -897,7 +1161,9 @@ bool TableImpl::GetDescriptor(TableDescriptor* desc, ErrorCode* err) {
 
 void TableImpl::DistributeReaders(const std::vector<RowReaderImpl*>& row_reader_list,
                                   bool called_by_user) {
-    typedef std::map<std::string, std::vector<RowReaderImpl*> > TsReaderMap;
+    // 和DistributeMutations一样: 只在本次调用内分组, 不需要有序遍历,
+    // 哈希表代替红黑树
+    typedef boost::unordered_map<std::string, std::vector<RowReaderImpl*> > TsReaderMap;
     TsReaderMap ts_reader_list;
 
     int64_t sync_min_timeout = -1;
@@ -915,32 +1181,46 @@ void TableImpl::DistributeReaders(const std::vector<RowReaderImpl*>& row_reader_
                 sync_min_timeout = row_timeout;
             }
         }
-    }
 
-    for (uint32_t i = 0; i < row_reader_list.size(); i++) {
-        perf_counter_.reader_cnt.Inc();
-        RowReaderImpl* row_reader = (RowReaderImpl*)row_reader_list[i];
-        if (called_by_user) {
-            row_reader->SetId(next_task_id_.Inc());
+        // register the whole batch in the task pool with one bulk
+        // insert, taking each pool shard mutex once instead of per row
+        std::vector<SdkTask*> batch_tasks;
+        std::vector<int64_t> batch_timeouts;
+        batch_tasks.reserve(row_reader_list.size());
+        batch_timeouts.reserve(row_reader_list.size());
+        // 一次原子加领出整批id, 每行只做本地加法
+        int64_t base_id = next_task_id_.Add(row_reader_list.size()) - row_reader_list.size();
+        for (uint32_t i = 0; i < row_reader_list.size(); i++) {
+            RowReaderImpl* row_reader = (RowReaderImpl*)row_reader_list[i];
+            row_reader->SetId(base_id + 1 + i);
 
             int64_t row_timeout = sync_min_timeout;
             if (row_reader->IsAsync()) {
                 row_timeout = row_reader->TimeOut() > 0 ? row_reader->TimeOut() : timeout_;
             }
-            SdkTask::TimeoutFunc task = boost::bind(&TableImpl::ReaderTimeout, this, _1);
-            task_pool_.PutTask(row_reader, row_timeout, task);
+            batch_tasks.push_back(row_reader);
+            batch_timeouts.push_back(row_timeout);
         }
+        task_pool_.PutTasks(batch_tasks, batch_timeouts, reader_timeout_func_);
+    }
+
+    // 整批一次累加, 不在循环里逐行做原子加
+    perf_counter_.reader_cnt.Add(row_reader_list.size());
+    TabletRouteHint route_hint;
+    std::string last_addr;
+    std::vector<RowReaderImpl*>* last_readers = NULL;
+    for (uint32_t i = 0; i < row_reader_list.size(); i++) {
+        RowReaderImpl* row_reader = (RowReaderImpl*)row_reader_list[i];
 
         // flow control
         if (called_by_user
             && cur_reader_pending_counter_.Inc() > max_reader_pending_num_
             && row_reader->IsAsync()) {
-            if (FLAGS_tera_sdk_async_blocking_enabled) {
-                while (cur_reader_pending_counter_.Get() > max_reader_pending_num_) {
-                    usleep(100000);
-                }
+            if (async_blocking_enabled_) {
+                WaitPendingDrained(&cur_reader_pending_counter_, max_reader_pending_num_);
             } else {
                 cur_reader_pending_counter_.Dec();
+                SignalPendingDrained();
                 row_reader->SetError(ErrorCode::kBusy, "pending too much readers, try it later.");
                 ThreadPool::Task task =
                     boost::bind(&TableImpl::BreakRequest, this, row_reader->GetId());
@@ -952,12 +1232,17 @@ void TableImpl::DistributeReaders(const std::vector<RowReaderImpl*>& row_reader_
 
         std::string server_addr;
         if (!GetTabletAddrOrScheduleUpdateMeta(row_reader->RowName(), row_reader,
-                                               &server_addr)) {
+                                               &server_addr, &route_hint)) {
             continue;
         }
 
-        std::vector<RowReaderImpl*>& ts_row_readers = ts_reader_list[server_addr];
-        ts_row_readers.push_back(row_reader);
+        // 连续的行通常命中同一tabletnode, 复用上一组, 免去重复哈希;
+        // 哈希桶按节点组织, 插入不会使已有引用失效
+        if (last_readers == NULL || server_addr != last_addr) {
+            last_readers = &ts_reader_list[server_addr];
+            last_addr.swap(server_addr);
+        }
+        last_readers->push_back(row_reader);
     }
 
     TsReaderMap::iterator it = ts_reader_list.begin();
@@ -974,9 +1259,7 @@ void TableImpl::DistributeReaders(const std::vector<RowReaderImpl*>& row_reader_
 
     // 等待同步操作返回或超时
     for (uint32_t i = 0; i < sync_reader_list.size(); i++) {
-        while (cur_reader_pending_counter_.Get() > max_reader_pending_num_) {
-            usleep(100000);
-        }
+        WaitPendingDrained(&cur_reader_pending_counter_, max_reader_pending_num_);
 
         RowReaderImpl* row_reader = (RowReaderImpl*)sync_reader_list[i];
         row_reader->Wait();
@@ -985,51 +1268,83 @@ void TableImpl::DistributeReaders(const std::vector<RowReaderImpl*>& row_reader_
 
 void TableImpl::PackReaders(const std::string& server_addr,
                             std::vector<RowReaderImpl*>& reader_list) {
-    MutexLock lock(&reader_batch_mutex_);
+    // 同PackMutations: 锁内收集, 出锁后提交
+    // 批次按(节点, snapshot)组织, 不同snapshot的读请求不会混进同一个RPC
+    std::vector<std::vector<int64_t>*> ready_batches;
+    std::vector<uint64_t> new_batch_snapshots;
+    BatchShard* shard = GetBatchShard(reader_batch_shards_, server_addr);
+    shard->mutex.Lock();
     TaskBatch* reader_buffer = NULL;
-    std::map<std::string, TaskBatch>::iterator it = reader_batch_map_.find(server_addr);
-    if (it != reader_batch_map_.end()) {
-        reader_buffer = &it->second;
-    } else {
-        reader_buffer = &reader_batch_map_[server_addr];
-        reader_buffer->sequence_num = reader_batch_seq_++;
-        reader_buffer->row_id_list = new std::vector<int64_t>;
-        ThreadPool::Task task = boost::bind(&TableImpl::ReaderBatchTimeout, this,
-                                            server_addr, reader_buffer->sequence_num);
-        uint64_t timer_id = thread_pool_->DelayTask(read_commit_timeout_, task);
-        reader_buffer->timer_id = timer_id;
-    }
-
+    uint64_t last_snapshot = 0;
     for (size_t i = 0; i < reader_list.size(); ++i) {
         RowReaderImpl* reader = reader_list[i];
+        uint64_t snapshot_id = reader->GetSnapshot();
+        if (reader_buffer == NULL || snapshot_id != last_snapshot) {
+            last_snapshot = snapshot_id;
+            const BatchKey batch_key(server_addr, snapshot_id);
+            std::map<BatchKey, TaskBatch>::iterator it = shard->batch_map.find(batch_key);
+            if (it != shard->batch_map.end()) {
+                reader_buffer = &it->second;
+            } else {
+                reader_buffer = &shard->batch_map[batch_key];
+                reader_buffer->sequence_num = shard->next_sequence_num++;
+                reader_buffer->row_id_list = new std::vector<int64_t>;
+                reader_buffer->row_id_list->reserve(commit_size_);
+                // the flush timer is armed lazily below, only if the batch
+                // survives this call
+                reader_buffer->timer_id = 0;
+                new_batch_snapshots.push_back(snapshot_id);
+            }
+        }
         reader_buffer->row_id_list->push_back(reader->GetId());
         reader->DecRef();
+
+        if (reader_buffer->row_id_list->size() >= commit_size_) {
+            uint64_t timer_id = reader_buffer->timer_id;
+            if (timer_id != 0) {
+                const bool non_block_cancel = true;
+                bool is_running = false;
+                if (!thread_pool_->CancelTask(timer_id, non_block_cancel, &is_running)) {
+                    CHECK(is_running); // this delay task must be waiting for the shard mutex
+                }
+            }
+            ready_batches.push_back(reader_buffer->row_id_list);
+            shard->batch_map.erase(BatchKey(server_addr, snapshot_id));
+            reader_buffer = NULL;
+        }
     }
 
-    if (reader_buffer->row_id_list->size() >= commit_size_) {
-        std::vector<int64_t>* reader_id_list = reader_buffer->row_id_list;
-        uint64_t timer_id = reader_buffer->timer_id;
-        const bool non_block_cancel = true;
-        bool is_running = false;
-        if (!thread_pool_->CancelTask(timer_id, non_block_cancel, &is_running)) {
-            CHECK(is_running); // this delay task must be waiting for reader_batch_map_
+    for (size_t i = 0; i < new_batch_snapshots.size(); ++i) {
+        std::map<BatchKey, TaskBatch>::iterator it =
+            shard->batch_map.find(BatchKey(server_addr, new_batch_snapshots[i]));
+        if (it == shard->batch_map.end() || it->second.timer_id != 0) {
+            continue;
         }
-        reader_batch_map_.erase(server_addr);
-        reader_batch_mutex_.Unlock();
-        CommitReadersById(server_addr, *reader_id_list);
-        delete reader_id_list;
-        reader_buffer = NULL;
-        reader_batch_mutex_.Lock();
+        // 同PackMutations: 地址串放进shared_ptr, 闭包只复制指针
+        boost::shared_ptr<std::string> addr(new std::string(server_addr));
+        ThreadPool::Task task = boost::bind(&TableImpl::ReaderBatchTimeout, this,
+                                            addr, new_batch_snapshots[i],
+                                            it->second.sequence_num);
+        it->second.timer_id = thread_pool_->DelayTask(read_commit_timeout_, task);
+    }
+    shard->mutex.Unlock();
+
+    for (size_t i = 0; i < ready_batches.size(); ++i) {
+        CommitReadersById(server_addr, *ready_batches[i]);
+        delete ready_batches[i];
     }
 }
 
-void TableImpl::ReaderBatchTimeout(std::string server_addr, uint64_t batch_seq) {
+void TableImpl::ReaderBatchTimeout(boost::shared_ptr<std::string> addr,
+                                   uint64_t snapshot_id, uint64_t batch_seq) {
+    const std::string& server_addr = *addr;
     std::vector<int64_t>* reader_id_list = NULL;
     {
-        MutexLock lock(&reader_batch_mutex_);
-        std::map<std::string, TaskBatch>::iterator it =
-            reader_batch_map_.find(server_addr);
-        if (it == reader_batch_map_.end()) {
+        BatchShard* shard = GetBatchShard(reader_batch_shards_, server_addr);
+        MutexLock lock(&shard->mutex);
+        std::map<BatchKey, TaskBatch>::iterator it =
+            shard->batch_map.find(BatchKey(server_addr, snapshot_id));
+        if (it == shard->batch_map.end()) {
             return;
         }
         TaskBatch* reader_buffer = &it->second;
@@ -1037,7 +1352,7 @@ void TableImpl::ReaderBatchTimeout(std::string server_addr, uint64_t batch_seq)
             return;
         }
         reader_id_list = reader_buffer->row_id_list;
-        reader_batch_map_.erase(it);
+        shard->batch_map.erase(it);
     }
     CommitReadersById(server_addr, *reader_id_list);
     delete reader_id_list;
@@ -1046,11 +1361,13 @@ void TableImpl::ReaderBatchTimeout(std::string server_addr, uint64_t batch_seq)
 void TableImpl::CommitReadersById(const std::string server_addr,
                                   std::vector<int64_t>& reader_id_list) {
     std::vector<RowReaderImpl*> reader_list;
-    for (size_t i = 0; i < reader_id_list.size(); ++i) {
-        int64_t reader_id = reader_id_list[i];
-        SdkTask* task = task_pool_.GetTask(reader_id);
+    reader_list.reserve(reader_id_list.size());
+    std::vector<SdkTask*> tasks;
+    task_pool_.GetTasks(reader_id_list, &tasks);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        SdkTask* task = tasks[i];
         if (task == NULL) {
-            VLOG(10) << "reader " << reader_id << " timeout when commit read";;
+            VLOG(10) << "reader " << reader_id_list[i] << " timeout when commit read";;
             continue;
         }
         CHECK_EQ(task->Type(), SdkTask::READ);
@@ -1063,16 +1380,22 @@ void TableImpl::CommitReadersById(const std::string server_addr,
 void TableImpl::CommitReaders(const std::string server_addr,
                               std::vector<RowReaderImpl*>& reader_list) {
     std::vector<int64_t>* reader_id_list = new std::vector<int64_t>;
-    tabletnode::TabletNodeClient tabletnode_client_async(server_addr);
+    reader_id_list->reserve(reader_list.size());
+    tabletnode::TabletNodeClient* tabletnode_client_async = GetTabletNodeClient(server_addr);
     ReadTabletRequest* request = new ReadTabletRequest;
     ReadTabletResponse* response = new ReadTabletResponse;
     request->set_sequence_id(last_sequence_id_++);
     request->set_tablet_name(name_);
     request->set_client_timeout_ms(pending_timeout_ms_);
+    request->mutable_row_info_list()->Reserve(reader_list.size());
+    // snapshot_id是request级字段, 只写一次;
+    // 批次按(节点, snapshot)组织, 同一批内所有reader的snapshot一致
+    if (!reader_list.empty()) {
+        request->set_snapshot_id(reader_list[0]->GetSnapshot());
+    }
     for (uint32_t i = 0; i < reader_list.size(); ++i) {
         RowReaderImpl* row_reader = reader_list[i];
         RowReaderInfo* row_reader_info = request->add_row_info_list();
-        request->set_snapshot_id(row_reader->GetSnapshot());
         row_reader->ToProtoBuf(row_reader_info);
         // row_reader_info->CopyFrom(row_reader->GetRowReaderInfo());
         reader_id_list->push_back(row_reader->GetId());
@@ -1082,7 +1405,7 @@ void TableImpl::CommitReaders(const std::string server_addr,
     request->set_timestamp(common::timer::get_micros());
     Closure<void, ReadTabletRequest*, ReadTabletResponse*, bool, int>* done =
         NewClosure(this, &TableImpl::ReaderCallBack, reader_id_list);
-    tabletnode_client_async.ReadTablet(request, response, done);
+    tabletnode_client_async->ReadTablet(request, response, done);
 }
 
 void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
@@ -1092,25 +1415,35 @@ void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
     perf_counter_.rpc_r.Add(common::timer::get_micros() - request->timestamp());
     perf_counter_.rpc_r_cnt.Inc();
     if (failed) {
-        if (error_code == sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE) {
-            response->set_status(kServerError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL) {
-            response->set_status(kClientError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS) {
-            response->set_status(kConnectError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT) {
-            response->set_status(kRPCTimeout);
-        } else {
-            response->set_status(kRPCError);
+        response->set_status(TranslateRpcError(error_code));
+    }
+
+    // 稳态下绝大多数响应整批成功, 先线性扫一遍行状态;
+    // 全部kTabletNodeOk则走快速路径, 省去逐行的三路错误分支
+    if (response->status() == kTabletNodeOk &&
+        (uint32_t)response->detail().status_size() == reader_id_list->size()) {
+        bool all_ok = true;
+        for (uint32_t i = 0; i < reader_id_list->size(); ++i) {
+            if (response->detail().status(i) != kTabletNodeOk) {
+                all_ok = false;
+                break;
+            }
+        }
+        if (all_ok) {
+            ReaderCallBackFastPath(reader_id_list, response);
+            delete request;
+            delete response;
+            delete reader_id_list;
+            return;
         }
     }
 
-    std::map<uint32_t, std::vector<int64_t>* > retry_times_list;
+    // 同MutateCallBack: 按重试次数索引的平坦数组代替std::map
+    std::vector<std::vector<int64_t>*> retry_buckets(retry_backoff_ms_.size());
     std::vector<RowReaderImpl*> not_in_range_list;
+    // 同MutateCallBack: 栈上累加, 出循环一次写计数器
+    int64_t ok_cnt = 0, fail_cnt = 0, range_cnt = 0;
+    int64_t cb_cnt = 0, cb_time_total = 0;
     uint32_t row_result_index = 0;
     for (uint32_t i = 0; i < reader_id_list->size(); ++i) {
         int64_t reader_id = (*reader_id_list)[i];
@@ -1120,7 +1453,7 @@ void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
             err = response->detail().status(i);
         }
         if (err == kTabletNodeOk || err == kKeyNotExist || err == kSnapshotNotExist) {
-            perf_counter_.reader_ok_cnt.Inc();
+            ++ok_cnt;
             SdkTask* task = task_pool_.PopTask(reader_id);
             if (task == NULL) {
                 VLOG(10) << "reader " << reader_id << " success but timeout";
@@ -1144,13 +1477,14 @@ void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
             }
             int64_t perf_time = common::timer::get_micros();
             row_reader->RunCallback();
-            perf_counter_.user_callback.Add(common::timer::get_micros() - perf_time);
-            perf_counter_.user_callback_cnt.Inc();
+            cb_time_total += common::timer::get_micros() - perf_time;
+            ++cb_cnt;
             // only for flow control
             cur_reader_pending_counter_.Dec();
+            SignalPendingDrained();
             continue;
         }
-        perf_counter_.reader_fail_cnt.Inc();
+        ++fail_cnt;
 
         VLOG(10) << "fail to read table: " << name_
             << " errcode: " << StatusCodeToString(err);
@@ -1165,35 +1499,41 @@ void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
         row_reader->SetInternalError(err);
 
         if (err == kKeyNotInRange) {
-            perf_counter_.reader_range_cnt.Inc();
+            ++range_cnt;
             row_reader->IncRetryTimes();
             not_in_range_list.push_back(row_reader);
         } else {
             row_reader->IncRetryTimes();
-            std::vector<int64_t>* retry_reader_id_list = NULL;
-            std::map<uint32_t, std::vector<int64_t>* >::iterator it =
-                retry_times_list.find(row_reader->RetryTimes());
-            if (it != retry_times_list.end()) {
-                retry_reader_id_list = it->second;
-            } else {
-                retry_reader_id_list = new std::vector<int64_t>;
-                retry_times_list[row_reader->RetryTimes()] = retry_reader_id_list;
+            uint32_t bucket = row_reader->RetryTimes();
+            if (bucket >= retry_buckets.size()) {
+                bucket = retry_buckets.size() - 1;
             }
-            retry_reader_id_list->push_back(row_reader->GetId());
+            if (retry_buckets[bucket] == NULL) {
+                retry_buckets[bucket] = new std::vector<int64_t>;
+            }
+            retry_buckets[bucket]->push_back(row_reader->GetId());
             row_reader->DecRef();
         }
     }
 
+    if (ok_cnt > 0) perf_counter_.reader_ok_cnt.Add(ok_cnt);
+    if (fail_cnt > 0) perf_counter_.reader_fail_cnt.Add(fail_cnt);
+    if (range_cnt > 0) perf_counter_.reader_range_cnt.Add(range_cnt);
+    if (cb_cnt > 0) {
+        perf_counter_.user_callback.Add(cb_time_total);
+        perf_counter_.user_callback_cnt.Add(cb_cnt);
+    }
+
     if (not_in_range_list.size() > 0) {
         DistributeReaders(not_in_range_list, false);
     }
-    std::map<uint32_t, std::vector<int64_t>* >::iterator it;
-    for (it = retry_times_list.begin(); it != retry_times_list.end(); ++it) {
-        int64_t retry_interval =
-            static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal, it->first) * 1000);
+    for (uint32_t level = 0; level < retry_buckets.size(); ++level) {
+        if (retry_buckets[level] == NULL) {
+            continue;
+        }
         ThreadPool::Task retry_task =
-            boost::bind(&TableImpl::DistributeReadersById, this, it->second);
-        thread_pool_->DelayTask(retry_interval, retry_task);
+            boost::bind(&TableImpl::DistributeReadersById, this, retry_buckets[level]);
+        thread_pool_->DelayTask(RetryBackoffMs(level), retry_task);
     }
 
     delete request;
@@ -1201,19 +1541,81 @@ void TableImpl::ReaderCallBack(std::vector<int64_t>* reader_id_list,
     delete reader_id_list;
 }
 
-void TableImpl::DistributeReadersById(std::vector<int64_t>* reader_id_list) {
-    std::vector<RowReaderImpl*> reader_list;
-    for (size_t i = 0; i < reader_id_list->size(); ++i) {
+void TableImpl::ReaderCallBackFastPath(std::vector<int64_t>* reader_id_list,
+                                       ReadTabletResponse* response) {
+    // 全部行成功, row_result与reader按下标一一对应
+    int64_t cb_cnt = 0, cb_time_total = 0;
+    for (uint32_t i = 0; i < reader_id_list->size(); ++i) {
         int64_t reader_id = (*reader_id_list)[i];
-        SdkTask* task = task_pool_.GetTask(reader_id);
+        SdkTask* task = task_pool_.PopTask(reader_id);
+        if (task == NULL) {
+            // result is timeout, discard it
+            VLOG(10) << "reader " << reader_id << " success but timeout";
+            continue;
+        }
+        CHECK_EQ(task->Type(), SdkTask::READ);
+        CHECK_EQ(task->GetRef(), 1);
+
+        RowReaderImpl* row_reader = (RowReaderImpl*)task;
+        row_reader->SetResult(response->detail().row_result(i));
+        row_reader->SetError(ErrorCode::kOK);
+        int64_t perf_time = common::timer::get_micros();
+        row_reader->RunCallback();
+        cb_time_total += common::timer::get_micros() - perf_time;
+        ++cb_cnt;
+        // only for flow control
+        cur_reader_pending_counter_.Dec();
+        SignalPendingDrained();
+    }
+
+    perf_counter_.reader_ok_cnt.Add(reader_id_list->size());
+    if (cb_cnt > 0) {
+        perf_counter_.user_callback.Add(cb_time_total);
+        perf_counter_.user_callback_cnt.Add(cb_cnt);
+    }
+}
+
+void TableImpl::DistributeReadersById(std::vector<int64_t>* reader_id_list) {
+    // 同DistributeMutationsById: 重试路径单遍取task并分组
+    typedef boost::unordered_map<std::string, std::vector<RowReaderImpl*> > TsReaderMap;
+    TsReaderMap ts_reader_list;
+
+    std::vector<SdkTask*> tasks;
+    task_pool_.GetTasks(*reader_id_list, &tasks);
+
+    int64_t reader_cnt = 0;
+    std::string last_addr;
+    std::vector<RowReaderImpl*>* last_readers = NULL;
+    TabletRouteHint route_hint;
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        SdkTask* task = tasks[i];
         if (task == NULL) {
-            VLOG(10) << "reader " << reader_id << " timeout when retry read";
+            VLOG(10) << "reader " << (*reader_id_list)[i] << " timeout when retry read";
             continue;
         }
         CHECK_EQ(task->Type(), SdkTask::READ);
-        reader_list.push_back((RowReaderImpl*)task);
+        RowReaderImpl* row_reader = (RowReaderImpl*)task;
+        ++reader_cnt;
+
+        std::string server_addr;
+        if (!GetTabletAddrOrScheduleUpdateMeta(row_reader->RowName(), row_reader,
+                                               &server_addr, &route_hint)) {
+            continue;
+        }
+        if (last_readers == NULL || server_addr != last_addr) {
+            last_readers = &ts_reader_list[server_addr];
+            last_addr.swap(server_addr);
+        }
+        last_readers->push_back(row_reader);
+    }
+    if (reader_cnt > 0) {
+        perf_counter_.reader_cnt.Add(reader_cnt);
+    }
+
+    TsReaderMap::iterator it = ts_reader_list.begin();
+    for (; it != ts_reader_list.end(); ++it) {
+        PackReaders(it->first, it->second);
     }
-    DistributeReaders(reader_list, false);
     delete reader_id_list;
 }
 
@@ -1247,10 +1649,11 @@ void TableImpl::ReaderTimeout(SdkTask* task) {
     perf_counter_.user_callback_cnt.Inc();
     // only for flow control
     cur_reader_pending_counter_.Dec();
+    SignalPendingDrained();
 }
 
 bool TableImpl::GetTabletMetaForKey(const std::string& key, TabletMeta* meta) {
-    MutexLock lock(&meta_mutex_);
+    ReaderMutexLock lock(&meta_mutex_);
     TabletMetaNode* node = GetTabletMetaNodeForKey(key);
     if (node == NULL) {
         VLOG(10) << "no meta for key: " << key;
@@ -1271,15 +1674,53 @@ void TableImpl::BreakScan(ScanTask* scan_task) {
 
 bool TableImpl::GetTabletAddrOrScheduleUpdateMeta(const std::string& row,
                                                   SdkTask* task,
-                                                  std::string* server_addr) {
+                                                  std::string* server_addr,
+                                                  TabletRouteHint* hint) {
     CHECK_NOTNULL(task);
-    MutexLock lock(&meta_mutex_);
+    // 上一行命中的tablet仍覆盖本行且本行不带重路由错误时, 直接复用路由,
+    // 不必加meta_mutex_查表; 带kKeyNotInRange/kConnectError的重试任务
+    // 必须走慢路径触发meta更新
+    if (hint != NULL && hint->valid
+        && task->GetInternalError() != kKeyNotInRange
+        && task->GetInternalError() != kConnectError
+        && row >= hint->start_key
+        && (hint->end_key.empty() || row < hint->end_key)) {
+        task->SetMetaTimeStamp(hint->update_time);
+        *server_addr = hint->server_addr;
+        return true;
+    }
+    // 走慢路径就先作废缓存, 查表成功后再重新填充
+    if (hint != NULL) {
+        hint->valid = false;
+    }
+    // 先持读锁探测: 命中NORMAL节点且无需触发meta更新时, 各分发线程
+    // 可以并行查路由; 查不到或需要改表(挂pending/标记更新)再拿写锁重查
+    bool force_update = (task->GetInternalError() == kKeyNotInRange ||
+                         task->GetInternalError() == kConnectError);
+    {
+        ReaderMutexLock rlock(&meta_mutex_);
+        TabletMetaNode* node = GetTabletMetaNodeForKey(row);
+        if (node != NULL && node->status == NORMAL
+            && !(force_update && task->GetMetaTimeStamp() >= node->update_time)) {
+            task->SetMetaTimeStamp(node->update_time);
+            *server_addr = node->meta.server_addr();
+            if (hint != NULL) {
+                hint->start_key = node->meta.key_range().key_start();
+                hint->end_key = node->meta.key_range().key_end();
+                hint->server_addr = *server_addr;
+                hint->update_time = node->update_time;
+                hint->valid = true;
+            }
+            return true;
+        }
+    }
+    WriterMutexLock lock(&meta_mutex_);
     TabletMetaNode* node = GetTabletMetaNodeForKey(row);
     if (node == NULL) {
         VLOG(10) << "no meta for key: " << row;
         pending_task_id_list_[row].push_back(task->GetId());
         task->DecRef();
-        TabletMetaNode& new_node = tablet_meta_list_[row];
+        TabletMetaNode& new_node = *GetOrInsertTabletMetaNode(row);
         new_node.meta.mutable_key_range()->set_key_start(row);
         new_node.meta.mutable_key_range()->set_key_end(row + '\0');
         new_node.status = WAIT_UPDATE;
@@ -1316,35 +1757,62 @@ bool TableImpl::GetTabletAddrOrScheduleUpdateMeta(const std::string& row,
     CHECK_EQ(node->status, NORMAL);
     task->SetMetaTimeStamp(node->update_time);
     *server_addr = node->meta.server_addr();
+    if (hint != NULL) {
+        hint->start_key = node->meta.key_range().key_start();
+        hint->end_key = node->meta.key_range().key_end();
+        hint->server_addr = *server_addr;
+        hint->update_time = node->update_time;
+        hint->valid = true;
+    }
     return true;
 }
 
 TableImpl::TabletMetaNode* TableImpl::GetTabletMetaNodeForKey(const std::string& key) {
-    meta_mutex_.AssertHeld();
+    // 调用者须持meta_mutex_(读锁或写锁均可)
     if (tablet_meta_list_.size() == 0) {
         VLOG(10) << "the meta list is empty";
         return NULL;
     }
-    std::map<std::string, TabletMetaNode>::iterator it =
-        tablet_meta_list_.upper_bound(key);
-    if (it == tablet_meta_list_.begin()) {
+    // 找最后一个start_key <= key的节点
+    size_t idx = std::upper_bound(tablet_meta_list_.begin(), tablet_meta_list_.end(),
+                                  key, TabletMetaNodeKeyLess())
+        - tablet_meta_list_.begin();
+    if (idx == 0) {
         return NULL;
-    } else {
-        --it;
     }
-    const std::string& end_key = it->second.meta.key_range().key_end();
+    --idx;
+    TabletMetaNode* node = &tablet_meta_list_[idx];
+    const std::string& end_key = node->meta.key_range().key_end();
     if (end_key != "" && end_key <= key) {
         return NULL;
     }
-    return &(it->second);
+    return node;
+}
+
+size_t TableImpl::LowerBoundTabletMeta(const std::string& key) {
+    return std::lower_bound(tablet_meta_list_.begin(), tablet_meta_list_.end(),
+                            key, TabletMetaNodeKeyLess())
+        - tablet_meta_list_.begin();
+}
+
+TableImpl::TabletMetaNode* TableImpl::GetOrInsertTabletMetaNode(
+        const std::string& start_key) {
+    meta_mutex_.AssertHeld();
+    size_t idx = LowerBoundTabletMeta(start_key);
+    if (idx < tablet_meta_list_.size()
+        && tablet_meta_list_[idx].meta.key_range().key_start() == start_key) {
+        return &tablet_meta_list_[idx];
+    }
+    TabletMetaNode node;
+    node.meta.mutable_key_range()->set_key_start(start_key);
+    tablet_meta_list_.insert(tablet_meta_list_.begin() + idx, node);
+    return &tablet_meta_list_[idx];
 }
 
 void TableImpl::DelayUpdateMeta(std::string start_key, std::string end_key) {
-    MutexLock lock(&meta_mutex_);
-    std::map<std::string, TabletMetaNode>::iterator it =
-            tablet_meta_list_.lower_bound(start_key);
-    for (; it != tablet_meta_list_.end(); ++it) {
-        TabletMetaNode& node = it->second;
+    WriterMutexLock lock(&meta_mutex_);
+    for (size_t i = LowerBoundTabletMeta(start_key); i < tablet_meta_list_.size(); ++i) {
+        TabletMetaNode& node = tablet_meta_list_[i];
         if (node.meta.key_range().key_end() > end_key) {
             break;
         }
@@ -1358,16 +1826,15 @@ void TableImpl::DelayUpdateMeta(std::string start_key, std::string end_key) {
 
 void TableImpl::UpdateMetaAsync() {
     meta_mutex_.AssertHeld();
-    if (meta_updating_count_ >= static_cast<uint32_t>(FLAGS_tera_sdk_update_meta_concurrency)) {
+    if (meta_updating_count_.Get() >= FLAGS_tera_sdk_update_meta_concurrency) {
         return;
     }
     bool need_update = false;
     std::string update_start_key;
     std::string update_end_key;
     std::string update_expand_end_key; // update more tablet than need
-    std::map<std::string, TabletMetaNode>::iterator it = tablet_meta_list_.begin();
-    for (; it != tablet_meta_list_.end(); ++it) {
-        TabletMetaNode& node = it->second;
+    for (size_t i = 0; i < tablet_meta_list_.size(); ++i) {
+        TabletMetaNode& node = tablet_meta_list_[i];
         if (node.status != WAIT_UPDATE && need_update) {
             update_expand_end_key = node.meta.key_range().key_start();
             break;
@@ -1389,23 +1856,25 @@ void TableImpl::UpdateMetaAsync() {
     if (!need_update) {
         return;
     }
-    meta_updating_count_++;
+    meta_updating_count_.Inc();
     ScanMetaTableAsync(update_start_key, update_end_key, update_expand_end_key, false);
 }
 
 void TableImpl::ScanMetaTable(const std::string& key_start,
                               const std::string& key_end) {
-    MutexLock lock(&meta_mutex_);
-    meta_updating_count_++;
+    meta_mutex_.Lock();
+    meta_updating_count_.Inc();
     ScanMetaTableAsync(key_start, key_end, key_end, false);
-    while (meta_updating_count_ > 0) {
+    meta_mutex_.Unlock();
+    MutexLock l(&meta_sync_mutex_);
+    while (meta_updating_count_.Get() > 0) {
         meta_cond_.Wait();
     }
 }
 
 void TableImpl::ScanMetaTableAsyncInLock(std::string key_start, std::string key_end,
                                          std::string expand_key_end, bool zk_access) {
-    MutexLock lock(&meta_mutex_);
+    WriterMutexLock lock(&meta_mutex_);
     ScanMetaTableAsync(key_start, key_end, expand_key_end, zk_access);
 }
 
@@ -1430,7 +1899,7 @@ void TableImpl::ScanMetaTableAsync(const std::string& key_start, const std::stri
     }
 
     VLOG(6) << "root: " << meta_addr;
-    tabletnode::TabletNodeClient tabletnode_client_async(meta_addr);
+    tabletnode::TabletNodeClient* tabletnode_client_async = GetTabletNodeClient(meta_addr);
     ScanTabletRequest* request = new ScanTabletRequest;
     ScanTabletResponse* response = new ScanTabletResponse;
     request->set_sequence_id(last_sequence_id_++);
@@ -1443,7 +1912,7 @@ void TableImpl::ScanMetaTableAsync(const std::string& key_start, const std::stri
 
     Closure<void, ScanTabletRequest*, ScanTabletResponse*, bool, int>* done =
         NewClosure(this, &TableImpl::ScanMetaTableCallBack, key_start, key_end, expand_key_end, ::common::timer::get_micros());
-    tabletnode_client_async.ScanTablet(request, response, done);
+    tabletnode_client_async->ScanTablet(request, response, done);
 }
 
 void TableImpl::ScanMetaTableCallBack(std::string key_start,
@@ -1456,21 +1925,7 @@ void TableImpl::ScanMetaTableCallBack(std::string key_start,
     perf_counter_.get_meta.Add(::common::timer::get_micros() - start_time);
     perf_counter_.get_meta_cnt.Inc();
     if (failed) {
-        if (error_code == sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE) {
-            response->set_status(kServerError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL) {
-            response->set_status(kClientError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS) {
-            response->set_status(kConnectError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT) {
-            response->set_status(kRPCTimeout);
-        } else {
-            response->set_status(kRPCError);
-        }
+        response->set_status(TranslateRpcError(error_code));
     }
 
     StatusCode err = response->status();
@@ -1478,7 +1933,7 @@ void TableImpl::ScanMetaTableCallBack(std::string key_start,
         VLOG(10) << "fail to scan meta table [" << request->start()
             << ", " << request->end() << "]: " << StatusCodeToString(err);
         {
-            MutexLock lock(&meta_mutex_);
+            WriterMutexLock lock(&meta_mutex_);
             GiveupUpdateTabletMeta(key_start, key_end);
         }
         ThreadPool::Task retry_task =
@@ -1492,21 +1947,20 @@ void TableImpl::ScanMetaTableCallBack(std::string key_start,
 
     std::string return_start, return_end;
     const RowResult& scan_result = response->results();
+    // 先在锁外把整批KV解析成TabletMeta, 再一次持写锁批量应用;
+    // 原来每条KV拿放一次锁, N条记录就是N次加锁和N次唤醒检查
+    std::vector<TabletMeta> metas(scan_result.key_values_size());
     for (int32_t i = 0; i < scan_result.key_values_size(); i++) {
         const KeyValuePair& kv = scan_result.key_values(i);
-
-        TabletMeta meta;
-        ParseMetaTableKeyValue(kv.key(), kv.value(), &meta);
-
-        if (i == 0) {
-            return_start = meta.key_range().key_start();
-        }
-        if (i == scan_result.key_values_size() - 1) {
-            return_end = meta.key_range().key_end();
+        ParseMetaTableKeyValue(kv.key(), kv.value(), &metas[i]);
+    }
+    if (!metas.empty()) {
+        return_start = metas.front().key_range().key_start();
+        return_end = metas.back().key_range().key_end();
+        WriterMutexLock lock(&meta_mutex_);
+        for (size_t i = 0; i < metas.size(); ++i) {
+            UpdateTabletMetaList(metas[i]);
         }
-
-        MutexLock lock(&meta_mutex_);
-        UpdateTabletMetaList(meta);
     }
     VLOG(10) << "scan meta table [" << request->start()
         << ", " << request->end() << "] success: return "
@@ -1521,15 +1975,19 @@ void TableImpl::ScanMetaTableCallBack(std::string key_start,
         scan_meta_error = true;
     }
 
-    MutexLock lock(&meta_mutex_);
+    WriterMutexLock lock(&meta_mutex_);
     if (scan_meta_error) {
         ScanMetaTableAsync(key_start, key_end, expand_key_end, false);
     } else if (!return_end.empty() && (key_end.empty() || return_end < key_end)) {
         CHECK(!response->complete());
         ScanMetaTableAsync(return_end, key_end, expand_key_end, false);
     } else {
-        meta_updating_count_--;
-        meta_cond_.Signal();
+        meta_updating_count_.Dec();
+        {
+            // Signal仍在锁内发出, 和ScanMetaTable里的检查-等待配对, 防丢唤醒
+            MutexLock l(&meta_sync_mutex_);
+            meta_cond_.Signal();
+        }
         UpdateMetaAsync();
     }
     delete request;
@@ -1538,27 +1996,29 @@ void TableImpl::ScanMetaTableCallBack(std::string key_start,
 
 void TableImpl::GiveupUpdateTabletMeta(const std::string& key_start,
                                        const std::string& key_end) {
-    std::map<std::string, std::list<int64_t> >::iterator ilist =
+    boost::container::flat_map<std::string, std::vector<int64_t> >::iterator ilist =
             pending_task_id_list_.lower_bound(key_start);
     while (ilist != pending_task_id_list_.end()) {
         if (!key_end.empty() && ilist->first >= key_end) {
             break;
         }
-        std::list<int64_t>& task_id_list = ilist->second;
-        for (std::list<int64_t>::iterator itask = task_id_list.begin();
-                itask != task_id_list.end();) {
-            int64_t task_id = *itask;
+        // 双指针原地压缩: 已超时的id丢掉, 存活的留在桶里等下次重试
+        std::vector<int64_t>& task_id_list = ilist->second;
+        size_t keep = 0;
+        for (size_t i = 0; i < task_id_list.size(); ++i) {
+            int64_t task_id = task_id_list[i];
             SdkTask* task = task_pool_.GetTask(task_id);
             if (task == NULL) {
                 VLOG(10) << "task " << task_id << " timeout when update meta fail";
-                itask = task_id_list.erase(itask);
-            } else {
-                task->DecRef();
+                continue;
             }
-            ++itask;
+            task->DecRef();
+            task_id_list[keep++] = task_id;
         }
+        task_id_list.resize(keep);
         if (task_id_list.empty()) {
-            pending_task_id_list_.erase(ilist++);
+            // flat_map的erase使后续迭代器失效, 用返回值续走
+            ilist = pending_task_id_list_.erase(ilist);
         } else {
             ++ilist;
         }
@@ -1567,35 +2027,44 @@ void TableImpl::GiveupUpdateTabletMeta(const std::string& key_start,
 
 void TableImpl::UpdateTabletMetaList(const TabletMeta& new_meta) {
     meta_mutex_.AssertHeld();
-    const std::string& new_start = new_meta.key_range().key_start();
-    const std::string& new_end = new_meta.key_range().key_end();
-    std::map<std::string, TabletMetaNode>::iterator it =
-        tablet_meta_list_.upper_bound(new_start);
-    if (tablet_meta_list_.size() > 0 && it != tablet_meta_list_.begin()) {
-        --it;
-    }
-    while (it != tablet_meta_list_.end()) {
-        TabletMetaNode& old_node = it->second;
-        std::map<std::string, TabletMetaNode>::iterator tmp = it;
-        ++it;
-
-        const std::string& old_start = old_node.meta.key_range().key_start();
-        const std::string& old_end = old_node.meta.key_range().key_end();
+    const KeyRange& new_range = new_meta.key_range();
+    const std::string& new_start = new_range.key_start();
+    const std::string& new_end = new_range.key_end();
+    // 两次二分把重叠区间[first, last)精确圈出来, 区间外的节点一个不碰:
+    // 被覆盖的节点攒成连续一段最后一次erase, 裂出的尾段出循环后再插回,
+    // 遍历期间容器不增删, 引用全程有效
+    size_t first = std::upper_bound(tablet_meta_list_.begin(), tablet_meta_list_.end(),
+                                    new_start, TabletMetaNodeKeyLess())
+        - tablet_meta_list_.begin();
+    if (first > 0) {
+        const std::string& prev_end =
+            tablet_meta_list_[first - 1].meta.key_range().key_end();
+        if (prev_end.empty() || prev_end > new_start) {
+            // 前驱的范围伸进了new, 也要处理
+            --first;
+        }
+    }
+    size_t last = new_end.empty() ? tablet_meta_list_.size()
+                                  : LowerBoundTabletMeta(new_end);
+    bool has_tail = false;
+    TabletMetaNode tail_node; // 裂出或右溢的[new_end, old_end)段
+    size_t erase_first = first;
+    for (size_t idx = first; idx < last; ++idx) {
+        TabletMetaNode& old_node = tablet_meta_list_[idx];
+        // key_range()经由HasBits取子消息指针, 编译器没法跨set_key_*做CSE, 取一次存下来
+        const KeyRange& old_range = old_node.meta.key_range();
+        const std::string& old_start = old_range.key_start();
+        const std::string& old_end = old_range.key_end();
         // update overlaped old nodes
-        if (old_start < new_start) {
-            if (!old_end.empty() && old_end <= new_start) {
-                //*************************************************
-                //* |---old---|                                   *
-                //*             |------new------|                 *
-                //*************************************************
-            } else if (new_end.empty() || (!old_end.empty() && old_end <= new_end)) {
+        if (TERA_LIKELY(old_start < new_start)) {
+            // 只有区间内第一个节点可能从new_start左边伸进来
+            if (new_end.empty() || (!old_end.empty() && old_end <= new_end)) {
                 //*************************************************
                 //*         |---old---|                           *
                 //*             |------new------|                 *
                 //*************************************************
                 VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
                     << "shrink to [" << old_start << ", " << new_start << "]";
-                old_node.meta.mutable_key_range()->set_key_end(new_start);
             } else {
                 //*************************************************
                 //*         |----------old-----------|            *
@@ -1604,42 +2073,40 @@ void TableImpl::UpdateTabletMetaList(const TabletMeta& new_meta) {
                 VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
                     << "split to [" << old_start << ", " << new_start << "] "
                     << "and [" << new_end << ", " << old_end << "]";
-                TabletMetaNode& copy_node = tablet_meta_list_[new_end];
-                copy_node = old_node;
-                copy_node.meta.mutable_key_range()->set_key_start(new_end);
-                old_node.meta.mutable_key_range()->set_key_end(new_start);
-            }
-        } else if (new_end.empty() || old_start < new_end) {
-            if (new_end.empty() || (!old_end.empty() && old_end <= new_end)) {
-                //*************************************************
-                //*                |---old---|                    *
-                //*             |------new------|                 *
-                //*************************************************
-                VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
-                    << "is covered by [" << new_start << ", " << new_end << "]";
-                tablet_meta_list_.erase(tmp);
-            } else {
-                //*************************************************
-                //*                  |-----old------|             *
-                //*             |------new------|                 *
-                //*************************************************
-                VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
-                    << "shrink to [" << new_end << ", " << old_end << "]";
-                TabletMetaNode& copy_node = tablet_meta_list_[new_end];
-                copy_node = old_node;
-                copy_node.meta.mutable_key_range()->set_key_start(new_end);
-                tablet_meta_list_.erase(tmp);
+                tail_node = old_node;
+                tail_node.meta.mutable_key_range()->set_key_start(new_end);
+                has_tail = true;
             }
-        } else { // !new_end.empty() && old_start >= new_end
-            //*****************************************************
-            //*                                   |---old---|     *
-            //*                 |------new------|                 *
-            //*****************************************************
-            break;
+            old_node.meta.mutable_key_range()->set_key_end(new_start);
+            erase_first = idx + 1; // 左边的节点缩短后保留
+        } else if (new_end.empty() || (!old_end.empty() && old_end <= new_end)) {
+            //*************************************************
+            //*                |---old---|                    *
+            //*             |------new------|                 *
+            //*************************************************
+            VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
+                << "is covered by [" << new_start << ", " << new_end << "]";
+        } else {
+            //*************************************************
+            //*                  |-----old------|             *
+            //*             |------new------|                 *
+            //*************************************************
+            VLOG(10) << "meta [" << old_start << ", " << old_end << "] "
+                << "shrink to [" << new_end << ", " << old_end << "]";
+            tail_node = old_node;
+            tail_node.meta.mutable_key_range()->set_key_start(new_end);
+            has_tail = true;
         }
     }
+    if (erase_first < last) {
+        tablet_meta_list_.erase(tablet_meta_list_.begin() + erase_first,
+                                tablet_meta_list_.begin() + last);
+    }
+    if (has_tail) {
+        *GetOrInsertTabletMetaNode(new_end) = tail_node;
+    }
 
-    TabletMetaNode& new_node = tablet_meta_list_[new_start];
+    TabletMetaNode& new_node = *GetOrInsertTabletMetaNode(new_start);
     new_node.meta.CopyFrom(new_meta);
     new_node.status = NORMAL;
     new_node.update_time = get_micros() / 1000;
@@ -1650,6 +2117,10 @@ void TableImpl::UpdateTabletMetaList(const TabletMeta& new_meta) {
 
 void TableImpl::WakeUpPendingRequest(const TabletMetaNode& node) {
     meta_mutex_.AssertHeld();
+    // 常见情形: cookie恢复/预取式meta更新时根本没有请求在等, 直接返回
+    if (pending_task_id_list_.empty()) {
+        return;
+    }
     const std::string& start_key = node.meta.key_range().key_start();
     const std::string& end_key = node.meta.key_range().key_end();
     const std::string& server_addr = node.meta.server_addr();
@@ -1658,44 +2129,56 @@ void TableImpl::WakeUpPendingRequest(const TabletMetaNode& node) {
     std::vector<RowMutationImpl*> mutation_list;
     std::vector<RowReaderImpl*> reader_list;
 
-    std::map<std::string, std::list<int64_t> >::iterator it =
+    // 整段消费[start_key, end_key)内的pending桶: 先把区间内所有id收齐,
+    // 一次性erase, 再批量GetTasks, 每个任务池分片只拿一次锁
+    std::vector<int64_t> all_task_ids;
+    boost::container::flat_map<std::string, std::vector<int64_t> >::iterator first =
         pending_task_id_list_.lower_bound(start_key);
+    boost::container::flat_map<std::string, std::vector<int64_t> >::iterator it = first;
     while (it != pending_task_id_list_.end()) {
         if (!end_key.empty() && it->first >= end_key) {
             break;
         }
-        std::list<int64_t>& task_id_list = it->second;
-        for (std::list<int64_t>::iterator itask = task_id_list.begin();
-                itask != task_id_list.end(); ++itask) {
-            int64_t task_id = *itask;
-            SdkTask* task = task_pool_.GetTask(task_id);
-            if (task == NULL) {
-                VLOG(10) << "task " << task_id << " timeout when update meta success";
-                continue;
-            }
-            task->SetMetaTimeStamp(meta_timestamp);
-
-            switch (task->Type()) {
-            case SdkTask::READ: {
-                RowReaderImpl* reader = (RowReaderImpl*)task;
-                reader_list.push_back(reader);
-            } break;
-            case SdkTask::MUTATION: {
-                RowMutationImpl* mutation = (RowMutationImpl*)task;
-                mutation_list.push_back(mutation);
-            } break;
-            case SdkTask::SCAN: {
-                ScanTask* scan_task = (ScanTask*)task;
-                CommitScan(scan_task, server_addr);
-            } break;
-            default:
-                CHECK(false);
-                break;
-            }
-        }
-        std::map<std::string, std::list<int64_t> >::iterator tmp = it;
+        const std::vector<int64_t>& task_id_list = it->second;
+        all_task_ids.insert(all_task_ids.end(),
+                            task_id_list.begin(), task_id_list.end());
         ++it;
-        pending_task_id_list_.erase(tmp);
+    }
+    pending_task_id_list_.erase(first, it);
+    if (all_task_ids.empty()) {
+        // 有pending但都落在本次更新范围之外
+        return;
+    }
+
+    std::vector<SdkTask*> tasks;
+    task_pool_.GetTasks(all_task_ids, &tasks);
+    mutation_list.reserve(all_task_ids.size());
+    reader_list.reserve(all_task_ids.size());
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        SdkTask* task = tasks[i];
+        if (task == NULL) {
+            VLOG(10) << "task " << all_task_ids[i] << " timeout when update meta success";
+            continue;
+        }
+        task->SetMetaTimeStamp(meta_timestamp);
+
+        switch (task->Type()) {
+        case SdkTask::READ: {
+            RowReaderImpl* reader = (RowReaderImpl*)task;
+            reader_list.push_back(reader);
+        } break;
+        case SdkTask::MUTATION: {
+            RowMutationImpl* mutation = (RowMutationImpl*)task;
+            mutation_list.push_back(mutation);
+        } break;
+        case SdkTask::SCAN: {
+            ScanTask* scan_task = (ScanTask*)task;
+            CommitScan(scan_task, server_addr);
+        } break;
+        default:
+            CHECK(false);
+            break;
+        }
     }
 
     if (mutation_list.size() > 0) {
@@ -1709,10 +2192,10 @@ void TableImpl::WakeUpPendingRequest(const TabletMetaNode& node) {
 
 void TableImpl::ScheduleUpdateMeta(const std::string& row,
                                    int64_t meta_timestamp) {
-    MutexLock lock(&meta_mutex_);
+    WriterMutexLock lock(&meta_mutex_);
     TabletMetaNode* node = GetTabletMetaNodeForKey(row);
     if (node == NULL) {
-        TabletMetaNode& new_node = tablet_meta_list_[row];
+        TabletMetaNode& new_node = *GetOrInsertTabletMetaNode(row);
         new_node.meta.mutable_key_range()->set_key_start(row);
         new_node.meta.mutable_key_range()->set_key_end(row + '\0');
         new_node.status = WAIT_UPDATE;
@@ -1744,8 +2227,20 @@ bool TableImpl::UpdateTableMeta(ErrorCode* err) {
     ReadTableMetaAsync(err, 0, false);
     table_meta_mutex_.Lock();
 
+    // 有界等待: 重试链每跳最多花一个退避上限加一个rpc超时, 两倍预算都
+    // 等不到说明回调链被丢了, 不能让调用线程无限期陪挂
+    int64_t budget_ms = 2LL * (FLAGS_tera_sdk_retry_times + 1)
+        * (FLAGS_tera_sdk_delay_send_max_internal + FLAGS_tera_sdk_timeout);
+    int64_t deadline_ms = get_micros() / 1000 + budget_ms;
     while (table_meta_updating_) {
-        table_meta_cond_.Wait();
+        int64_t now_ms = get_micros() / 1000;
+        if (now_ms >= deadline_ms) {
+            LOG(ERROR) << "table meta of " << name_
+                << " still updating after " << budget_ms << " ms, give up";
+            err->SetFailed(ErrorCode::kSystem, "update table meta timeout");
+            return false;
+        }
+        table_meta_cond_.TimeWait(static_cast<int>(deadline_ms - now_ms));
     }
     if (err->GetType() != ErrorCode::kOK) {
         return false;
@@ -1769,8 +2264,7 @@ void TableImpl::ReadTableMetaAsync(ErrorCode* ret_err, int32_t retry_times,
             table_meta_updating_ = false;
             table_meta_cond_.Signal();
         } else {
-            int64_t retry_interval =
-                static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal, retry_times) * 1000);
+            int64_t retry_interval = RetryBackoffMs(retry_times);
             ThreadPool::Task retry_task =
                 boost::bind(&TableImpl::ReadTableMetaAsync, this, ret_err, retry_times + 1, true);
             thread_pool_->DelayTask(retry_interval, retry_task);
@@ -1778,7 +2272,7 @@ void TableImpl::ReadTableMetaAsync(ErrorCode* ret_err, int32_t retry_times,
         return;
     }
 
-    tabletnode::TabletNodeClient tabletnode_client_async(meta_server);
+    tabletnode::TabletNodeClient* tabletnode_client_async = GetTabletNodeClient(meta_server);
     ReadTabletRequest* request = new ReadTabletRequest;
     ReadTabletResponse* response = new ReadTabletResponse;
     request->set_sequence_id(last_sequence_id_++);
@@ -1788,7 +2282,7 @@ void TableImpl::ReadTableMetaAsync(ErrorCode* ret_err, int32_t retry_times,
 
     Closure<void, ReadTabletRequest*, ReadTabletResponse*, bool, int>* done =
         NewClosure(this, &TableImpl::ReadTableMetaCallBack, ret_err, retry_times);
-    tabletnode_client_async.ReadTablet(request, response, done);
+    tabletnode_client_async->ReadTablet(request, response, done);
 }
 
 void TableImpl::ReadTableMetaCallBack(ErrorCode* ret_err,
@@ -1797,21 +2291,7 @@ void TableImpl::ReadTableMetaCallBack(ErrorCode* ret_err,
                                       ReadTabletResponse* response,
                                       bool failed, int error_code) {
     if (failed) {
-        if (error_code == sofa::pbrpc::RPC_ERROR_SERVER_SHUTDOWN ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNREACHABLE ||
-            error_code == sofa::pbrpc::RPC_ERROR_SERVER_UNAVAILABLE) {
-            response->set_status(kServerError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_CANCELED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_SEND_BUFFER_FULL) {
-            response->set_status(kClientError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_CONNECTION_CLOSED ||
-                   error_code == sofa::pbrpc::RPC_ERROR_RESOLVE_ADDRESS) {
-            response->set_status(kConnectError);
-        } else if (error_code == sofa::pbrpc::RPC_ERROR_REQUEST_TIMEOUT) {
-            response->set_status(kRPCTimeout);
-        } else {
-            response->set_status(kRPCError);
-        }
+        response->set_status(TranslateRpcError(error_code));
     }
 
     StatusCode err = response->status();
@@ -1857,8 +2337,7 @@ void TableImpl::ReadTableMetaCallBack(ErrorCode* ret_err,
         table_meta_updating_ = false;
         table_meta_cond_.Signal();
     } else {
-        int64_t retry_interval =
-            static_cast<int64_t>(pow(FLAGS_tera_sdk_delay_send_internal, retry_times) * 1000);
+        int64_t retry_interval = RetryBackoffMs(retry_times);
         ThreadPool::Task retry_task =
             boost::bind(&TableImpl::ReadTableMetaAsync, this, ret_err, retry_times + 1, true);
         thread_pool_->DelayTask(retry_interval, retry_task);
@@ -1889,14 +2368,15 @@ bool TableImpl::RestoreCookie() {
         return true;
     }
 
-    MutexLock lock(&meta_mutex_);
+    WriterMutexLock lock(&meta_mutex_);
+    tablet_meta_list_.reserve(tablet_meta_list_.size() + cookie.tablets_size());
     for (int i = 0; i < cookie.tablets_size(); ++i) {
         const TabletMeta& meta = cookie.tablets(i).meta();
         const std::string& start_key = meta.key_range().key_start();
         LOG(INFO) << "[SDK COOKIE] restore:" << meta.path()
             << " range [" << DebugString(start_key)
             << " : " << DebugString(meta.key_range().key_end()) << "]";
-        TabletMetaNode& node = tablet_meta_list_[start_key];
+        TabletMetaNode& node = *GetOrInsertTabletMetaNode(start_key);
         node.meta = meta;
         node.update_time = cookie.tablets(i).update_time();
         node.status = NORMAL;
@@ -1917,21 +2397,24 @@ std::string TableImpl::GetCookieLockFilePathName(void) {
 void TableImpl::DoDumpCookie() {
     std::string cookie_file = GetCookieFilePathName();
     std::string cookie_lock_file = GetCookieLockFilePathName();
+    // 锁内只做一次线性快照; cookie消息的逐tablet构造挪到锁外,
+    // 缩短锁持有时间, 写端(meta更新)不用等整个cookie拼完
+    std::vector<TabletMetaNode> meta_snapshot;
+    {
+        ReaderMutexLock lock(&meta_mutex_);
+        meta_snapshot = tablet_meta_list_;
+    }
     SdkCookie cookie;
     cookie.set_table_name(name_);
-    {
-        MutexLock lock(&meta_mutex_);
-        std::map<std::string, TabletMetaNode>::iterator it = tablet_meta_list_.begin();
-        for (; it != tablet_meta_list_.end(); ++it) {
-            const TabletMetaNode& node = it->second;
-            if (!node.meta.has_table_name() || !node.meta.has_path()) {
-                continue;
-            }
-            SdkTabletCookie* tablet = cookie.add_tablets();
-            tablet->mutable_meta()->CopyFrom(node.meta);
-            tablet->set_update_time(node.update_time);
-            tablet->set_status(node.status);
+    for (size_t i = 0; i < meta_snapshot.size(); ++i) {
+        const TabletMetaNode& node = meta_snapshot[i];
+        if (!node.meta.has_table_name() || !node.meta.has_path()) {
+            continue;
         }
+        SdkTabletCookie* tablet = cookie.add_tablets();
+        tablet->mutable_meta()->Swap(&meta_snapshot[i].meta);
+        tablet->set_update_time(node.update_time);
+        tablet->set_status(node.status);
     }
     if (!IsExist(FLAGS_tera_sdk_cookie_path) && !CreateDirWithRetry(FLAGS_tera_sdk_cookie_path)) {
         LOG(ERROR) << "[SDK COOKIE] fail to create cookie dir: " << FLAGS_tera_sdk_cookie_path;
@@ -1958,19 +2441,35 @@ std::string TableImpl::GetCookieFileName(const std::string& tablename,
     if (GetHashNumber(cluster_id, hash, &hash) != 0) {
         LOG(FATAL) << "invalid arguments";
     }
-    char hash_str[9] = {'\0'};
-    sprintf(hash_str, "%08x", hash);
-    std::stringstream fname;
-    fname << tablename << "-" << create_time << "-" << hash_str;
-    return fname.str();
+    // 手工转十六进制, 省掉sprintf的格式解析和stringstream的locale开销
+    static const char kHexDigit[] = "0123456789abcdef";
+    char hash_str[9];
+    for (int i = 0; i < 8; ++i) {
+        hash_str[7 - i] = kHexDigit[(hash >> (i * 4)) & 0xF];
+    }
+    hash_str[8] = '\0';
+    char time_str[kMaxIntegerStringSize];
+    Int64ToString(create_time, time_str);
+    size_t time_len = strlen(time_str);
+    std::string fname;
+    fname.reserve(tablename.size() + 1 + time_len + 1 + 8);
+    fname.append(tablename);
+    fname.push_back('-');
+    fname.append(time_str, time_len);
+    fname.push_back('-');
+    fname.append(hash_str, 8);
+    return fname;
 }
 
 static int64_t CalcAverage(Counter& sum, Counter& cnt, int64_t interval) {
-    if (cnt.Get() == 0 || interval == 0) {
+    // 先把两个计数原子换出来再判零: 原来Get后到两次Clear之间并发写
+    // 会让sum/cnt取自不同时刻, 算出偏斜的均值
+    int64_t s = sum.Clear();
+    int64_t c = cnt.Clear();
+    if (c == 0 || interval == 0) {
         return 0;
-    } else {
-        return sum.Clear() * 1000 / cnt.Clear() / interval / 1000;
     }
+    return s * 1000 / c / interval / 1000;
 }
 
 void TableImpl::DumpPerfCounterLogDelay() {
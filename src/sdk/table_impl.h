@@ -5,6 +5,9 @@
 #ifndef  TERA_SDK_TABLE_IMPL_H_
 #define  TERA_SDK_TABLE_IMPL_H_
 
+#include <boost/container/flat_map.hpp>
+#include <boost/shared_ptr.hpp>
+
 #include "common/mutex.h"
 #include "common/timer.h"
 #include "common/thread_pool.h"
@@ -216,15 +219,17 @@ public:
     TableSchema GetTableSchema() { return  table_schema_; }
 
     struct PerfCounter {
+        // rpc回调线程并发更新的热点计数独占cache line，
+        // 避免相邻计数之间的false sharing
         int64_t start_time;
-        Counter rpc_r;                    // 读取的耗时
-        Counter rpc_r_cnt;                // 读取的次数
+        PaddedCounter rpc_r;              // 读取的耗时
+        PaddedCounter rpc_r_cnt;          // 读取的次数
 
-        Counter rpc_w;                    // 写入的耗时
-        Counter rpc_w_cnt;                // 写入的次数
+        PaddedCounter rpc_w;              // 写入的耗时
+        PaddedCounter rpc_w_cnt;          // 写入的次数
 
-        Counter rpc_s;                    // scan的耗时
-        Counter rpc_s_cnt;                // scan的次数
+        PaddedCounter rpc_s;              // scan的耗时
+        PaddedCounter rpc_s_cnt;          // scan的次数
 
         Counter user_callback;            // 运行用户callback的耗时
         Counter user_callback_cnt;        // 运行用户callback的次数
@@ -232,14 +237,14 @@ public:
         Counter get_meta;                 // 更新meta的耗时
         Counter get_meta_cnt;             // 更新meta的次数
 
-        Counter mutate_cnt;               // 分发mutation的次数
+        PaddedCounter mutate_cnt;         // 分发mutation的次数
         Counter mutate_ok_cnt;            // mutation回调成功的次数
         Counter mutate_fail_cnt;          // mutation回调失败的次数
         Counter mutate_range_cnt;         // mutation回调失败-原因为not in range
         Counter mutate_timeout_cnt;       // mutation在sdk队列中超时
         Counter mutate_queue_timeout_cnt; // mutation在sdk队列中超时，且之前从未被重试过
 
-        Counter reader_cnt;               // 分发reader的次数
+        PaddedCounter reader_cnt;         // 分发reader的次数
         Counter reader_ok_cnt;            // reader回调成功的次数
         Counter reader_fail_cnt;          // reader回调失败的次数
         Counter reader_range_cnt;         // reader回调失败-原因为not in range
@@ -271,7 +276,9 @@ private:
                        bool flush);
 
     // mutation打包不满但到达最大等待时间
-    void MutationBatchTimeout(std::string server_addr, uint64_t batch_seq);
+    // server_addr经shared_ptr传递, 避免闭包里的字符串拷贝
+    void MutationBatchTimeout(boost::shared_ptr<std::string> server_addr,
+                              uint64_t batch_seq);
 
     // 通过异步RPC将mutation提交至TS
     void CommitMutationsById(const std::string& server_addr,
@@ -280,11 +287,16 @@ private:
                          std::vector<RowMutationImpl*>& mu_list);
 
     // mutate RPC回调
-    void MutateCallBack(std::vector<int64_t>* mu_id_list,
+    void MutateCallBack(std::string server_addr,
+                        std::vector<int64_t>* mu_id_list,
                         WriteTabletRequest* request,
                         WriteTabletResponse* response,
                         bool failed, int error_code);
 
+    // batch RPC返回后释放在途窗口，若积压的batch已超过
+    // 大小阈值则立即将其发出
+    void OnMutationBatchRpcFinished(const std::string& server_addr);
+
     // mutation到达用户设置的超时时间但尚未处理完
     void MutationTimeout(SdkTask* sdk_task);
 
@@ -299,7 +311,8 @@ private:
                      std::vector<RowReaderImpl*>& reader_list);
 
     // reader打包不满但到达最大等待时间
-    void ReaderBatchTimeout(std::string server_addr, uint64_t batch_seq);
+    void ReaderBatchTimeout(boost::shared_ptr<std::string> server_addr,
+                            uint64_t snapshot_id, uint64_t batch_seq);
 
     // 通过异步RPC将reader提交至TS
     void CommitReadersById(const std::string server_addr,
@@ -313,9 +326,19 @@ private:
                         ReadTabletResponse* response,
                         bool failed, int error_code);
 
+    // 整批成功时的快速路径, 跳过逐行错误映射
+    void ReaderCallBackFastPath(std::vector<int64_t>* reader_id_list,
+                                ReadTabletResponse* response);
+
     // reader到达用户设置的超时时间但尚未处理完
     void ReaderTimeout(SdkTask* sdk_task);
 
+    // 流控阻塞：等待pending计数降至上限以下，由SignalPendingDrained唤醒
+    void WaitPendingDrained(Counter* counter, int64_t max_pending);
+
+    // 唤醒因流控阻塞的线程，pending计数每次递减后调用
+    void SignalPendingDrained();
+
     void ScanTabletAsync(ScanTask* scan_task, bool called_by_user);
 
     void CommitScan(ScanTask* scan_task, const std::string& server_addr);
@@ -340,12 +363,42 @@ private:
         TabletMetaNode() : update_time(0), status(NORMAL) {}
     };
 
+    // tablet_meta_list_按start_key排序, 二分查找用的比较器
+    struct TabletMetaNodeKeyLess {
+        bool operator()(const TabletMetaNode& node, const std::string& key) const {
+            return node.meta.key_range().key_start() < key;
+        }
+        bool operator()(const std::string& key, const TabletMetaNode& node) const {
+            return key < node.meta.key_range().key_start();
+        }
+    };
+
+    // 一次Distribute调用内的路由缓存: 记录上一行命中的tablet范围,
+    // 有序(或聚簇)的行连续命中同一tablet时可免去meta_mutex_下的查表。
+    // 只在一次调用内有效, 不能缓存TabletMetaNode指针(meta更新会改表)
+    struct TabletRouteHint {
+        std::string start_key;
+        std::string end_key;
+        std::string server_addr;
+        int64_t update_time;
+        bool valid;
+
+        TabletRouteHint() : update_time(0), valid(false) {}
+    };
+
     bool GetTabletAddrOrScheduleUpdateMeta(const std::string& row,
                                            SdkTask* request,
-                                           std::string* server_addr);
+                                           std::string* server_addr,
+                                           TabletRouteHint* hint = NULL);
 
     TabletMetaNode* GetTabletMetaNodeForKey(const std::string& key);
 
+    // 返回第一个start_key >= key的节点下标
+    size_t LowerBoundTabletMeta(const std::string& key);
+
+    // 按start_key取节点, 不存在则在有序位置插入一个空节点
+    TabletMetaNode* GetOrInsertTabletMetaNode(const std::string& start_key);
+
     void DelayUpdateMeta(std::string start_key, std::string end_key);
 
     void UpdateMetaAsync();
@@ -408,31 +461,71 @@ private:
         std::vector<int64_t>* row_id_list;
     };
 
+    // batch缓冲按server_addr哈希分片，写往不同TS的线程只锁各自的
+    // 分片，避免所有writer/reader在一把互斥锁上串行；sequence号
+    // 改为分片内分配，仍能唯一标识同一server_addr上的一个batch。
+    // key带snapshot_id: 不同snapshot的读不能合并进同一个rpc,
+    // 各自成批而不是互相打断; 写路径snapshot恒为0
+    typedef std::pair<std::string, uint64_t> BatchKey;
+    static const uint32_t kBatchShardNum = 32;
+    struct BatchShard {
+        mutable Mutex mutex;
+        std::map<BatchKey, TaskBatch> batch_map;
+        // 每个server_addr在途的batch RPC数，只在打开
+        // tera_sdk_max_inflight_batch_rpc限流时维护
+        std::map<std::string, uint32_t> inflight_map;
+        uint64_t next_sequence_num;
+        BatchShard() : next_sequence_num(0) {}
+    };
+    BatchShard* GetBatchShard(BatchShard* shards, const std::string& server_addr);
+
+    // 查预计算的重试退避表(毫秒), 超出表长按最大退避处理
+    int64_t RetryBackoffMs(uint32_t retry_times);
+
+    // 按server_addr缓存的rpc客户端, 不存在时创建并缓存。
+    // 构造TabletNodeClient要查全局channel表(加全局锁)并堆分配stub,
+    // 缓存后每次rpc只查本表。缓存实例只可用于带done的异步调用,
+    // 同步调用复用实例会共享内部的等待事件, 不安全
+    tabletnode::TabletNodeClient* GetTabletNodeClient(const std::string& server_addr);
+
     std::string name_;
     int64_t create_time_;
     uint64_t last_sequence_id_;
     uint32_t timeout_;
 
-    mutable Mutex mutation_batch_mutex_;
-    mutable Mutex reader_batch_mutex_;
     uint32_t commit_size_;
     uint64_t write_commit_timeout_;
     uint64_t read_commit_timeout_;
-    std::map<std::string, TaskBatch> mutation_batch_map_;
-    std::map<std::string, TaskBatch> reader_batch_map_;
-    uint64_t mutation_batch_seq_;
-    uint64_t reader_batch_seq_;
-    Counter cur_commit_pending_counter_;
-    Counter cur_reader_pending_counter_;
+    BatchShard mutation_batch_shards_[kBatchShardNum];
+    BatchShard reader_batch_shards_[kBatchShardNum];
+    PaddedCounter cur_commit_pending_counter_;
+    PaddedCounter cur_reader_pending_counter_;
     int64_t max_commit_pending_num_;
     int64_t max_reader_pending_num_;
+    // 构造时固化的flag快照, 热路径不再反复读全局flag变量
+    const bool async_blocking_enabled_;
+    const int32_t max_inflight_batch_rpc_;
+    // 流控阻塞的线程在此condvar上等待，避免轮询pending计数；
+    // waiter计数用于让无人等待时的回调路径跳过加锁
+    mutable Mutex pending_mutex_;
+    common::CondVar pending_cond_;
+    Counter pending_waiter_counter_;
 
     // meta management
-    mutable Mutex meta_mutex_;
+    // 读写锁: 路由查表走读锁可并行, 只有meta更新/pending管理拿写锁
+    mutable RWMutex meta_mutex_;
+    // meta_updating_count_的等待/唤醒走独立小锁, 不依赖读写锁做条件变量
+    mutable Mutex meta_sync_mutex_;
     common::CondVar meta_cond_;
-    std::map<std::string, std::list<int64_t> > pending_task_id_list_;
-    uint32_t meta_updating_count_;
-    std::map<std::string, TabletMetaNode> tablet_meta_list_;
+    // flat_map: 有序数组存储, WakeUpPendingRequest的区间遍历是连续访问;
+    // pending的key数量不大, 插入时的搬移可以接受。桶内是顺序扫+整桶消费,
+    // 用vector而不是list, 免去每个id一次小块分配
+    boost::container::flat_map<std::string, std::vector<int64_t> > pending_task_id_list_;
+    // 原子计数, 增减不用拿锁; meta_sync_mutex_只为Signal/Wait配对服务
+    Counter meta_updating_count_;
+    // 按start_key排序的有序数组: 路由查表只读且远多于meta更新,
+    // 连续存储+二分比红黑树省去逐节点的指针跳转和cache miss
+    std::vector<TabletMetaNode> tablet_meta_list_;
     // end of meta management
 
     // table meta managerment
@@ -443,11 +536,18 @@ private:
     // end of table meta managerment
 
     SdkTimeoutManager task_pool_;
-    Counter next_task_id_;
+    // 超时回调绑定对象构造一次复用，不在每次分发时重新bind
+    const SdkTask::TimeoutFunc mutation_timeout_func_;
+    const SdkTask::TimeoutFunc reader_timeout_func_;
+    PaddedCounter next_task_id_;
 
     master::MasterClient* master_client_;
     tabletnode::TabletNodeClient* tabletnode_client_;
 
+    // 异步rpc客户端缓存, 见GetTabletNodeClient
+    mutable Mutex client_cache_mutex_;
+    std::map<std::string, tabletnode::TabletNodeClient*> client_cache_;
+
     ThreadPool* thread_pool_;
     mutable Mutex delay_task_id_mutex_;
     std::set<int64_t> delay_task_ids_;
@@ -464,6 +564,9 @@ private:
     /// read request will contain this member,
     /// so tabletnodes can drop the read-request that timeouted
     uint64_t pending_timeout_ms_;
+
+    // 构造时按重试次数预计算的退避表(毫秒), 见RetryBackoffMs
+    std::vector<int64_t> retry_backoff_ms_;
 };
 
 class TableWrapper: public Table {
@@ -2,7 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include "common/this_thread.h"
+#include "common/thread.h"
 
 #include "tabletnode/tabletnode_zk_adapter.h"
 #include "types.h"
@@ -21,6 +30,36 @@ DECLARE_string(tera_ins_root_path);
 namespace tera {
 namespace tabletnode {
 
+namespace {
+
+// 截断指数退避: 从上限的1/8起步逐次翻倍, 封顶于FLAGS_tera_zk_retry_period,
+// 每次再叠加最多25%的随机抖动。zk抖动恢复时全集群tabletnode不再同拍重试,
+// 瞬时故障也能以小间隔快速恢复, 持续故障则退避到原有周期
+class ZkRetrySleeper {
+public:
+    ZkRetrySleeper()
+        : period_(FLAGS_tera_zk_retry_period / 8 + 1),
+          seed_(static_cast<unsigned int>(time(NULL))
+                ^ static_cast<unsigned int>(
+                    reinterpret_cast<uintptr_t>(this) >> 4)) {
+    }
+    void Sleep() {
+        int64_t jitter = rand_r(&seed_) % (period_ / 4 + 1);
+        ThisThread::Sleep(period_ + jitter);
+        period_ = std::min(period_ * 2, FLAGS_tera_zk_retry_period);
+    }
+    // 某一步成功后, 下一步的重试从小间隔重新起步
+    void Reset() {
+        period_ = FLAGS_tera_zk_retry_period / 8 + 1;
+    }
+
+private:
+    int64_t period_;
+    unsigned int seed_;
+};
+
+} // namespace
+
 TabletNodeZkAdapter::TabletNodeZkAdapter(TabletNodeImpl* tabletnode_impl,
                                          const std::string& server_addr)
     : tabletnode_impl_(tabletnode_impl), server_addr_(server_addr) {
@@ -31,14 +70,16 @@ TabletNodeZkAdapter::~TabletNodeZkAdapter() {
 
 void TabletNodeZkAdapter::Init() {
     int zk_errno;
+    ZkRetrySleeper retry;
 
     // init zk client
     while (!ZooKeeperAdapter::Init(FLAGS_tera_zk_addr_list,
                                 FLAGS_tera_zk_root_path, FLAGS_tera_zk_timeout,
                                 server_addr_, &zk_errno)) {
         LOG(ERROR) << "fail to init zk : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        retry.Sleep();
     }
+    retry.Reset();
     LOG(INFO) << "init zk success";
 
     // enter running state
@@ -47,16 +88,23 @@ void TabletNodeZkAdapter::Init() {
         LOG(ERROR) << "get session id fail : " << zk::ZkErrnoToString(zk_errno);
         return;
     }
-    char session_id_str[32];
-    sprintf(session_id_str, "%016lx", session_id_int);
+    // 手工转16位零填充十六进制, 输出与原sprintf("%016lx")逐字节一致
+    static const char kHexDigit[] = "0123456789abcdef";
+    char session_id_str[17];
+    for (int i = 0; i < 16; ++i) {
+        session_id_str[15 - i] =
+            kHexDigit[(static_cast<uint64_t>(session_id_int) >> (i * 4)) & 0xF];
+    }
+    session_id_str[16] = '\0';
     tabletnode_impl_->SetSessionId(session_id_str);
     tabletnode_impl_->SetTabletNodeStatus(TabletNodeImpl::kIsRunning);
 
     // create my node
     while (!Register(tabletnode_impl_->GetSessionId(), &zk_errno)) {
         LOG(ERROR) << "fail to create serve-node : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        retry.Sleep();
     }
+    retry.Reset();
     LOG(INFO) << "create serve-node success";
 
     bool is_exist = false;
@@ -64,8 +112,9 @@ void TabletNodeZkAdapter::Init() {
     // watch my node
     while (!WatchSelfNode(&is_exist, &zk_errno)) {
         LOG(ERROR) << "fail to watch serve-node : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        retry.Sleep();
     }
+    retry.Reset();
     LOG(INFO) << "watch serve-node success";
     if (!is_exist) {
         OnSelfNodeDeleted();
@@ -74,8 +123,9 @@ void TabletNodeZkAdapter::Init() {
     // watch kick node
     while (!WatchKickMark(&is_exist, &zk_errno)) {
         LOG(ERROR) << "fail to watch kick mark : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        retry.Sleep();
     }
+    retry.Reset();
     LOG(INFO) << "watch kick mark success";
     if (is_exist) {
         OnKickMarkCreated();
@@ -84,23 +134,16 @@ void TabletNodeZkAdapter::Init() {
     // watch safemode node
     while (!WatchSafeModeMark(&is_exist, &zk_errno)) {
         LOG(ERROR) << "fail to watch safemode mark : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        retry.Sleep();
     }
+    retry.Reset();
     LOG(INFO) << "watch safemode mark success";
     if (is_exist) {
         OnSafeModeMarkCreated();
     }
 
     // watch root node
-    std::string root_tablet_addr;
-    while (!WatchRootNode(&is_exist, &root_tablet_addr, &zk_errno)) {
-        LOG(ERROR) << "fail to watch root node : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
-    }
-    LOG(INFO) << "watch root node success";
-    if (!root_tablet_addr.empty()) {
-        tabletnode_impl_->SetRootTabletAddr(root_tablet_addr);
-    }
+    RewatchRootNode();
 }
 
 bool TabletNodeZkAdapter::GetRootTableAddr(std::string* root_table_addr) {
@@ -179,41 +222,49 @@ void TabletNodeZkAdapter::OnMasterNodeChanged(const std::string& master) {
 }
 */
 
-void TabletNodeZkAdapter::OnRootNodeCreated() {
-    LOG(INFO) << "root node is created";
-    // watch root node
+void TabletNodeZkAdapter::RewatchRootNode() {
     int zk_errno = zk::ZE_OK;
     bool is_exist = false;
     std::string root_tablet_addr;
+    ZkRetrySleeper retry;
     while (!WatchRootNode(&is_exist, &root_tablet_addr, &zk_errno)) {
-        LOG(ERROR) << "fail to root node : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
+        LOG(ERROR) << "fail to watch root node : " << zk::ZkErrnoToString(zk_errno);
+        retry.Sleep();
     }
     LOG(INFO) << "watch root node success";
-    if (!root_tablet_addr.empty()) {
-        tabletnode_impl_->SetRootTabletAddr(root_tablet_addr);
+    PublishRootTabletAddr(root_tablet_addr);
+}
+
+void TabletNodeZkAdapter::PublishRootTabletAddr(const std::string& root_tablet_addr) {
+    if (root_tablet_addr.empty()) {
+        return;
     }
+    {
+        MutexLock locker(&root_addr_mutex_);
+        if (root_tablet_addr == last_root_addr_) {
+            // root节点create/delete/create空翻转会重复读到同一地址,
+            // 不再触发下游的meta刷新
+            VLOG(5) << "root addr not changed : " << root_tablet_addr;
+            return;
+        }
+        last_root_addr_ = root_tablet_addr;
+    }
+    tabletnode_impl_->SetRootTabletAddr(root_tablet_addr);
+}
+
+void TabletNodeZkAdapter::OnRootNodeCreated() {
+    LOG(INFO) << "root node is created";
+    RewatchRootNode();
 }
 
 void TabletNodeZkAdapter::OnRootNodeDeleted() {
     LOG(INFO) << "root node is deleted";
-    // watch root node
-    int zk_errno = zk::ZE_OK;
-    bool is_exist = false;
-    std::string root_tablet_addr;
-    while (!WatchRootNode(&is_exist, &root_tablet_addr, &zk_errno)) {
-        LOG(ERROR) << "fail to root node : " << zk::ZkErrnoToString(zk_errno);
-        ThisThread::Sleep(FLAGS_tera_zk_retry_period);
-    }
-    LOG(INFO) << "watch root node success";
-    if (!root_tablet_addr.empty()) {
-        tabletnode_impl_->SetRootTabletAddr(root_tablet_addr);
-    }
+    RewatchRootNode();
 }
 
 void TabletNodeZkAdapter::OnRootNodeChanged(const std::string& root_tablet_addr) {
     LOG(INFO) << "root node is changed";
-    tabletnode_impl_->SetRootTabletAddr(root_tablet_addr);
+    PublishRootTabletAddr(root_tablet_addr);
 }
 
 void TabletNodeZkAdapter::OnSafeModeMarkCreated() {
@@ -247,35 +298,66 @@ void TabletNodeZkAdapter::OnChildrenChanged(const std::string& path,
 
 void TabletNodeZkAdapter::OnNodeValueChanged(const std::string& path,
                                              const std::string& value) {
-    if (path.compare(kRootTabletNodePath) == 0) {
+    // operator==先比长度再比内容, 不等长的杂散事件一步出局
+    if (path == kRootTabletNodePath) {
         OnRootNodeChanged(value);
     } else {
         LOG(ERROR) << "unexpected value event on path : " << path;
     }
 }
 
+// 关注的四个路径第二个字符互不相同(/safemode /root_table /kick/* /ts/*),
+// 先按它switch分流, 命中分支再做一次全等确认, 免去逐个全串compare
 void TabletNodeZkAdapter::OnNodeCreated(const std::string& path) {
-    if (path.compare(kSafeModeNodePath) == 0) {
-        OnSafeModeMarkCreated();
-    } else if (path.compare(kRootTabletNodePath) == 0) {
-        OnRootNodeCreated();
-    } else if (path.compare(kick_node_path_) == 0) {
-        OnKickMarkCreated();
-    } else {
-        LOG(ERROR) << "unexcepted node create event on path : " << path;
+    switch (path.size() > 1 ? path[1] : '\0') {
+    case 's':
+        if (path == kSafeModeNodePath) {
+            OnSafeModeMarkCreated();
+            return;
+        }
+        break;
+    case 'r':
+        if (path == kRootTabletNodePath) {
+            OnRootNodeCreated();
+            return;
+        }
+        break;
+    case 'k':
+        if (path == kick_node_path_) {
+            OnKickMarkCreated();
+            return;
+        }
+        break;
+    default:
+        break;
     }
+    LOG(ERROR) << "unexcepted node create event on path : " << path;
 }
 
 void TabletNodeZkAdapter::OnNodeDeleted(const std::string& path) {
-    if (path.compare(kSafeModeNodePath) == 0) {
-        OnSafeModeMarkDeleted();
-    } else if (path.compare(kRootTabletNodePath) == 0) {
-        OnRootNodeDeleted();
-    } else if (path.compare(serve_node_path_) == 0) {
-        OnSelfNodeDeleted();
-    } else {
-        LOG(ERROR) << "unexcepted node delete event on path : " << path;
+    switch (path.size() > 1 ? path[1] : '\0') {
+    case 's':
+        if (path == kSafeModeNodePath) {
+            OnSafeModeMarkDeleted();
+            return;
+        }
+        break;
+    case 'r':
+        if (path == kRootTabletNodePath) {
+            OnRootNodeDeleted();
+            return;
+        }
+        break;
+    case 't':
+        if (path == serve_node_path_) {
+            OnSelfNodeDeleted();
+            return;
+        }
+        break;
+    default:
+        break;
     }
+    LOG(ERROR) << "unexcepted node delete event on path : " << path;
 }
 
 void TabletNodeZkAdapter::OnWatchFailed(const std::string& path,
@@ -332,8 +414,9 @@ bool FakeTabletNodeZkAdapter::GetRootTableAddr(std::string* root_table_addr) {
 
 InsTabletNodeZkAdapter::InsTabletNodeZkAdapter(TabletNodeImpl* tabletnode_impl,
                                                const std::string& server_addr)
-    : tabletnode_impl_(tabletnode_impl), server_addr_(server_addr), ins_sdk_(NULL)  {
-
+    : tabletnode_impl_(tabletnode_impl), server_addr_(server_addr), ins_sdk_(NULL),
+      meta_table_path_(FLAGS_tera_ins_root_path + kRootTabletNodePath) {
+    // meta表路径在进程内不变, 构造时拼好, 免得每个meta变更回调重拼一遍
 }
 
 static void InsOnKick(const galaxy::ins::sdk::WatchParam& param,
@@ -375,29 +458,51 @@ void InsTabletNodeZkAdapter::Init() {
     LOG(INFO) << "create ts-node success: " << session_id;
 
     // create watch node
+    // 三个watch各是一次同步RPC且彼此独立, 并发提交再汇合,
+    // 注册耗时从3个RTT缩到1个; InsSDK自身线程安全
     std::string kick_key = root_path + kKickPath + "/" + session_id;
-    CHECK(ins_sdk_->Watch(kick_key, &InsOnKick, this, &err)) << "watch kick fail";
-    CHECK(ins_sdk_->Watch(lock_key, &InsOnLockChange, this, &err))
-          << "watch lock fail";
-    std::string meta_table = root_path + kRootTabletNodePath;
-    CHECK(ins_sdk_->Watch(meta_table, &InsOnMetaChange, this, &err))
-          << "watch meta table fail";
+    bool kick_ok = false;
+    bool lock_ok = false;
+    common::Thread kick_thread;
+    common::Thread lock_thread;
+    CHECK(kick_thread.Start(boost::bind(
+        &InsTabletNodeZkAdapter::AsyncWatchKick, this, kick_key, &kick_ok)));
+    CHECK(lock_thread.Start(boost::bind(
+        &InsTabletNodeZkAdapter::AsyncWatchLock, this, lock_key, &lock_ok)));
+    bool meta_ok = ins_sdk_->Watch(meta_table_path_, &InsOnMetaChange, this, &err);
+    kick_thread.Join();
+    lock_thread.Join();
+    CHECK(kick_ok) << "watch kick fail";
+    CHECK(lock_ok) << "watch lock fail";
+    CHECK(meta_ok) << "watch meta table fail";
+}
+
+void InsTabletNodeZkAdapter::AsyncWatchKick(const std::string& kick_key, bool* ok) {
+    galaxy::ins::sdk::SDKError err;
+    *ok = ins_sdk_->Watch(kick_key, &InsOnKick, this, &err);
 }
 
-void InsTabletNodeZkAdapter::OnMetaChange(std::string meta_addr, bool deleted) {
-    (void) meta_addr;
-    (void) deleted;
-    std::string cur_meta;
-    std::string root_path = FLAGS_tera_ins_root_path;
-    std::string meta_table = root_path + kRootTabletNodePath;
+void InsTabletNodeZkAdapter::AsyncWatchLock(const std::string& lock_key, bool* ok) {
     galaxy::ins::sdk::SDKError err;
-    GetRootTableAddr(&cur_meta);
-    CHECK(ins_sdk_->Watch(meta_table, &InsOnMetaChange, this, &err))
+    *ok = ins_sdk_->Watch(lock_key, &InsOnLockChange, this, &err);
+}
+
+void InsTabletNodeZkAdapter::OnMetaChange(const std::string& meta_addr, bool deleted) {
+    // 事件本身携带最新值, 不再为每个事件向ins同步Get一遍;
+    // meta翻腾时每个事件只剩重挂watch这一次RPC
+    galaxy::ins::sdk::SDKError err;
+    CHECK(ins_sdk_->Watch(meta_table_path_, &InsOnMetaChange, this, &err))
           << "watch meta table fail";
-    if (!cur_meta.empty()) {
-        MutexLock locker(&mutex_);
-        tabletnode_impl_->SetRootTabletAddr(cur_meta);
+    if (deleted || meta_addr.empty()) {
+        return;
     }
+    MutexLock locker(&mutex_);
+    if (meta_addr == last_meta_addr_) {
+        // 同值重复事件不再触发下游刷新
+        return;
+    }
+    last_meta_addr_ = meta_addr;
+    tabletnode_impl_->SetRootTabletAddr(meta_addr);
 }
 
 void InsTabletNodeZkAdapter::OnKickMarkCreated() {
@@ -405,7 +510,7 @@ void InsTabletNodeZkAdapter::OnKickMarkCreated() {
     _Exit(EXIT_FAILURE);
 }
 
-void InsTabletNodeZkAdapter::OnLockChange(std::string session_id, bool deleted) {
+void InsTabletNodeZkAdapter::OnLockChange(const std::string& session_id, bool deleted) {
     if (deleted || session_id != ins_sdk_->GetSessionID()) {
         LOG(ERROR) << "I lost my lock , so quit";
         _Exit(EXIT_FAILURE);
@@ -413,12 +518,18 @@ void InsTabletNodeZkAdapter::OnLockChange(std::string session_id, bool deleted)
 }
 
 bool InsTabletNodeZkAdapter::GetRootTableAddr(std::string* root_table_addr) {
-    MutexLock locker(&mutex_);
-    std::string root_path = FLAGS_tera_ins_root_path;
-    std::string meta_table = root_path + kRootTabletNodePath;
+    {
+        // watch事件维护的缓存有值就直接用, 不为每次查询打一遍ins
+        MutexLock locker(&mutex_);
+        if (!last_meta_addr_.empty()) {
+            *root_table_addr = last_meta_addr_;
+            return true;
+        }
+    }
+    // 首个事件到来前才走RPC; 放在锁外, mutex_只保护缓存快照而不是网络IO
     galaxy::ins::sdk::SDKError err;
     std::string value;
-    CHECK(ins_sdk_->Get(meta_table, &value, &err));
+    CHECK(ins_sdk_->Get(meta_table_path_, &value, &err));
     *root_table_addr = value;
     return true;
 }
@@ -47,6 +47,11 @@ private:
     bool WatchSelfNode(bool* is_exist, int* zk_code);
     bool WatchRootNode(bool* is_exist, std::string* root_tablet_addr, int* zk_errno);
 
+    // 重挂root节点的watch并发布读到的地址, Init和create/delete回调共用
+    void RewatchRootNode();
+    // 地址未变化时不再打扰下游, 避免空翻转引发的重复meta刷新
+    void PublishRootTabletAddr(const std::string& root_tablet_addr);
+
     void OnSafeModeMarkCreated();
     void OnSafeModeMarkDeleted();
     void OnKickMarkCreated();
@@ -70,6 +75,8 @@ private:
     std::string server_addr_;
     std::string serve_node_path_;
     std::string kick_node_path_;
+    mutable Mutex root_addr_mutex_;
+    std::string last_root_addr_;
 };
 
 class FakeTabletNodeZkAdapter : public TabletNodeZkAdapterBase {
@@ -110,9 +117,13 @@ public:
     virtual void Init();
     virtual bool GetRootTableAddr(std::string* root_table_addr);
     void OnKickMarkCreated();
-    void OnLockChange(std::string session_id, bool deleted);
-    void OnMetaChange(std::string meta_addr, bool deleted);
+    void OnLockChange(const std::string& session_id, bool deleted);
+    void OnMetaChange(const std::string& meta_addr, bool deleted);
 private:
+    // 供Init并发挂watch用, 各挂一个watch并把结果写入*ok
+    void AsyncWatchKick(const std::string& kick_key, bool* ok);
+    void AsyncWatchLock(const std::string& lock_key, bool* ok);
+
     virtual void OnChildrenChanged(const std::string& path,
                                    const std::vector<std::string>& name_list,
                                    const std::vector<std::string>& data_list) {}
@@ -130,6 +141,10 @@ private:
     std::string serve_node_path_;
     std::string kick_node_path_;
     galaxy::ins::sdk::InsSDK* ins_sdk_;
+    // 构造时拼好的meta表路径, 事件回调里直接复用
+    std::string meta_table_path_;
+    // 上次发布给下游的meta地址, 同值事件不重复刷新; mutex_保护
+    std::string last_meta_addr_;
 };
 
 } // namespace tabletnode
@@ -82,6 +82,7 @@ DEFINE_int32(tera_master_connect_timeout_period, 5000, "the timeout period (in m
 DEFINE_int32(tera_master_query_tabletnode_period, 10000, "the period (in ms) for query tabletnode status" );
 DEFINE_int32(tera_master_common_retry_period, 1000, "the period (in ms) for common operation" );
 DEFINE_int32(tera_master_meta_retry_times, 5, "the max retry times when master read/write meta");
+DEFINE_int32(tera_master_meta_write_fuse_max_num, 128, "the max number of meta entries fused into one meta write rpc when replaying suspended operations");
 DEFINE_bool(tera_master_meta_recovery_enabled, false, "whether recovery meta tablet at startup");
 DEFINE_string(tera_master_meta_recovery_file, "../data/meta.bak", "path of meta table recovery file");
 
@@ -93,6 +94,8 @@ DEFINE_int32(tera_master_thread_min_num, 1, "the min thread number of master ser
 DEFINE_int32(tera_master_thread_max_num, 10, "the max thread number of master server");
 DEFINE_int32(tera_master_impl_thread_max_num, 20, "the max thread number for master impl operations");
 DEFINE_int32(tera_master_impl_query_thread_num, 20, "the thread number for master impl query tabletnodes");
+DEFINE_int32(tera_master_impl_query_shard_num, 4, "the number of query thread pool shards; a tabletnode's query callbacks always land on the same shard");
+DEFINE_bool(tera_master_query_direct_submit, false, "run query callbacks inline on the rpc io thread instead of the query thread pool");
 DEFINE_int32(tera_master_impl_retry_times, 5, "the max retry times when master impl operation fail");
 
 DEFINE_string(tera_master_meta_table_name, "meta_table", "the meta table name");
@@ -143,8 +146,10 @@ DEFINE_string(tera_master_stat_table_name, "stat_table", "a specific table for s
 DEFINE_int64(tera_master_stat_table_ttl, 8000000, "default ttl for stat table (s / 100d).");
 DEFINE_int64(tera_master_stat_table_interval, 60, "interval of system status dumping (s)");
 DEFINE_int64(tera_master_stat_table_splitsize, 100, "default split size of stat table");
+DEFINE_int32(tera_master_stat_table_batch_num, 100, "the max number of buffered stat mutations before an early flush; the buffer always flushes when a query sweep ends");
 
 DEFINE_int32(tera_master_gc_period, 60000, "the period (in ms) for master gc");
+DEFINE_int32(tera_master_gc_thread_num, 32, "the thread number for gc to list and delete files");
 
 DEFINE_bool(tera_master_availability_check_enabled, true, "whether execute availability check");    // reload config safety
 DEFINE_bool(tera_master_availability_show_details_enabled, false, "whether show details of not-ready tablets"); // reload config safety
@@ -217,6 +222,8 @@ DEFINE_int64(tera_tabletnode_tcm_cache_size, 838860800, "TCMALLOC_MAX_TOTAL_THRE
 DEFINE_string(tera_sdk_impl_type, "tera", "the activated type of SDK impl");
 DEFINE_int32(tera_sdk_retry_times, 10, "the max retry times during sdk operation fail");
 DEFINE_int32(tera_sdk_retry_period, 500, "the retry period (in ms) between two operations");
+DEFINE_int32(tera_sdk_table_name_cache_timeout, 60, "lifetime (in s) of client-side cached table name resolutions, 0 to disable the cache");
+DEFINE_int32(tera_sdk_meta_cache_ttl_ms, 1000, "lifetime (in ms) of client-side cached table meta records, 0 to disable the cache");
 DEFINE_string(tera_sdk_conf_file, "", "the path of default flag file");
 DEFINE_int32(tera_sdk_show_max_num, 20000, "the max fetch meta number for each rpc connection");
 DEFINE_int32(tera_sdk_async_pending_limit, 2000, "the max number for pending task in async writer");
@@ -239,10 +246,12 @@ DEFINE_int32(tera_sdk_check_timer_internal, 100, "the sdk check the resend quest
 DEFINE_int32(tera_sdk_timeout, 60000, "timeout of sdk read/write request (in ms)");
 DEFINE_int32(tera_sdk_timeout_precision, 10, "precision of sdk read/write timeout detector (in ms)");
 DEFINE_int32(tera_sdk_delay_send_internal, 2, "the sdk resend the request internal time(s)");
+DEFINE_int32(tera_sdk_delay_send_max_internal, 60000, "upper bound of the sdk resend backoff interval (in ms)");
 DEFINE_int32(tera_sdk_scan_buffer_limit, 2048000, "the pack size limit for scan operation");
 DEFINE_bool(tera_sdk_write_sync, false, "sync flag for write");
 DEFINE_int32(tera_sdk_batch_size, 100, "batch_size");
 DEFINE_int32(tera_sdk_write_send_interval, 100, "write batch send interval time");
+DEFINE_int32(tera_sdk_max_inflight_batch_rpc, 0, "max outstanding batched write rpc per tabletnode; size-triggered flushes beyond it keep accumulating, 0 means no limit");
 DEFINE_int32(tera_sdk_read_send_interval, 10, "read batch send interval time");
 DEFINE_int64(tera_sdk_max_mutation_pending_num, INT64_MAX, "default number of pending mutations in async put op");
 DEFINE_int64(tera_sdk_max_reader_pending_num, INT64_MAX, "default number of pending readers in async get op");
@@ -41,6 +41,15 @@ private:
     volatile int64_t val_;
 };
 
+// a Counter alone on its cache line: use it for counters that many
+// threads update concurrently, so writers of adjacent members do not
+// stall each other through false sharing
+#ifdef __GNUC__
+typedef Counter PaddedCounter __attribute__((aligned(64)));
+#else
+typedef Counter PaddedCounter;
+#endif
+
 class AutoCounter {
 public:
     AutoCounter(Counter* counter, const char* msg1, const char* msg2 = NULL)
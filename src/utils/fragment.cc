@@ -23,13 +23,11 @@ static int CompareTwoEndKey(const std::string& a, const std::string& b) {
 }
 
 bool RangeFragment::IsCoverRange(const std::string& start, const std::string& end) const {
-    std::list<std::pair<std::string, std::string> >::const_iterator it=range_.begin();
-    for ( ; it != range_.end(); ++it ) {
-        if (it->second != ""
-            && start.compare(it->second) > 0) {
-            continue;
-        }
-        break;
+    RangeList::const_iterator it = range_.begin();
+    while (it != range_.end()
+           && it->second != ""
+           && start.compare(it->second) > 0) {
+        ++it;
     }
 
     if (it == range_.end()) {
@@ -43,13 +41,11 @@ bool RangeFragment::AddToRange(const std::string& start, const std::string& end)
     if (end != "" && start.compare(end) > 0) {
         return false;
     }
-    std::list<std::pair<std::string, std::string> >::iterator it=range_.begin();
-    for ( ; it != range_.end(); ++it ) {
-        if (it->second != ""
-            && start.compare(it->second) > 0) {
-            continue;
-        }
-        break;
+    RangeList::iterator it = range_.begin();
+    while (it != range_.end()
+           && it->second != ""
+           && start.compare(it->second) > 0) {
+        ++it;
     }
     if (it == range_.end()) {
         range_.push_back(std::pair<std::string, std::string>(start, end));
@@ -77,21 +73,26 @@ bool RangeFragment::AddToRange(const std::string& start, const std::string& end)
      */
     std::string new_start = start.compare(it->first) < 0 ? start : it->first;
     std::string new_end = end;
-    while (it != range_.end()) {
-        if (end == ""
-            || end.compare(it->first) >= 0 ) {
-            new_end = CompareTwoEndKey(end, it->second) > 0 ? end : it->second;
-            it = range_.erase(it);
-            continue;
-        }
-        break;
+    RangeList::iterator last = it;
+    while (last != range_.end()
+           && (end == "" || end.compare(last->first) >= 0)) {
+        new_end = CompareTwoEndKey(end, last->second) > 0 ? end : last->second;
+        ++last;
+    }
+    if (it == last) {
+        range_.insert(it, std::pair<std::string, std::string>(new_start, new_end));
+    } else {
+        // reuse the first overlapped slot and drop the rest in one
+        // shot instead of erasing node by node
+        it->first.swap(new_start);
+        it->second.swap(new_end);
+        range_.erase(it + 1, last);
     }
-    range_.insert(it, std::pair<std::string, std::string>(new_start, new_end));
     return true;
 }
 
 std::string RangeFragment::DebugString() const {
-    std::list<std::pair<std::string, std::string> >::const_iterator it = range_.begin();
+    RangeList::const_iterator it = range_.begin();
     std::stringstream ss;
     for (; it != range_.end(); ++it) {
         ss << it->first << ":" << it->second << " ";
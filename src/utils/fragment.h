@@ -5,8 +5,8 @@
 #ifndef  TERA_FRAGMENT_UTIL_H_
 #define  TERA_FRAGMENT_UTIL_H_
 
-#include <list>
 #include <string>
+#include <vector>
 
 namespace tera {
 
@@ -23,7 +23,12 @@ public:
     std::string DebugString() const;
 
 private:
-    std::list<std::pair<std::string, std::string> > range_;
+    typedef std::vector<std::pair<std::string, std::string> > RangeList;
+
+    // sorted, non-overlapping fragments; a vector so the scans in
+    // AddToRange/IsCoverRange stream contiguous memory, and the
+    // fragment count stays tiny because touching ranges merge
+    RangeList range_;
 };
 
 } // namespace tera